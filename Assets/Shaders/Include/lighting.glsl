@@ -0,0 +1,35 @@
+#pragma once
+
+uniform vec4  lightPosition;
+uniform float lightRadius;
+uniform vec3  lightColour;
+uniform vec3  lightDirection;
+uniform float lightAngle;
+
+// Find the direction towards the light, and its attenuation, at worldPos.
+// Returns false if worldPos is outside the light's radius or cone.
+bool computeLight(vec3 worldPos, out vec3 incident, out float attenuation) {
+    attenuation = 1.0;
+    if (lightPosition.w == 0.0) { // Directional Light
+        incident = normalize(lightDirection);
+        return true;
+    }
+    // Point/Spot Light
+    incident = normalize(lightPosition.xyz - worldPos);
+    if (lightAngle > 0.0 && degrees(acos(dot(-incident, lightDirection))) > lightAngle)
+        return false;
+    vec3 dist = lightPosition.xyz - worldPos;
+    float distSquared = dot(dist, dist);
+    if (distSquared > lightRadius * lightRadius)
+        return false;
+    attenuation = 1.0 / sqrt(distSquared);
+    return true;
+}
+
+void blinnPhong(vec3 incident, vec3 normal, vec3 viewDir, out float lambert, out float specFactor) {
+    vec3 halfDir = normalize(incident + viewDir);
+
+    lambert = clamp(dot(incident, normal), 0.0, 1.0);
+    float rFactor = clamp(dot(halfDir, normal),  0.0, 1.0);
+    specFactor = pow(rFactor, 60.0);
+}
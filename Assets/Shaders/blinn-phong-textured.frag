@@ -1,11 +1,7 @@
 #version 460 core
 uniform sampler2D albedoTex;
 
-uniform vec4 lightPosition;
-uniform float lightRadius;
-uniform vec3 lightColour;
-uniform vec3 lightDirection;
-uniform float lightAngle;
+#include "Include/lighting.glsl"
 
 uniform vec3 lightAmbient = vec3(0.0);
 
@@ -22,29 +18,14 @@ out vec4 fragColour;
 void main() {
     vec3 incident;
     float attenuation;
-    if (lightPosition.w == 0.0) {
-        incident = normalize(lightDirection);
-        attenuation = 1.0;
-    } else {
-        incident = normalize(lightPosition.xyz - IN.worldPos);
-        if (lightAngle > 0.0 && degrees(acos(dot(-incident, lightDirection))) > lightAngle){
-            attenuation = 0.0;
-        } else {
-            vec3 dist = lightPosition.xyz - IN.worldPos;
-            float distSquared = dot(dist, dist);
-            if (distSquared > lightRadius * lightRadius)
-            attenuation = 0.0;
-            else
-            attenuation = 1.0 / sqrt(distSquared);
-        }
-    }
+    if (!computeLight(IN.worldPos, incident, attenuation))
+        attenuation = 0.0;
 
     vec3 viewDir = normalize(cameraPos - IN.worldPos);
-    vec3 halfDir = normalize(incident + viewDir);
 
-    float lambert = clamp(dot(incident, IN.normal), 0.0, 1.0);
-    float rFactor = clamp(dot(halfDir, IN.normal),  0.0, 1.0);
-    float specFactor = pow(rFactor, 60.0);
+    float lambert;
+    float specFactor;
+    blinnPhong(incident, IN.normal, viewDir, lambert, specFactor);
 
     vec3 attenuated = lightColour * attenuation;
 
@@ -9,11 +9,7 @@ uniform mat4 projMatrix;
 uniform vec2 pixelSize;
 uniform vec3 cameraPos;
 
-uniform vec4  lightPosition;
-uniform float lightRadius;
-uniform vec3  lightColour;
-uniform vec3  lightDirection;
-uniform float lightAngle;
+#include "Include/lighting.glsl"
 
 out vec4 diffuseOut;
 out vec4 specularOut;
@@ -29,29 +25,15 @@ void main() {
 
     vec3 incident;
     float attenuation;
-    if (lightPosition.w == 0.0) { // Directional Light
-        incident = normalize(lightDirection);
-        attenuation = 1.0;
-    } else {                      // Point/Spot Light
-        incident = normalize(lightPosition.xyz - worldPos);
-        if (lightAngle > 0.0 && degrees(acos(dot(-incident, lightDirection))) > lightAngle)
-            discard;
-        vec3 dist = lightPosition.xyz - worldPos;
-        float distSquared = dot(dist, dist);
-        if (distSquared > lightRadius * lightRadius)
-            discard;
-        attenuation = 1.0 / sqrt(distSquared);
-        if (attenuation <= 0.0)
-            discard;
-    }
+    if (!computeLight(worldPos, incident, attenuation) || attenuation <= 0.0)
+        discard;
 
     vec3 normal = normalize(texture(normalTex, uv).xyz * 2.0 - 1.0);
     vec3 viewDir = normalize(cameraPos - worldPos);
-    vec3 halfDir = normalize(incident + viewDir);
 
-    float lambert = clamp(dot(incident, normal), 0.0, 1.0);
-    float rFactor = clamp(dot(halfDir, normal),  0.0, 1.0);
-    float specFactor = pow(rFactor, 60.0);
+    float lambert;
+    float specFactor;
+    blinnPhong(incident, normal, viewDir, lambert, specFactor);
 
     vec3 attenuated = lightColour * attenuation;
 
@@ -0,0 +1,535 @@
+#include "Analysis.h"
+
+#include "Assets.h"
+#include "PipelineGraph.h"
+
+#include "../NodeEditor/GraphFormat.h"
+#include "../NodeEditor/Ports.h"
+
+#include "../Rendering/Mesh.h"
+#include "../Rendering/Renderer.h"
+#include "../Rendering/Shader.h"
+
+#include "../Utils/FileUtils.h"
+#include "../Utils/MeshUtils.h"
+#include "../Utils/ProfileUtils.h"
+#include "../Utils/SerializationUtils.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <any>
+#include <cstdio>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static void writeSyntheticNode(std::ostream& stream, const std::string& type, int& nextID,
+                               const std::vector<std::pair<std::string, std::string>>& data,
+                               const std::vector<std::pair<std::string, int>>& inPorts,
+                               const std::vector<std::pair<std::string, int>>& outPorts) {
+    SerializationUtils::writeBeginMark(stream, "Node");
+    SerializationUtils::writeDataPoint(stream, '^', "NodeType", type);
+    SerializationUtils::writeDataPoint(stream, '-', "NodeID", std::to_string(nextID++));
+    SerializationUtils::writeDataPoint(stream, '-', "NodeName", type);
+    for (const auto& port : inPorts)
+        SerializationUtils::writeDataPoint(stream, '-', "InPort", port.first + " " + std::to_string(port.second));
+    for (const auto& port : outPorts)
+        SerializationUtils::writeDataPoint(stream, '-', "OutPort", port.first + " " + std::to_string(port.second));
+    SerializationUtils::writeBeginMark(stream, "Data");
+    for (const auto& dataPoint : data)
+        SerializationUtils::writeDataPoint(stream, '-', dataPoint.first, dataPoint.second);
+    SerializationUtils::writeEndMark(stream, "Data");
+    SerializationUtils::writeEndMark(stream, "Node");
+}
+
+/**
+ * @brief Generate a graph made up of clusters of four nodes: two floats feeding an arithmetic node, which in turn
+ * feeds a second arithmetic node. The dependent arithmetic node is written first, so its links cannot be resolved
+ * until the ports of the node after it have been created.
+ */
+static std::string generateArithmeticGraph(std::size_t numNodes) {
+    std::stringstream stream;
+    stream << 0 << "\n";
+
+    int nextID = 1;
+    for (std::size_t i = 0; i + 4 <= numNodes; i += 4) {
+        int floatA = nextID++, floatB = nextID++, resultA = nextID++, resultB = nextID++;
+
+        writeSyntheticNode(stream, "Arithmetic", nextID, {{"Operation", "2"}},
+                           {{"ValueAIn", resultA}, {"ValueBIn", floatB}}, {{"ValueOut", resultB}});
+        writeSyntheticNode(stream, "Arithmetic", nextID, {{"Operation", "0"}},
+                           {{"ValueAIn", floatA}, {"ValueBIn", floatB}}, {{"ValueOut", resultA}});
+        writeSyntheticNode(stream, "Float", nextID, {{"Value", "1.0"}}, {}, {{"ValueOut", floatA}});
+        writeSyntheticNode(stream, "Float", nextID, {{"Value", "2.0"}}, {}, {{"ValueOut", floatB}});
+    }
+    return stream.str();
+}
+
+void Analysis::profileLinkRestore(IPipelineHandler& pipelineHandler, std::size_t numNodes) {
+    std::string contents = generateArithmeticGraph(numNodes);
+
+    PipelineGraph graph(pipelineHandler);
+    graph.deserialize(contents);
+
+    const Graph::LoadStats& stats = graph.getLoadStats();
+    ProfileUtils::setResult(std::string("Link Restore (").append(std::to_string(stats.numNodes)).append(" nodes)"),
+                            ProfileUtils::formatTime(stats.linkTime).append(" | ")
+                                .append(std::to_string(stats.numLinks)).append(" links | parse ")
+                                .append(ProfileUtils::formatTime(stats.parseTime)));
+}
+
+void Analysis::profileGraphInteraction(IPipelineHandler& pipelineHandler, std::size_t numNodes) {
+    static constexpr std::size_t cMAX_LINKS = 1000;
+    // Scanning is far slower, so is only sampled over the first few links
+    static constexpr std::size_t cMAX_SCANS = 50;
+
+    PipelineGraph graph(pipelineHandler);
+    graph.deserialize(generateArithmeticGraph(numNodes));
+
+    // Second inputs of arithmetic nodes do not add or remove ports when (un)linked, so can be relinked by ID
+    struct LinkSample {
+        int linkID;
+        int portInID;
+        int portOutID;
+    };
+    std::vector<LinkSample> samples{};
+    for (std::size_t i = 0; i < graph.getNumNodes() && samples.size() < cMAX_LINKS; i++) {
+        IPort* port = graph.getNodeByIndex(i).getPortByName("ValueBIn");
+        if (port && port->isLinked())
+            samples.push_back({port->getLinkID(0), port->getID(), port->getLinkedPortID(0)});
+    }
+    if (samples.empty())
+        return;
+
+    const ProfileUtils::milliseconds_t unlinkTime = ProfileUtils::time([&]() {
+        for (const LinkSample& sample : samples)
+            graph.unlinkPorts(sample.linkID);
+    });
+    const ProfileUtils::milliseconds_t linkTime = ProfileUtils::time([&]() {
+        for (const LinkSample& sample : samples)
+            graph.linkPorts(sample.portInID, sample.portOutID);
+    });
+
+    const std::size_t numScans = std::min(samples.size(), cMAX_SCANS);
+    IPort* found = nullptr;
+    const ProfileUtils::milliseconds_t scanTime = ProfileUtils::time([&]() {
+        for (std::size_t k = 0; k < numScans; k++) {
+            const LinkSample& sample = samples[k];
+            for (std::size_t i = 0; i < graph.getNumNodes(); i++) {
+                Node& node = graph.getNodeByIndex(i);
+                for (std::size_t j = 0; j < node.numPorts(); j++)
+                    if (node.getPortByIndex(j).getID() == sample.portOutID)
+                        found = &node.getPortByIndex(j);
+            }
+        }
+    });
+    const ProfileUtils::milliseconds_t indexTime = ProfileUtils::time([&]() {
+        for (const LinkSample& sample : samples)
+            found = graph.findPort(sample.portOutID);
+    });
+    (void)found;
+
+    const auto formatPerInteraction = [](ProfileUtils::milliseconds_t time, std::size_t count) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.2f us", 1000.0f * time.count() / (float)count);
+        return std::string(buffer);
+    };
+    ProfileUtils::setResult(std::string("Graph Interaction (").append(std::to_string(graph.getNumNodes()))
+                                .append(" nodes)"),
+                            std::string("unlink ").append(formatPerInteraction(unlinkTime, samples.size()))
+                                .append(" | link ").append(formatPerInteraction(linkTime, samples.size()))
+                                .append(" | port lookup ").append(formatPerInteraction(indexTime, samples.size()))
+                                .append(" (scan ").append(formatPerInteraction(scanTime, numScans)).append(")"));
+}
+
+void Analysis::profileGraphMemory(IPipelineHandler& pipelineHandler, std::size_t numNodes) {
+    PipelineGraph graph(pipelineHandler);
+    graph.deserialize(generateArithmeticGraph(numNodes));
+
+    const Graph::MemoryStats stats = graph.getMemoryStats();
+
+    // Accumulated so neither pass can be optimised out
+    std::size_t numVisited = 0;
+    const ProfileUtils::milliseconds_t walkTime = ProfileUtils::time([&]() {
+        for (std::size_t i = 0; i < graph.getNumNodes(); i++) {
+            Node& node = graph.getNodeByIndex(i);
+            for (std::size_t j = 0; j < node.numPorts(); j++) {
+                const IPort& port = node.getPortByIndex(j);
+                if (port.getDirection() != IPort::Direction::In)
+                    continue;
+                for (std::size_t k = 0; k < port.getNumLinks(); k++)
+                    numVisited += (std::size_t)(port.getLinkID(k) ^ port.getLinkedPortID(k) ^ port.getID()) & 1;
+            }
+        }
+    });
+    const Graph::LinkTable& links = graph.getLinkTable();
+    const ProfileUtils::milliseconds_t tableTime = ProfileUtils::time([&]() {
+        for (std::size_t i = 0; i < links.size(); i++)
+            numVisited += (std::size_t)(links.ids[i] ^ links.startPortIDs[i] ^ links.endPortIDs[i]) & 1;
+    });
+    volatile std::size_t sink = numVisited;
+    (void)sink;
+
+    const auto formatBytes = [](std::size_t bytes) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.2f MB", (float)bytes / (1024.0f * 1024.0f));
+        return std::string(buffer);
+    };
+    ProfileUtils::setResult(std::string("Graph Memory (").append(std::to_string(stats.numNodes)).append(" nodes)"),
+                            formatBytes(stats.getTotalBytes()).append(" | ")
+                                .append(std::to_string(stats.getTotalBytes() / std::max(stats.numNodes, (size_t)1)))
+                                .append(" B/node | nodes ").append(formatBytes(stats.nodeBytes))
+                                .append(" | tables ").append(formatBytes(stats.tableBytes))
+                                .append(" | shared names ").append(formatBytes(stats.nameBytes))
+                                .append(" | ").append(std::to_string(stats.numPorts)).append(" ports, ")
+                                .append(std::to_string(stats.numLinks)).append(" links | link pass ")
+                                .append(ProfileUtils::formatTime(tableTime)).append(" (node walk ")
+                                .append(ProfileUtils::formatTime(walkTime)).append(")"));
+}
+
+/**
+ * @brief Node holding an output linked to its own input, for timing value transport between ports in isolation.
+ */
+template<typename T>
+class PortBenchmarkNode final : public Node {
+public:
+    PortBenchmarkNode() : Node("Port Benchmark") {
+        addPort(mValueIn);
+        addPort(mValueOut);
+        mValueIn.link(mValueOut);
+    }
+
+    [[nodiscard]] unsigned int getTypeID() const final {
+        return 0;
+    }
+
+    T mValue{};
+
+    Port<T> mValueIn = Port<T>(*this, IPort::Direction::In, "ValueIn", "In");
+    Port<T> mValueOut = Port<T>(*this, IPort::Direction::Out, "ValueOut", "Out", [&]() { return mValue; });
+protected:
+    [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final {
+        return {};
+    }
+    void deserializeData(const std::string&, std::istream&) final {}
+
+    void drawContents() final {}
+};
+
+void Analysis::profilePortValues(std::size_t numReads) {
+    PortBenchmarkNode<glm::mat4> node;
+    node.mValue = glm::mat4(1.0f);
+
+    // Accumulated so the reads cannot be optimised out
+    glm::mat4 sum(0.0f);
+    const ProfileUtils::milliseconds_t typedTime = ProfileUtils::time([&]() {
+        for (std::size_t i = 0; i < numReads; i++)
+            sum += node.mValueIn.getLinkedValue<glm::mat4>();
+    });
+    // Previous transport, boxing the source value into a std::any and unboxing it with std::any_cast
+    const ProfileUtils::milliseconds_t anyTime = ProfileUtils::time([&]() {
+        for (std::size_t i = 0; i < numReads; i++) {
+            const std::any boxed = std::visit([](const auto& arg)->std::any { return arg; }, node.mValueOut.getValue());
+            sum += *std::any_cast<glm::mat4>(&boxed);
+        }
+    });
+    volatile float sink = sum[0][0];
+    (void)sink;
+
+    const auto formatPerRead = [numReads](ProfileUtils::milliseconds_t time) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.1f ns/read", 1000000.0f * time.count() / (float)numReads);
+        return std::string(buffer);
+    };
+    ProfileUtils::setResult(std::string("Port Values (").append(std::to_string(numReads)).append(" mat4 reads)"),
+                            std::string("typed ").append(formatPerRead(typedTime))
+                                .append(" | std::any ").append(formatPerRead(anyTime)));
+}
+
+void Analysis::profileGraphFormats(const std::filesystem::path& filepath, std::size_t numCopies) {
+    MappedFile file(filepath);
+    SerialGraph source;
+    if (!file.isOpen() || !GraphFormat::read(file.view(), source))
+        return;
+
+    int idRange = 0;
+    for (const SerialNode& node : source.nodes) {
+        idRange = std::max(idRange, node.id);
+        for (const SerialPort& port : node.ports)
+            idRange = std::max({idRange, port.id, port.linkedID});
+    }
+    idRange++;
+
+    SerialGraph scaled;
+    scaled.id = source.id;
+    scaled.nodes.reserve(source.nodes.size() * numCopies);
+    for (std::size_t i = 0; i < numCopies; i++) {
+        const int offset = (int)i * idRange;
+        for (SerialNode node : source.nodes) {
+            node.id += offset;
+            for (SerialPort& port : node.ports) {
+                if (port.id >= 0)
+                    port.id += offset;
+                if (port.linkedID >= 0)
+                    port.linkedID += offset;
+            }
+            scaled.nodes.push_back(std::move(node));
+        }
+    }
+
+    std::stringstream textStream, binaryStream;
+    GraphFormat::writeText(textStream, scaled);
+    GraphFormat::writeBinary(binaryStream, scaled);
+    const std::string text = textStream.str(), binary = binaryStream.str();
+
+    const auto timeRead = [](const std::string& contents) {
+        return ProfileUtils::time([&]() {
+            SerialGraph graph;
+            GraphFormat::read(contents, graph);
+        });
+    };
+    const auto formatSize = [](std::size_t size) {
+        return std::to_string(size / 1024).append(" KiB");
+    };
+
+    const std::string label = std::string("Graph Formats (").append(std::to_string(scaled.nodes.size()))
+        .append(" nodes)");
+    ProfileUtils::setResult(label, std::string("text ").append(ProfileUtils::formatTime(timeRead(text)))
+                                       .append(" / ").append(formatSize(text.size()))
+                                       .append(" | binary ").append(ProfileUtils::formatTime(timeRead(binary)))
+                                       .append(" / ").append(formatSize(binary.size())));
+}
+
+/**
+ * @brief Generate a square grid of (at least) numFaces triangles, with positions, uvs and normals.
+ */
+static std::string generateOBJGrid(std::size_t numFaces) {
+    std::size_t numQuads = 1;
+    while (numQuads * numQuads * 2 < numFaces)
+        numQuads++;
+
+    std::string contents;
+    contents.reserve(numFaces * 64);
+    char buffer[128];
+    for (std::size_t y = 0; y <= numQuads; y++) {
+        for (std::size_t x = 0; x <= numQuads; x++) {
+            float u = (float)x / (float)numQuads, v = (float)y / (float)numQuads;
+            contents.append(buffer, std::snprintf(buffer, sizeof(buffer), "v %f %f %f\nvt %f %f\nvn 0 0 1\n",
+                                                  u, v, 0.1f * (float)((x + y) % 8), u, v));
+        }
+    }
+    std::size_t rowSize = numQuads + 1;
+    for (std::size_t y = 0; y < numQuads; y++) {
+        for (std::size_t x = 0; x < numQuads; x++) {
+            std::size_t a = y * rowSize + x + 1, b = a + 1, c = a + rowSize, d = c + 1;
+            contents.append(buffer, std::snprintf(buffer, sizeof(buffer), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n",
+                                                  a, a, a, b, b, b, d, d, d));
+            contents.append(buffer, std::snprintf(buffer, sizeof(buffer), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n",
+                                                  a, a, a, d, d, d, c, c, c));
+        }
+    }
+    return contents;
+}
+
+/**
+ * @brief The stream based OBJ parser previously used by MeshNode, kept as the baseline for profileOBJImport().
+ * @brief Unlike the original, the line following each face is no longer skipped, so both parsers read every face.
+ * @returns Number of triangle corners read.
+ */
+static std::size_t loadOBJReference(std::istream& stream) {
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> texIndices;
+    std::vector<unsigned int> normIndices;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvsSoft;
+    std::vector<glm::vec3> normalsSoft;
+
+    const auto triangulate = [](const std::vector<unsigned int>& face, std::vector<unsigned int>& out) {
+        if (face.size() <= 3) {
+            out.insert(out.end(), face.begin(), face.end());
+            return;
+        }
+        for (std::size_t i = 2; i < face.size(); i++) {
+            out.push_back(face[0]);
+            out.push_back(face[i - 1]);
+            out.push_back(face[i    ]);
+        }
+    };
+
+    while (!stream.eof()) {
+        std::string type;
+        stream >> type;
+        if (type == "v") {
+            glm::vec3 vertex;
+            stream >> vertex.x >> vertex.y >> vertex.z;
+            positions.emplace_back(vertex);
+        } else if (type == "vt") {
+            glm::vec2 uv;
+            stream >> uv.x >> uv.y;
+            uvsSoft.emplace_back(uv);
+        } else if (type == "vn") {
+            glm::vec3 normal;
+            stream >> normal.x >> normal.y >> normal.z;
+            normalsSoft.emplace_back(normal);
+        } else if (type == "f") {
+            std::stringstream indexSetStream(SerializationUtils::readLine(stream));
+            indexSetStream >> std::ws;
+
+            std::string indexSet;
+            std::vector<unsigned int> tempVis, tempTis, tempNis;
+            while (std::getline(indexSetStream, indexSet, ' ')) {
+                std::stringstream indexStream(indexSet);
+                int vi, ti, ni;
+                char sep;
+                indexStream >> vi;
+                tempVis.push_back(vi < 0 ? positions.size() + vi : vi - 1);
+                if (indexStream.peek() != '/')
+                    continue;
+                indexStream >> sep;
+                if (indexStream.peek() != '/') {
+                    indexStream >> ti;
+                    tempTis.push_back(ti < 0 ? uvsSoft.size() + ti : ti - 1);
+                }
+                if (indexStream.peek() != '/')
+                    continue;
+                indexStream >> sep >> ni;
+                tempNis.push_back(ni < 0 ? normalsSoft.size() + ni : ni - 1);
+            }
+            triangulate(tempVis, indices);
+            triangulate(tempTis, texIndices);
+            triangulate(tempNis, normIndices);
+            continue;
+        }
+        SerializationUtils::skipToNextLine(stream);
+    }
+    return indices.size();
+}
+
+void Analysis::profileOBJImport(std::size_t numFaces) {
+    const std::string contents = generateOBJGrid(numFaces);
+
+    std::size_t numReferenceCorners = 0;
+    ProfileUtils::milliseconds_t referenceTime = ProfileUtils::time([&]() {
+        std::stringstream stream(contents);
+        numReferenceCorners = loadOBJReference(stream);
+    });
+
+    std::size_t numCorners = 0;
+    const auto timeLoad = [&contents, &numCorners](unsigned int numThreads) {
+        return ProfileUtils::time([&]() {
+            MeshUtils::OBJData data;
+            MeshUtils::loadOBJ(contents, data, numThreads);
+            numCorners = data.corners.size();
+        });
+    };
+    ProfileUtils::milliseconds_t singleTime = timeLoad(1);
+    ProfileUtils::milliseconds_t parallelTime = timeLoad(0);
+
+    const unsigned int numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    ProfileUtils::setResult(std::string("OBJ Import (").append(std::to_string(numCorners / 3)).append(" faces)"),
+                            std::string("stream ").append(ProfileUtils::formatTime(referenceTime))
+                                .append(" | 1 thread ").append(ProfileUtils::formatTime(singleTime))
+                                .append(" | ").append(std::to_string(numThreads)).append(" threads ")
+                                .append(ProfileUtils::formatTime(parallelTime))
+                                .append(numReferenceCorners == numCorners ? "" : " | MISMATCH"));
+}
+
+/**
+ * @brief Pass callback as generated by RenderPassNode before pipelines were compiled to a CommandBuffer, kept as the
+ * baseline for profilePipelineSubmission().
+ */
+static std::function<void()> generatePassCallbackReference(const Shader* shader, const Mesh* mesh,
+                                                           const CommandBuffer::RenderState& state) {
+    std::vector<std::function<void()>> passCallbacks{};
+
+    passCallbacks.emplace_back([shader]() { shader->bind(); });
+
+    passCallbacks.emplace_back([state]() {
+        RenderConfig::setViewport((int)state.viewport.x, (int)state.viewport.y,
+                                  (unsigned int)state.viewport.z, (unsigned int)state.viewport.w);
+        RenderConfig::setBlend(state.enableBlend, state.blendFuncSrc, state.blendFuncDst);
+        RenderConfig::setColourMask(state.colourMask.r, state.colourMask.g, state.colourMask.b, state.colourMask.a);
+        RenderConfig::setCullFace(state.enableFaceCulling, state.cullFaceMode);
+        RenderConfig::setDepthTest(state.enableDepthTest, state.depthTestFunc, state.depthTestLimits.x,
+                                   state.depthTestLimits.y);
+        RenderConfig::setDepthMask(state.enableDepthMask);
+    });
+
+    passCallbacks.emplace_back([mesh]() {
+        mesh->bind();
+        mesh->draw();
+    });
+
+    return [passCallbacks]() {
+        for (const auto& callback : passCallbacks)
+            callback();
+    };
+}
+
+void Analysis::profilePipelineSubmission(std::size_t numPasses) {
+    constexpr std::size_t cNUM_FRAMES = 20;
+
+    Mesh quad;
+    Mesh::makeScreenQuad(quad);
+
+    std::string vertCode, fragCode;
+    SerializationUtils::readFile(getShaderAssetDirectory() / "simple-quad.vert", vertCode);
+    SerializationUtils::readFile(getShaderAssetDirectory() / "simple-quad.frag", fragCode);
+    Shader shader(vertCode, fragCode);
+    shader.waitForCompile();
+
+    // Draw to a single pixel, so the GPU cost of each pass is negligible
+    CommandBuffer::RenderState state;
+    state.viewport = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    state.enableFaceCulling = false;
+
+    std::vector<std::function<void()>> callbacks;
+    CommandBuffer commands;
+    for (std::size_t i = 0; i < numPasses; i++) {
+        callbacks.push_back(generatePassCallbackReference(&shader, &quad, state));
+
+        commands.useProgram(shader);
+        commands.setState(state);
+        commands.bindVAO(quad);
+        commands.draw(quad);
+    }
+
+    const auto timeFrames = [](const std::function<void()>& submit) {
+        ProfileUtils::milliseconds_t total{0};
+        for (std::size_t frame = 0; frame < cNUM_FRAMES; frame++) {
+            total += ProfileUtils::time(submit);
+            glFinish();
+        }
+        return total / (float)cNUM_FRAMES;
+    };
+    ProfileUtils::milliseconds_t callbackTime = timeFrames([&callbacks]() {
+        for (const auto& pass : callbacks)
+            pass();
+    });
+    RenderConfig::resetStateStats();
+    ProfileUtils::milliseconds_t commandTime = timeFrames([&commands]() {
+        Renderer::executeCommands(commands);
+    });
+    const RenderConfig::StateStats stateStats = RenderConfig::getStateStats();
+
+    Shader::unbind();
+    Mesh::unbind();
+    RenderConfig::setViewport();
+    RenderConfig::setCullFace();
+
+    const auto formatPerPass = [numPasses](ProfileUtils::milliseconds_t time) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.2f us/pass", 1000.0f * time.count() / (float)numPasses);
+        return std::string(buffer);
+    };
+    ProfileUtils::setResult(std::string("Pipeline Submission (").append(std::to_string(numPasses)).append(" passes)"),
+                            std::string("callbacks ").append(ProfileUtils::formatTime(callbackTime))
+                                .append(" / ").append(formatPerPass(callbackTime))
+                                .append(" | commands ").append(ProfileUtils::formatTime(commandTime))
+                                .append(" / ").append(formatPerPass(commandTime))
+                                .append(" | state changes/frame ")
+                                .append(std::to_string(stateStats.issued / cNUM_FRAMES)).append(" issued, ")
+                                .append(std::to_string(stateStats.elided / cNUM_FRAMES)).append(" elided"));
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+
+class IPipelineHandler;
+
+/**
+ * @brief In-app profiling scenarios, run from the Analysis menu. Results are reported through ProfileUtils.
+ */
+class Analysis {
+public:
+    /**
+     * @brief Deserialize a synthetic graph of numNodes numeric/arithmetic nodes, and report the time taken to
+     * restore its links.
+     * @brief Arithmetic nodes create their remaining ports on link, so most links depend on dynamically created ports.
+     */
+    static void profileLinkRestore(IPipelineHandler& pipelineHandler, std::size_t numNodes);
+    /**
+     * @brief Deserialize the same synthetic graph as profileLinkRestore(), then break and re-create links by ID as the
+     * editor does, and report the average latency of each interaction. Also reports the time a lookup would take by
+     * scanning every port of every node, as was done before the graph kept an index.
+     */
+    static void profileGraphInteraction(IPipelineHandler& pipelineHandler, std::size_t numNodes);
+    /**
+     * @brief Deserialize the same synthetic graph as profileLinkRestore(), and report its memory footprint (see
+     * Graph::getMemoryStats()) along with the time taken to gather the IDs of every link as Graph::drawEditor() does,
+     * from the graph's link table and by walking the input ports of every node as was done before the table existed.
+     */
+    static void profileGraphMemory(IPipelineHandler& pipelineHandler, std::size_t numNodes);
+    /**
+     * @brief Read a glm::mat4 through a linked pair of ports numReads times, and report the time taken per read
+     * through the typed value transport and through the previous std::any round trip.
+     */
+    static void profilePortValues(std::size_t numReads);
+    /**
+     * @brief Scale the graph at filepath up to numCopies disjoint copies of itself, and report the time taken to read
+     * it back in each of the text and binary formats, along with the size of each.
+     */
+    static void profileGraphFormats(const std::filesystem::path& filepath, std::size_t numCopies);
+    /**
+     * @brief Generate a synthetic OBJ grid of numFaces triangles, and report the time taken to import it through the
+     * previous stream based parser and through MeshUtils::loadOBJ() (both single and multi-threaded).
+     */
+    static void profileOBJImport(std::size_t numFaces);
+    /**
+     * @brief Build a synthetic pipeline of numPasses render passes, both as the previous nested callbacks and as a
+     * CommandBuffer, and report the CPU time taken to submit each per pass.
+     */
+    static void profilePipelineSubmission(std::size_t numPasses);
+};
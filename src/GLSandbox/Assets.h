@@ -19,10 +19,15 @@
     static const std::filesystem::path cDIRECTORY = "Textures";
     return cDIRECTORY;
 }
+[[nodiscard]] static std::filesystem::path getShaderCacheDirectory() {
+    static const std::filesystem::path cDIRECTORY = "ShaderCache";
+    return cDIRECTORY;
+}
 
 [[nodiscard]] static const std::vector<std::string>& getValidGraphFileExtensions() {
     static const std::vector<std::string> cEXTENSIONS = {
-        "graph",
+        "graph,graphb",
+        "graph", "graphb",
     };
     return cEXTENSIONS;
 }
@@ -77,8 +82,8 @@ static inline const std::vector<std::string>& getValidGeometryShaderFileExtensio
 
 [[nodiscard]] static const std::vector<std::string>& getValidMeshFileExtensions() {
     static const std::vector<std::string> cEXTENSIONS = {
-        "msh,obj",
-        "msh", "obj",
+        "msh,mshb,obj",
+        "msh", "obj", "mshb",
     };
     return cEXTENSIONS;
 }
@@ -92,10 +97,18 @@ static inline const std::vector<std::string>& getValidGeometryShaderFileExtensio
 }
 
 [[nodiscard]] static const std::string& getGraphDefaultExtension() {
-    static const std::string cEXTENSION = getValidGraphFileExtensions()[0];
+    static const std::string cEXTENSION = getValidGraphFileExtensions()[1];
+    return cEXTENSION;
+}
+[[nodiscard]] static const std::string& getGraphBinaryExtension() {
+    static const std::string cEXTENSION = getValidGraphFileExtensions()[2];
     return cEXTENSION;
 }
 [[nodiscard]] static const std::string& getMeshDefaultExtension() {
     static const std::string cEXTENSION = getValidMeshFileExtensions()[1];
     return cEXTENSION;
 }
+[[nodiscard]] static const std::string& getMeshBinaryExtension() {
+    static const std::string cEXTENSION = getValidMeshFileExtensions()[3];
+    return cEXTENSION;
+}
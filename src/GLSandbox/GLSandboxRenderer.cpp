@@ -1,12 +1,22 @@
 #include "GLSandboxRenderer.h"
 
+#include "Assets.h"
+
+#include "../Rendering/PassProfiler.h"
+#include "../Rendering/ProgramCache.h"
+#include "../Rendering/RenderConfig.h"
+#include "../Rendering/ShaderPreprocessor.h"
+
+#include "../Utils/ProfileUtils.h"
 #include "../Utils/SerializationUtils.h"
 
 #include <glad/glad.h>
 
 #include <imgui.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <ctime>
 
 std::vector<std::string> GLSandboxRenderer::sDebugMessages{};
@@ -16,6 +26,9 @@ GLSandboxRenderer::GLSandboxRenderer() : Renderer() {
     mQuad = std::make_unique<Mesh>();
     Mesh::makeScreenQuad(*mQuad);
 
+    ProgramCache::setDirectory(getShaderCacheDirectory());
+    ShaderPreprocessor::setIncludeDirectory(getShaderAssetDirectory());
+
     std::string defaultVertCode;
     SerializationUtils::readFile("Shaders/simple-quad.vert", defaultVertCode);
     std::string defaultFragCode;
@@ -28,10 +41,18 @@ GLSandboxRenderer::GLSandboxRenderer() : Renderer() {
     SerializationUtils::readFile("Shaders/profile.frag", profileFragCode);
     mProfileShader = std::make_unique<Shader>(profileVertCode, profileFragCode);
 
+    mDefaultShader->waitForCompile();
+    mProfileShader->waitForCompile();
+
     resetPipeline();
 }
 
 void GLSandboxRenderer::update() {
+    ShaderPreprocessor::checkForChanges();
+
+    if (Shader::updatePending())
+        updateEntryPoint();
+
     if (sErrorFlag)
         resetPipeline();
 }
@@ -39,11 +60,19 @@ void GLSandboxRenderer::update() {
 void GLSandboxRenderer::drawDebug() {
     ImGui::Begin("Debug");
 
+    drawPassTimings();
+
     ImGui::BeginChild("DebugData", ImVec2(200.0f, 0.0f), true);
 
     float deltaTime = mTimer.tick().count();
     ImGui::Text("%.2f fps | %.2f ms", 1.0f / deltaTime, 1000.0f * deltaTime);
 
+    const RenderConfig::StateStats& stateStats = getFrameStateStats();
+    ImGui::TextWrapped("State changes: %u issued | %u elided", stateStats.issued, stateStats.elided);
+
+    for (const auto& [label, result] : ProfileUtils::getResults())
+        ImGui::TextWrapped("%s: %s", label.c_str(), result.c_str());
+
     ImGui::EndChild();
     ImGui::SameLine();
     ImGui::BeginChild("DebugMessages", ImVec2(0.0f, 0.0f), true);
@@ -60,6 +89,67 @@ void GLSandboxRenderer::drawDebug() {
     ImGui::End();
 }
 
+void GLSandboxRenderer::drawPassTimings() {
+    const std::vector<int>& passes = PassProfiler::getPasses();
+    if (passes.empty() || !ImGui::CollapsingHeader("Pass Timings"))
+        return;
+
+    const auto passColour = [&passes](int id) {
+        const auto index = std::find(passes.begin(), passes.end(), id) - passes.begin();
+        return (ImU32)ImColor::HSV(std::fmod((float)index * 0.61803f, 1.0f), 0.6f, 0.8f);
+    };
+
+    constexpr ImGuiTableFlags cTABLE_FLAGS = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                                             ImGuiTableFlags_SizingFixedFit;
+    if (ImGui::BeginTable("PassTimings", 7, cTABLE_FLAGS)) {
+        ImGui::TableSetupColumn("Pass", ImGuiTableColumnFlags_WidthStretch);
+        for (const char* column : {"GPU min", "GPU avg", "GPU p95", "CPU min", "CPU avg", "CPU p95"})
+            ImGui::TableSetupColumn(column);
+        ImGui::TableHeadersRow();
+
+        for (int id : passes) {
+            const PassProfiler::PassTiming* timing = PassProfiler::getPassTiming(id);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextColored(ImColor(passColour(id)), "%s", timing->label.c_str());
+            for (float time : {timing->gpu.min, timing->gpu.avg, timing->gpu.p95,
+                               timing->cpu.min, timing->cpu.avg, timing->cpu.p95}) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", time);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    const PassProfiler::Timeline& timeline = PassProfiler::getTimeline();
+    ImGui::Text("Frame: GPU %.3f ms | CPU %.3f ms | %zu dropped", timeline.gpuTotal, timeline.cpuTotal,
+                PassProfiler::getDroppedFrames());
+
+    // One row each for the GPU and CPU, with every pass execution drawn as a bar along a shared time axis
+    constexpr float cROW_HEIGHT = 16.0f;
+    const float width = ImGui::GetContentRegionAvail().x;
+    const float scale = width / std::max({timeline.gpuTotal, timeline.cpuTotal, 0.001f});
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+    const auto drawRow = [&](const std::vector<PassProfiler::Interval>& intervals, float y) {
+        drawList->AddRectFilled(ImVec2(origin.x, y), ImVec2(origin.x + width, y + cROW_HEIGHT),
+                                ImGui::GetColorU32(ImGuiCol_FrameBg));
+        for (const PassProfiler::Interval& interval : intervals) {
+            const ImVec2 min(origin.x + interval.begin * scale, y);
+            const ImVec2 max(std::max(origin.x + interval.end * scale, min.x + 1.0f), y + cROW_HEIGHT);
+            drawList->AddRectFilled(min, max, passColour(interval.id));
+            if (ImGui::IsMouseHoveringRect(min, max))
+                ImGui::SetTooltip("%s: %.3f ms", PassProfiler::getPassTiming(interval.id) ?
+                                  PassProfiler::getPassTiming(interval.id)->label.c_str() : "Unknown",
+                                  interval.end - interval.begin);
+        }
+    };
+    drawRow(timeline.gpu, origin.y);
+    drawRow(timeline.cpu, origin.y + cROW_HEIGHT + 2.0f);
+    ImGui::Dummy(ImVec2(width, 2.0f * cROW_HEIGHT + 2.0f));
+}
+
 void GLSandboxRenderer::resetPipeline() {
     clearPipeline(true);
     appendPipeline([&]() {
@@ -75,13 +165,12 @@ void GLSandboxRenderer::loadAnalysisPipeline(unsigned int bulk, std::size_t iter
     mProfileShader->unbind();
 
     clearPipeline(false);
-    appendPipeline([&, iterations]() {
-        for (std::size_t i = 0; i < iterations; i++) {
-            mProfileShader->bind();
-            mQuad->bind();
-            mQuad->draw();
-        }
-    });
+    CommandBuffer& commands = getCommandBuffer();
+    commands.beginLoop((std::uint32_t)iterations);
+    commands.useProgram(*mProfileShader);
+    commands.bindVAO(*mQuad);
+    commands.draw(*mQuad);
+    commands.endLoop();
 }
 
 void GLSandboxRenderer::debugOutput(unsigned int source, unsigned int type, unsigned int id, unsigned int severity,
@@ -30,6 +30,11 @@ public:
     static void APIENTRY debugOutput(unsigned int source, unsigned int type, unsigned int id, unsigned int severity,
                                      int length, const char* message, const void* userParam);
 private:
+    /**
+     * @brief Draw the per-pass timing table and the timeline of the last measured frame.
+     */
+    static void drawPassTimings();
+
     Timer mTimer{100};
 
     std::unique_ptr<Mesh> mQuad;
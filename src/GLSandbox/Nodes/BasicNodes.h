@@ -26,13 +26,13 @@ protected:
     }
     virtual bool drawInputArea(const std::string& label) = 0;
 protected:
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final {
+    void deserializeData(const std::string& dataID, std::istream& stream) final {
         if (dataID == "Value")
             SerializationUtils::deserializeData(stream, mValue);
         else
             deserializeDataExtra(dataID, stream);
     }
-    virtual void deserializeDataExtra(const std::string& dataID, std::ifstream& stream) {}
+    virtual void deserializeDataExtra(const std::string& dataID, std::istream& stream) {}
 
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final {
         std::vector<std::pair<std::string, std::string>> data = generateSerializedDataExtra();
@@ -6,8 +6,15 @@
 #include "../Assets.h"
 #include "../PipelineGraph.h"
 
+#include "../../Rendering/TransientTexturePool.h"
+
+#include "../../Utils/FileUtils.h"
 #include "../../Utils/SerializationUtils.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
 EntryNode::EntryNode(IPipelineHandler& pipelineHandler) : Node("Entry"), mPipelineHandler(pipelineHandler) {
     addPort(mExecutionOut);
 }
@@ -16,7 +23,7 @@ void EntryNode::setEntry() {
     if (validatePipeline()) {
         updatePipeline();
         mIsRunning = true;
-    } else {
+    } else if (!mIsPending) {
         mPipelineHandler.resetPipeline();
     }
 }
@@ -24,14 +31,19 @@ void EntryNode::setEntry() {
 void EntryNode::unsetEntry() {
     unlock();
     mIsRunning = false;
+    mIsPending = false;
 }
 
 std::vector<std::pair<std::string, std::string>> EntryNode::generateSerializedData() const {
-    return {};
+    std::vector<std::pair<std::string, std::string>> data{};
+    if (mFusePasses)
+        data.emplace_back("FusePasses", SerializationUtils::serializeData(mFusePasses));
+    return data;
 }
 
-void EntryNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
-
+void EntryNode::deserializeData(const std::string& dataID, std::istream& stream) {
+    if (dataID == "FusePasses")
+        SerializationUtils::deserializeData(stream, mFusePasses);
 }
 
 void EntryNode::drawContents() {
@@ -43,49 +55,59 @@ void EntryNode::drawContents() {
             mPipelineHandler.setEntryPoint(*this);
     }
 
+    ImUtils::toggleButton(mFusePasses, "Pass Fusion (On)", "Pass Fusion (Off)", generateNodeLabelID("FusePasses"));
+
     if (!mMessage.empty())
         drawMessage(mMessage, getMessageColour(mMessageType));
 }
 
 enum class PipelineState {
     Valid,
+    Pending,
     Invalid,
     InfiniteLoop,
     UnsupportedConnection
 };
 
-PipelineState validateNode(const Node* node, const Node* parent, const LoopNode* currentLoop = nullptr) {
-    if (!node || node == currentLoop)
-        return PipelineState::Valid;
-    if (node == parent)
-        return PipelineState::InfiniteLoop;
-
-    const Node* next;
-    bool isValid;
-    if (const RenderPassNode* renderPassNode = dynamic_cast<const RenderPassNode*>(node)) {
-        isValid = renderPassNode->validate();
-        next = renderPassNode->getNextPass();
-    } else if (const InputNode* inputNode = dynamic_cast<const InputNode*>(node)) {
-        isValid = inputNode->validate();
-        if (isValid)
-            next = inputNode->getOutputValue<Node*>();
-    } else if (const OutputNode* outputNode = dynamic_cast<const OutputNode*>(node)) {
-        isValid = outputNode->validate();
-        next = outputNode->getNextPass();
-    } else if (const LoopNode* loopNode = dynamic_cast<const LoopNode*>(node)) {
-        PipelineState state = validateNode(loopNode->getLoopEntry(), loopNode, loopNode);
-        if (state != PipelineState::Valid)
-            return state;
-        isValid = true;
-        next = loopNode->getNextPass();
-    } else {
-        return PipelineState::UnsupportedConnection;
+PipelineState validateNode(const Node* node) {
+    // Loops entered but not yet exited, innermost last
+    std::vector<const LoopNode*> loops{};
+    std::unordered_set<const Node*> visited{};
+
+    while (true) {
+        if (!node || (!loops.empty() && node == loops.back())) {
+            if (loops.empty())
+                return PipelineState::Valid;
+            node = loops.back()->getNextPass();
+            loops.pop_back();
+            continue;
+        }
+        if (!visited.insert(node).second)
+            return PipelineState::InfiniteLoop;
+
+        if (const RenderPassNode* renderPassNode = dynamic_cast<const RenderPassNode*>(node)) {
+            if (!renderPassNode->validate())
+                return renderPassNode->isPending() ? PipelineState::Pending : PipelineState::Invalid;
+            node = renderPassNode->getNextPass();
+        } else if (const InputNode* inputNode = dynamic_cast<const InputNode*>(node)) {
+            if (!inputNode->validate())
+                return PipelineState::Invalid;
+            node = inputNode->getOutputValue<Node*>();
+        } else if (const OutputNode* outputNode = dynamic_cast<const OutputNode*>(node)) {
+            if (!outputNode->validate())
+                return PipelineState::Invalid;
+            node = outputNode->getNextPass();
+        } else if (const LoopNode* loopNode = dynamic_cast<const LoopNode*>(node)) {
+            loops.push_back(loopNode);
+            node = loopNode->getLoopEntry();
+        } else {
+            return PipelineState::UnsupportedConnection;
+        }
     }
-
-    return isValid ? validateNode(next, node, currentLoop) : PipelineState::Invalid;
 }
 
 bool EntryNode::validatePipeline() const {
+    mIsPending = false;
     if (!mExecutionOut.isLinked()) {
         mMessage = "Not linked to a render pass";
         mMessageType = MessageType::Error;
@@ -93,11 +115,16 @@ bool EntryNode::validatePipeline() const {
     }
 
     const Node* node = mExecutionOut.getLinkedValue<Node*>();
-    switch (validateNode(node, nullptr)) {
+    switch (validateNode(node)) {
         case PipelineState::Valid:
             mMessage = "Uploaded";
             mMessageType = MessageType::Confirmation;
             return true;
+        case PipelineState::Pending:
+            mMessage = "Waiting for shaders to compile";
+            mMessageType = MessageType::Info;
+            mIsPending = true;
+            return false;
         case PipelineState::Invalid:
             mMessage = "Invalid";
             mMessageType = MessageType::Error;
@@ -117,28 +144,176 @@ bool EntryNode::validatePipeline() const {
     }
 }
 
-void generatePipeline(IPipelineHandler& handler, const Node* node, const LoopNode* currentLoop = nullptr, std::size_t iteration = 1) {
-    if (!node)
-        return;
+/**
+ * @returns Every render pass reachable from node, in order of first execution.
+ */
+std::vector<const RenderPassNode*> collectPasses(const Node* node) {
+    std::vector<const RenderPassNode*> passes{};
+    std::vector<const LoopNode*> loops{};
+    std::unordered_set<const Node*> visited{};
+
+    while (true) {
+        if (!node || (!loops.empty() && node == loops.back())) {
+            if (loops.empty())
+                return passes;
+            node = loops.back()->getNextPass();
+            loops.pop_back();
+            continue;
+        }
+        if (!visited.insert(node).second)
+            return passes;
+
+        if (const RenderPassNode* renderPassNode = dynamic_cast<const RenderPassNode*>(node)) {
+            passes.push_back(renderPassNode);
+            node = renderPassNode->getNextPass();
+        } else if (const InputNode* inputNode = dynamic_cast<const InputNode*>(node)) {
+            node = inputNode->validate() ? inputNode->getOutputValue<Node*>() : nullptr;
+        } else if (const OutputNode* outputNode = dynamic_cast<const OutputNode*>(node)) {
+            node = outputNode->getNextPass();
+        } else if (const LoopNode* loopNode = dynamic_cast<const LoopNode*>(node)) {
+            loops.push_back(loopNode);
+            node = loopNode->getLoopEntry();
+        } else {
+            return passes;
+        }
+    }
+}
 
-    if (node == currentLoop) {
-        if (iteration != currentLoop->getNumIterations())
-            generatePipeline(handler, currentLoop->getLoopEntry(), currentLoop, iteration + 1);
-        return;
+/**
+ * @returns true if a pass drawing with state keeps the previous contents of texture (one of its framebuffer's
+ * attachments) rather than replacing them: if the pass does not clear, or blends with or depth tests against the
+ * attachment, or masks part of it from the clear.
+ */
+static bool isAttachmentLoaded(const CommandBuffer::RenderState& state, const Texture& texture) {
+    if (!state.doClear)
+        return true;
+    switch (texture.getInternalFormat()) {
+        case Texture::InternalFormat::DepthComponent:
+        case Texture::InternalFormat::DepthStencil:
+            return state.enableDepthTest || !state.enableDepthMask;
+        default:
+            return state.enableBlend || !glm::all(state.colourMask);
     }
+}
 
-    if (const RenderPassNode* renderPassNode = dynamic_cast<const RenderPassNode*>(node)) {
-        handler.appendPipeline(renderPassNode->generateCallback());
-        generatePipeline(handler, renderPassNode->getNextPass(), currentLoop, iteration);
-    } else if (const InputNode* inputNode = dynamic_cast<const InputNode*>(node)) {
-        generatePipeline(handler, inputNode->getOutputValue<Node*>(), currentLoop, iteration);
-    } else if (const OutputNode* outputNode = dynamic_cast<const OutputNode*>(node)) {
-        generatePipeline(handler, outputNode->getNextPass(), currentLoop, iteration);
-    } else if (const LoopNode* loopNode = dynamic_cast<const LoopNode*>(node)) {
-        generatePipeline(handler, loopNode->getLoopEntry(), loopNode);
-        generatePipeline(handler, loopNode->getNextPass(), currentLoop, iteration);
-    } else {
-        assert(false);
+/**
+ * @brief Flag every pass whose output is never observed as culled, and clear the flag on the rest.
+ * @brief A pass is observed if it draws to the default framebuffer, or to a texture read by another observed pass.
+ * Textures are read by being sampled, or by being loaded as an attachment (see isAttachmentLoaded()), e.g. a depth
+ * buffer drawn by a prepass and then depth tested against. As the pipeline (and each loop within it) repeats, the
+ * reading pass may run either before or after the pass which draws to the texture.
+ * @returns Number of passes culled.
+ */
+std::size_t cullPasses(const std::vector<const RenderPassNode*>& passes) {
+    std::vector<bool> isObserved(passes.size(), false);
+    std::unordered_set<const Texture*> read{};
+    bool isChanged = true;
+    while (isChanged) {
+        isChanged = false;
+        // Passes mostly sample textures drawn to earlier in the pipeline, so visiting them in reverse settles most
+        // pipelines in a single sweep
+        for (std::size_t i = passes.size(); i-- > 0;) {
+            if (isObserved[i])
+                continue;
+
+            const Framebuffer* framebuffer = passes[i]->getFramebuffer();
+            if (framebuffer && std::none_of(framebuffer->getAttachments().begin(), framebuffer->getAttachments().end(),
+                                            [&read](const auto& attachment) {
+                return read.contains(attachment.first);
+            }))
+                continue;
+
+            isObserved[i] = true;
+            isChanged = true;
+            for (const Texture* texture : passes[i]->getSampledTextures())
+                read.insert(texture);
+            if (framebuffer) {
+                const CommandBuffer::RenderState state = passes[i]->getRenderState();
+                for (const auto& [texture, attachment] : framebuffer->getAttachments())
+                    if (isAttachmentLoaded(state, *texture))
+                        read.insert(texture);
+            }
+        }
+    }
+
+    std::size_t numCulled = 0;
+    for (std::size_t i = 0; i < passes.size(); i++) {
+        passes[i]->setCulled(!isObserved[i]);
+        if (!isObserved[i])
+            numCulled++;
+    }
+    return numCulled;
+}
+
+/**
+ * @brief Compile the pipeline starting at node (which must have been validated) into commands. Each loop is emitted
+ * once between a LoopBegin/LoopEnd pair, so the size of the pipeline does not depend on the number of iterations.
+ * Passes flagged by cullPasses() are left out.
+ * @param fusePasses If set, runs of consecutive passes (within the same loop) which can be fused are emitted as a
+ * single draw (see RenderPassNode::findFusedInput()), falling back to the separate passes if their shaders cannot be
+ * fused. The texture linking two fused passes must not be sampled by any other pass.
+ * @returns Number of passes fused into another.
+ */
+std::size_t generatePipeline(CommandBuffer& commands, const Node* node, bool fusePasses) {
+    std::vector<const LoopNode*> loops{};
+    std::vector<std::string> loopIndexUniforms{};
+
+    std::unordered_map<const Texture*, std::size_t> sampleCounts{};
+    if (fusePasses)
+        for (const RenderPassNode* pass : collectPasses(node))
+            if (!pass->isCulled())
+                for (const Texture* texture : pass->getSampledTextures())
+                    sampleCounts[texture]++;
+
+    // Passes waiting to be emitted, each of which can be fused with the next
+    std::vector<const RenderPassNode*> fusable{};
+    std::size_t numFused = 0;
+    const auto flushPasses = [&]() {
+        if (fusable.size() > 1 && RenderPassNode::generateFusedCommands(commands, fusable, loopIndexUniforms)) {
+            numFused += fusable.size() - 1;
+        } else {
+            for (const RenderPassNode* pass : fusable)
+                pass->generateCommands(commands, loopIndexUniforms);
+        }
+        fusable.clear();
+    };
+
+    while (true) {
+        if (!node || (!loops.empty() && node == loops.back())) {
+            flushPasses();
+            if (loops.empty())
+                return numFused;
+            commands.endLoop();
+            node = loops.back()->getNextPass();
+            loops.pop_back();
+            loopIndexUniforms.pop_back();
+            continue;
+        }
+
+        if (const RenderPassNode* renderPassNode = dynamic_cast<const RenderPassNode*>(node)) {
+            if (!renderPassNode->isCulled()) {
+                const bool canFuse = fusePasses && !fusable.empty() &&
+                                     fusable.back()->findFusedInput(*renderPassNode) != -1 &&
+                                     sampleCounts[fusable.back()->getFramebuffer()->getAttachments().front().first] == 1;
+                if (!canFuse)
+                    flushPasses();
+                fusable.push_back(renderPassNode);
+            }
+            node = renderPassNode->getNextPass();
+        } else if (const InputNode* inputNode = dynamic_cast<const InputNode*>(node)) {
+            node = inputNode->getOutputValue<Node*>();
+        } else if (const OutputNode* outputNode = dynamic_cast<const OutputNode*>(node)) {
+            node = outputNode->getNextPass();
+        } else if (const LoopNode* loopNode = dynamic_cast<const LoopNode*>(node)) {
+            flushPasses();
+            commands.beginLoop((std::uint32_t)loopNode->getNumIterations());
+            loops.push_back(loopNode);
+            loopIndexUniforms.push_back(loopNode->getIndexUniform());
+            node = loopNode->getLoopEntry();
+        } else {
+            assert(false);
+            return numFused;
+        }
     }
 }
 
@@ -146,21 +321,37 @@ void EntryNode::updatePipeline() {
     mPipelineHandler.clearPipeline(false);
 
     const Node* node = mExecutionOut.getLinkedValue<Node*>();
-    generatePipeline(mPipelineHandler, node);
-
-    mPipelineHandler.appendPipeline([]() {
-        RenderConfig::setViewport();
-        RenderConfig::setClearColour();
-        RenderConfig::setBlend();
-        RenderConfig::setColourMask();
-        RenderConfig::setCullFace();
-        RenderConfig::setDepthTest();
-        RenderConfig::setDepthMask();
+    std::vector<const RenderPassNode*> passes = collectPasses(node);
+    const std::size_t numCulled = cullPasses(passes);
+
+    // Uniform values are pulled from their ports once per frame, rather than pushed every time anything upstream
+    // changes
+    mPipelineHandler.getCommandBuffer().callback([passes]() {
+        for (const RenderPassNode* pass : passes)
+            pass->pullUniformValues();
     });
+    const std::size_t numFused = generatePipeline(mPipelineHandler.getCommandBuffer(), node, mFusePasses);
+    if (numCulled > 0)
+        mMessage.append(" (").append(std::to_string(numCulled)).append(numCulled == 1 ? " pass" : " passes")
+            .append(" culled)");
+    if (numFused > 0)
+        mMessage.append(" (").append(std::to_string(numFused)).append(numFused == 1 ? " pass" : " passes")
+            .append(" fused)");
+
+    // Restore the default state
+    mPipelineHandler.getCommandBuffer().setState(CommandBuffer::RenderState());
+
+    TransientTexturePool::allocate(mPipelineHandler.getCommandBuffer());
 
     lock();
 }
 
+void EntryNode::updateCulling() {
+    if (mIsRunning || !mExecutionOut.isLinked())
+        return;
+    cullPasses(collectPasses(mExecutionOut.getLinkedValue<Node*>()));
+}
+
 InputNode::InputNode() : Node("Input") {
     addPort(mDefaultIn);
 
@@ -182,6 +373,10 @@ InputNode::InputNode() : Node("Input") {
         removePort(*mValueOut);
         mValueOut = nullptr;
     });
+    mDefaultIn.addOnUpdateEvent([this]() {
+        if (mValueOut && !mExternalInput)
+            mValueOut->valueUpdated();
+    });
 }
 
 bool InputNode::validate() const {
@@ -250,7 +445,7 @@ void InputNode::drawInput() {
             ImGui::SameLine();
 
             if (ImUtils::button("Reset", generateNodeLabelID("InputReset")))
-                mExternalInput = nullptr;
+                unsetValue();
 
             break;
         default:
@@ -264,7 +459,7 @@ std::vector<std::pair<std::string, std::string>> InputNode::generateSerializedDa
     return {};
 }
 
-void InputNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void InputNode::deserializeData(const std::string& dataID, std::istream& stream) {
 
 }
 
@@ -332,7 +527,7 @@ std::vector<std::pair<std::string, std::string>> OutputNode::generateSerializedD
     return {};
 }
 
-void OutputNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void OutputNode::deserializeData(const std::string& dataID, std::istream& stream) {
 
 }
 
@@ -352,7 +547,7 @@ std::vector<std::pair<std::string, std::string>> SubGraphNode::generateSerialize
     return data;
 }
 
-void SubGraphNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void SubGraphNode::deserializeData(const std::string& dataID, std::istream& stream) {
     if (dataID == "File")
         SerializationUtils::deserializeData(stream, mGraphFilepath);
 }
@@ -376,20 +571,12 @@ void SubGraphNode::loadFromFile() {
     mInputs.clear();
     mOutputs.clear();
 
-    std::ifstream stream(mGraphFilepath, std::ios::in | std::ios::binary);
-    if (!stream)
-        return;
-
-    std::streampos begin = stream.tellg();
-
-    long long id;
-    stream >> id;
-    if (mParent.isDependency(id))
+    MappedFile file(mGraphFilepath);
+    if (!file.isOpen() || mParent.isDependency(GraphFormat::readID(file.view())))
         return;
 
-    stream.seekg(begin);
     mGraph = std::make_unique<PipelineGraph>(mPipelineHandler);
-    mGraph->deserialize(stream);
+    mGraph->deserialize(file.view());
 
     updatePorts();
 }
@@ -29,9 +29,19 @@ public:
 
     void setEntry() final;
     void unsetEntry() final;
+
+    [[nodiscard]] bool isPending() const final {
+        return mIsPending;
+    }
+
+    /**
+     * @brief Re-evaluate which of the linked render passes would be culled, so the editor reflects changes to the
+     * graph before the pipeline is next executed. Does nothing while running, as the pipeline's nodes are locked.
+     */
+    void updateCulling();
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void drawContents() final;
 private:
@@ -40,6 +50,14 @@ private:
     void updatePipeline();
 
     bool mIsRunning = false;
+    /**
+     * @brief Fuse consecutive passes into a single draw where possible (see RenderPassNode::findFusedInput()).
+     */
+    bool mFusePasses = false;
+    /**
+     * @brief Set while the pipeline is otherwise valid, but waiting on shaders to finish compiling.
+     */
+    mutable bool mIsPending = false;
 
     IPipelineHandler& mPipelineHandler;
 
@@ -98,6 +116,8 @@ public:
      */
     inline void unsetValue() {
         mExternalInput = nullptr;
+        if (mValueOut)
+            mValueOut->valueUpdated();
     }
     /**
      * @brief This node is assumed to be in a valid state (see InputNode::isValid()). If not in a valid state, this
@@ -108,7 +128,7 @@ public:
         return mDefaultIn.getLinkedValue();
     }
     [[nodiscard]] inline input_t getOutputValue() const {
-        return anyToVariant(mValueOut->getAnyLinkedValue(), input_t{});
+        return std::visit([](const auto& arg)->input_t { return arg; }, mValueOut->getLinkedPortValue());
     }
     template<typename T>
     [[nodiscard]] inline T getOutputValue() const {
@@ -119,7 +139,7 @@ public:
     }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void drawContents() final;
 private:
@@ -182,7 +202,7 @@ public:
     }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void drawContents() final;
 private:
@@ -201,7 +221,7 @@ public:
     }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void onDeserialize() final;
 
@@ -67,7 +67,7 @@ std::vector<std::pair<std::string, std::string>> ModelMatrixNode::generateSerial
     return data;
 }
 
-void ModelMatrixNode::deserializeDataExtra(const std::string& dataID, std::ifstream& stream) {
+void ModelMatrixNode::deserializeDataExtra(const std::string& dataID, std::istream& stream) {
     if (dataID == "Position")
         SerializationUtils::deserializeData(stream, mPosition);
     else if (dataID == "Roll")
@@ -118,7 +118,7 @@ std::vector<std::pair<std::string, std::string>> ViewMatrixNode::generateSeriali
     return data;
 }
 
-void ViewMatrixNode::deserializeDataExtra(const std::string& dataID, std::ifstream& stream) {
+void ViewMatrixNode::deserializeDataExtra(const std::string& dataID, std::istream& stream) {
     if (dataID == "Position")
         SerializationUtils::deserializeData(stream, mPosition);
     else if (dataID == "Roll")
@@ -167,7 +167,7 @@ std::vector<std::pair<std::string, std::string>> ProjMatrixNode::generateSeriali
     return data;
 }
 
-void ProjMatrixNode::deserializeDataExtra(const std::string& dataID, std::ifstream& stream) {
+void ProjMatrixNode::deserializeDataExtra(const std::string& dataID, std::istream& stream) {
     if (dataID == "Type")
         SerializationUtils::deserializeData(stream, (unsigned int&)mType);
     else if (dataID == "FoV")
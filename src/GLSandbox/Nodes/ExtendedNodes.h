@@ -56,7 +56,7 @@ public:
     }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedDataExtra() const final;
-    void deserializeDataExtra(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeDataExtra(const std::string& dataID, std::istream& stream) final;
 
     void onDeserialize() final {
         mValue = generateModelMatrix();
@@ -96,7 +96,7 @@ public:
     }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedDataExtra() const final;
-    void deserializeDataExtra(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeDataExtra(const std::string& dataID, std::istream& stream) final;
 
     void onDeserialize() final {
         mValue = generateViewMatrix();
@@ -134,7 +134,7 @@ public:
     }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedDataExtra() const final;
-    void deserializeDataExtra(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeDataExtra(const std::string& dataID, std::istream& stream) final;
 
     void onDeserialize() final {
         mValue = generateProjMatrix();
@@ -12,12 +12,16 @@ LoopNode::LoopNode() : Node("Loop") {
 std::vector<std::pair<std::string, std::string>> LoopNode::generateSerializedData() const {
     std::vector<std::pair<std::string, std::string>> data{};
     data.emplace_back("Iterations", SerializationUtils::serializeData(mNumIterations));
+    if (!mIndexUniform.empty())
+        data.emplace_back("IndexUniform", SerializationUtils::serializeData(mIndexUniform));
     return data;
 }
 
-void LoopNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void LoopNode::deserializeData(const std::string& dataID, std::istream& stream) {
     if (dataID == "Iterations")
         SerializationUtils::deserializeData(stream, mNumIterations);
+    else if (dataID == "IndexUniform")
+        SerializationUtils::deserializeData(stream, mIndexUniform);
 }
 
 void LoopNode::drawContents() {
@@ -25,5 +29,9 @@ void LoopNode::drawContents() {
 
     ImUtils::inputInt((int*)&mNumIterations, generateNodeLabelID("Iterations"), 0, INT_MAX);
 
+    ImGui::Text("Index Uniform");
+    ImGui::SameLine();
+    ImUtils::inputText(mIndexUniform, generateNodeLabelID("IndexUniform"));
+
     ImGui::EndDisabled();
 }
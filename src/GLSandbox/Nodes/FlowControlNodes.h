@@ -24,9 +24,16 @@ public:
     [[nodiscard]] inline std::size_t getNumIterations() const {
         return mNumIterations;
     }
+    /**
+     * @returns Name of the int uniform set to the current iteration (from 0) in every pass within the loop, or empty if
+     * the index is not exposed.
+     */
+    [[nodiscard]] inline const std::string& getIndexUniform() const {
+        return mIndexUniform;
+    }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void drawContents() final;
 private:
@@ -37,4 +44,5 @@ private:
     Port<Node*> mLoopOut = Port<Node*>(*this, IPort::Direction::Out, "LoopBegin", "Loop-Begin", [&]() { return this; });
 
     std::size_t mNumIterations = 1;
+    std::string mIndexUniform;
 };
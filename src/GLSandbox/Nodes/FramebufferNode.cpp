@@ -80,7 +80,7 @@ std::vector<std::pair<std::string, std::string>> FramebufferNode::generateSerial
     return data;
 }
 
-void FramebufferNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void FramebufferNode::deserializeData(const std::string& dataID, std::istream& stream) {
     if (dataID == "NumColourBuffers")
         SerializationUtils::deserializeData(stream, mNumColourBuffers);
     else if (dataID == "DepthBuffer")
@@ -21,7 +21,7 @@ public:
     [[nodiscard]] bool validate() const final;
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void onDeserialize() final;
 
@@ -39,14 +39,15 @@ std::vector<std::pair<std::string, std::string>> ArithmeticNode::generateSeriali
     return data;
 }
 
-void ArithmeticNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void ArithmeticNode::deserializeData(const std::string& dataID, std::istream& stream) {
     if (dataID == "Operation")
         SerializationUtils::deserializeData(stream, (int&)mCurrentOperation);
 }
 
 void ArithmeticNode::drawContents() {
-    ImUtils::cycleButton(generateNodeLabelID("Combo"), (size_t&)mCurrentOperation, (size_t)Operation::Max,
-                         [](size_t index) { return getOperationLabel((Operation)index); });
+    if (ImUtils::cycleButton(generateNodeLabelID("Combo"), (size_t&)mCurrentOperation, (size_t)Operation::Max,
+                             [](size_t index) { return getOperationLabel((Operation)index); }) && mValueOut)
+        mValueOut->valueUpdated();
 }
 
 ArithmeticNode::numeric_variant_t ArithmeticNode::calculateValue() {
@@ -32,7 +32,7 @@ public:
     }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void drawContents() final;
 private:
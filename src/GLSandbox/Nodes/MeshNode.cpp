@@ -1,11 +1,61 @@
 #include "MeshNode.h"
 
 #include "../../Utils/FileUtils.h"
+#include "../../Utils/MeshUtils.h"
 #include "../../Utils/SerializationUtils.h"
 
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <unordered_set>
 
+static_assert(std::endian::native == std::endian::little, "Binary mesh format assumes a little-endian host");
+
+namespace mshb {
+    constexpr char cMAGIC[4] = {'G', 'S', 'B', 'M'};
+    constexpr uint32_t cVERSION = 1;
+    constexpr size_t cARRAY_ALIGNMENT = 16;
+    constexpr size_t cMAX_NAME_LENGTH = 39;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t numVertices;
+        uint32_t numIndices;
+        uint32_t type;
+        uint32_t numAttributes;
+        uint64_t indexOffset;
+    };
+
+    /**
+     * @brief Describes one raw attribute array of numVertices elements, starting at offset bytes into the file.
+     */
+    struct AttributeRecord {
+        char name[cMAX_NAME_LENGTH + 1];
+        uint32_t length;
+        uint32_t dataType;
+        uint32_t binding;
+        uint32_t reserved;
+        uint64_t offset;
+    };
+
+    template<typename T>
+    struct Component {
+        typedef T type;
+    };
+    template<glm::length_t L, typename T, glm::qualifier Q>
+    struct Component<glm::vec<L, T, Q>> {
+        typedef T type;
+    };
+
+    inline uint64_t align(uint64_t offset) {
+        return (offset + cARRAY_ALIGNMENT - 1) / cARRAY_ALIGNMENT * cARRAY_ALIGNMENT;
+    }
+}
+
 glm::vec4 calculateTangentFromTri(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
     const glm::vec2& ta, const glm::vec2& tb, const glm::vec2& tc) {
     glm::vec3 ba = b - a;
@@ -44,18 +94,44 @@ std::vector<std::pair<std::string, std::string>> MeshNode::generateSerializedDat
     if (filepath.empty())
         filepath = generateFilename();
 
-    std::filesystem::path fileExtension = mFilepath.extension();
-    if (fileExtension == getMeshDefaultExtension())
-        writeToFile(filepath);
+    std::filesystem::path fileExtension = filepath.extension();
+    if ((fileExtension == std::string(".").append(getMeshDefaultExtension()) ||
+         fileExtension == std::string(".").append(getMeshBinaryExtension())) && needsWrite(filepath))
+        writeToFileAsync(filepath);
+    data.emplace_back("OptimizeOnImport", SerializationUtils::serializeData(mOptimizeOnImport));
+    data.emplace_back("Layout", SerializationUtils::serializeData((int)mLayout));
+    std::string storageFormats;
+    for (const auto& attribute : mAttributes)
+        storageFormats.append(storageFormats.empty() ? "" : " ").append(std::to_string((int)attribute.format));
+    if (!storageFormats.empty())
+        data.emplace_back("StorageFormats", storageFormats);
     data.emplace_back("File", SerializationUtils::serializeData(filepath));
 
     return data;
 }
 
-void MeshNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
-    if (dataID == "File") {
+void MeshNode::deserializeData(const std::string& dataID, std::istream& stream) {
+    if (dataID == "OptimizeOnImport") {
+        SerializationUtils::deserializeData(stream, mOptimizeOnImport);
+    } else if (dataID == "Layout") {
+        int layout;
+        SerializationUtils::deserializeData(stream, layout);
+        mLayout = (Mesh::Layout)std::clamp(layout, 0, (int)Mesh::Layout::Max - 1);
+    } else if (dataID == "StorageFormats") {
+        mPendingStorageFormats.clear();
+        int format;
+        while (stream >> format)
+            mPendingStorageFormats.push_back((Mesh::StorageFormat)std::clamp(format, 0, (int)Mesh::StorageFormat::Max - 1));
+    } else if (dataID == "File") {
         SerializationUtils::deserializeData(stream, mFilepath);
         loadFromFile();
+        for (size_t i = 0; i < mPendingStorageFormats.size() && i < mAttributes.size(); i++) {
+            Attribute& attribute = mAttributes[i];
+            if (isFloatAttr(attribute.data) &&
+                Mesh::isStorageFormatValid(mPendingStorageFormats[i], getAttrLength(attribute.data)))
+                attribute.format = mPendingStorageFormats[i];
+        }
+        mPendingStorageFormats.clear();
     }
 }
 
@@ -69,6 +145,7 @@ void MeshNode::drawContents() {
     drawGlobalParameters();
 
     if (ImUtils::beginHeader("Attributes", generateNodeLabelID("AttributesHeader"), mShowAttributes)) {
+        materializeMappedData();
         drawAttributes();
         ImUtils::endHeader();
     }
@@ -86,7 +163,25 @@ void MeshNode::loadFromFile() {
         return;
     std::filesystem::path fileExtension = mFilepath.extension();
 
+    waitForPendingWrite();
     clearMesh();
+    markContentChanged();
+
+    if (fileExtension == std::string(".").append(getMeshBinaryExtension())) {
+        loadFromFileMSHB();
+        mFromOBJ = false;
+        mWrittenPath = mFilepath;
+        mWrittenVersion = mContentVersion;
+        return;
+    }
+
+    if (fileExtension == ".obj") {
+        loadFromFileOBJ();
+        mFromOBJ = true;
+        if (mOptimizeOnImport)
+            optimizeMesh();
+        return;
+    }
 
     std::ifstream stream(mFilepath);
     if (!stream)
@@ -95,144 +190,64 @@ void MeshNode::loadFromFile() {
     if (fileExtension == ".msh") {
         loadFromStreamMSH(stream);
         mFromOBJ = false;
-    } else if (fileExtension == ".obj") {
-        loadFromStreamOBJ(stream);
-        mFromOBJ = true;
+        mWrittenPath = mFilepath;
+        mWrittenVersion = mContentVersion;
     }
 }
 
-void MeshNode::loadFromStreamOBJ(std::ifstream& stream) {
-    std::vector<unsigned int> indices;
-    std::vector<unsigned int> texIndices;
-    std::vector<unsigned int> normIndices;
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec2> uvsSoft;
-    std::vector<glm::vec3> normalsSoft;
+void MeshNode::loadFromFileOBJ() {
+    MappedFile file(mFilepath);
+    if (!file.isOpen())
+        return;
 
-    while (!stream.eof()) {
-        std::string type;
-        stream >> type;
-        if (type == "v") {
-            glm::vec3 vertex;
-            stream >> vertex.x;
-            stream >> vertex.y;
-            stream >> vertex.z;
-            positions.emplace_back(vertex);
-            SerializationUtils::skipToNextLine(stream);
-        } else if (type == "vt") {
-            glm::vec2 uv;
-            stream >> uv.x;
-            stream >> uv.y;
-            uvsSoft.emplace_back(uv);
-            SerializationUtils::skipToNextLine(stream);
-        } else if (type == "vn") {
-            glm::vec3 normal;
-            stream >> normal.x;
-            stream >> normal.y;
-            stream >> normal.z;
-            normalsSoft.emplace_back(normal);
-            SerializationUtils::skipToNextLine(stream);
-        } else if (type == "f") {
-            std::string indexData = SerializationUtils::readLine(stream);
-
-            std::stringstream indexSetStream(indexData);
-            indexSetStream >> std::ws;
-
-            std::string indexSet;
-            std::vector<unsigned int> tempVis, tempTis, tempNis;
-            while (std::getline(indexSetStream, indexSet, ' ')) {
-                std::stringstream indexStream(indexSet);
-                int vi, ti, ni;
-                char sep1, sep2;
-                indexStream >> vi;
-
-                tempVis.push_back(vi < 0 ? positions.size() + vi : vi - 1);
-                if (indexStream.peek() != '/')
-                    continue;
-
-                indexStream >> sep1;
-                if (indexStream.peek() != '/') {
-                    indexStream >> ti;
-                    tempTis.push_back(ti < 0 ? uvsSoft.size() + ti : ti - 1);
-                }
+    MeshUtils::OBJData data;
+    MeshUtils::loadOBJ(file.view(), data);
 
-                if (indexStream.peek() != '/')
-                    continue;
-                indexStream >> sep2;
-                indexStream >> ni;
-                tempNis.push_back(ni < 0 ? normalsSoft.size() + ni : ni - 1);
-            }
-            if (tempVis.size() <= 3) {
-                for (unsigned int index : tempVis)
-                    indices.push_back(index);
-            } else {
-                for (size_t i = 2; i < tempVis.size(); i++) {
-                    indices.push_back(tempVis[0]);
-                    indices.push_back(tempVis[i - 1]);
-                    indices.push_back(tempVis[i    ]);
-                }
-            }
-            if (tempTis.size() <= 3) {
-                for (unsigned int index : tempTis)
-                    texIndices.push_back(index);
-            } else {
-                for (size_t i = 2; i < tempTis.size(); i++) {
-                    texIndices.push_back(tempTis[0]);
-                    texIndices.push_back(tempTis[i - 1]);
-                    texIndices.push_back(tempTis[i    ]);
-                }
-            }
-            if (tempNis.size() <= 3) {
-                for (unsigned int index : tempNis)
-                    normIndices.push_back(index);
-            } else {
-                for (size_t i = 2; i < tempNis.size(); i++) {
-                    normIndices.push_back(tempNis[0]);
-                    normIndices.push_back(tempNis[i - 1]);
-                    normIndices.push_back(tempNis[i    ]);
-                }
-            }
-            SerializationUtils::skipToNextLine(stream);
-        } else {
-            SerializationUtils::skipToNextLine(stream);
-            continue;
-        }
+    std::vector<MeshUtils::OBJCorner> corners;
+    corners.reserve(data.corners.size());
+    for (size_t i = 0; i + 3 <= data.corners.size(); i += 3) {
+        const MeshUtils::OBJCorner* triangle = &data.corners[i];
+        if (triangle[0].position >= 0 && triangle[1].position >= 0 && triangle[2].position >= 0)
+            corners.insert(corners.end(), triangle, triangle + 3);
     }
 
-    mNumVertices = positions.size();
+    std::vector<MeshUtils::OBJCorner> vertices;
+    std::vector<unsigned int> indices;
+    MeshUtils::weldCorners(corners, vertices, indices);
+
+    mNumVertices = vertices.size();
     mNumIndices = indices.size();
+    mNumOBJCorners = corners.size();
 
+    std::vector<glm::vec3> positions(mNumVertices);
     std::vector<glm::vec2> uvs(mNumVertices);
-    for (size_t i = 0; i < indices.size(); i++) {
-        unsigned int vi = indices[i];
-        unsigned int ti = texIndices[i];
-        uvs[vi] = uvsSoft[ti];
-    }
-
     std::vector<glm::vec3> normals(mNumVertices);
-    for (size_t i = 0; i < indices.size(); i++) {
-        unsigned int vi = indices[i];
-        unsigned int ni = normIndices[i];
-        normals[vi] = normalsSoft[ni];
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const MeshUtils::OBJCorner& vertex = vertices[i];
+        positions[i] = data.positions[vertex.position];
+        if (vertex.uv >= 0)
+            uvs[i] = data.uvs[vertex.uv];
+        if (vertex.normal >= 0)
+            normals[i] = data.normals[vertex.normal];
     }
 
     mType = Mesh::Type::Triangles;
 
-    mIndices = indices;
+    mIndices = std::move(indices);
 
     Attribute& posAttr = mAttributes.emplace_back();
     posAttr.binding = 0;
-    posAttr.data = positions;
+    posAttr.data = std::move(positions);
     posAttr.name = "position";
 
     Attribute& uvAttr = mAttributes.emplace_back();
     uvAttr.binding = 1;
-    uvAttr.data = uvs;
+    uvAttr.data = std::move(uvs);
     uvAttr.name = "uv";
 
     Attribute& normAttr = mAttributes.emplace_back();
     normAttr.binding = 2;
-    normAttr.data = normals;
+    normAttr.data = std::move(normals);
     normAttr.name = "normal";
 }
 
@@ -258,8 +273,13 @@ void MeshNode::loadFromStreamMSH(std::ifstream& stream) {
         }
 
         if (name == "i") {
-            for (unsigned int i = 0; i < mNumIndices; i++)
+            for (unsigned int i = 0; i < mNumIndices; i++) {
                 stream >> mIndices[i];
+                if (mIndices[i] >= mNumVertices) {
+                    clearMesh();
+                    return;
+                }
+            }
             continue;
         }
 
@@ -294,17 +314,120 @@ void MeshNode::loadFromStreamMSH(std::ifstream& stream) {
     }
 }
 
-void MeshNode::writeToFile(const std::filesystem::path& filename) const {
-    std::ofstream stream(filename);
-    writeToStreamMSH(stream);
+void MeshNode::loadFromFileMSHB() {
+    mMappedFile = std::make_unique<MappedFile>(mFilepath);
+    std::string_view contents = mMappedFile->view();
+
+    mshb::Header header{};
+    if (contents.size() < sizeof(header) || std::memcmp(contents.data(), mshb::cMAGIC, sizeof(mshb::cMAGIC)) != 0) {
+        clearMesh();
+        return;
+    }
+    std::memcpy(&header, contents.data(), sizeof(header));
+
+    const auto isInFile = [&contents](uint64_t offset, uint64_t size) {
+        return offset % mshb::cARRAY_ALIGNMENT == 0 && offset <= contents.size() && size <= contents.size() - offset;
+    };
+    if (header.version != mshb::cVERSION || header.type >= (uint32_t)Mesh::Type::Max ||
+        !isInFile(mshb::align(sizeof(header)), (uint64_t)header.numAttributes * sizeof(mshb::AttributeRecord)) ||
+        (header.numIndices > 0 && !isInFile(header.indexOffset, (uint64_t)header.numIndices * sizeof(unsigned int)))) {
+        clearMesh();
+        return;
+    }
+
+    mNumVertices = header.numVertices;
+    mNumIndices = header.numIndices;
+    mType = (Mesh::Type)header.type;
+    mMappedIndices = mNumIndices > 0 ? (const unsigned int*)(contents.data() + header.indexOffset) : nullptr;
+    for (unsigned int i = 0; i < mNumIndices; i++) {
+        if (mMappedIndices[i] >= mNumVertices) {
+            clearMesh();
+            return;
+        }
+    }
+
+    const auto* records = (const mshb::AttributeRecord*)(contents.data() + mshb::align(sizeof(header)));
+    for (uint32_t i = 0; i < header.numAttributes; i++) {
+        const mshb::AttributeRecord& record = records[i];
+        if (record.length < 1 || record.length > 4 || (record.dataType != 'i' && record.dataType != 'f') ||
+            !isInFile(record.offset, (uint64_t)mNumVertices * record.length * sizeof(float))) {
+            clearMesh();
+            return;
+        }
+
+        Attribute& attribute = mAttributes.emplace_back();
+        attribute.binding = record.binding;
+        attribute.data = createAttributeDataset(record.length, (char)record.dataType);
+        attribute.name = std::string(record.name, strnlen(record.name, sizeof(record.name)));
+        attribute.mappedData = contents.data() + record.offset;
+    }
 }
 
-void MeshNode::writeToStreamMSH(std::ofstream& stream) const {
-    stream << "# GLSandbox MSH File: " << mFilepath << "\n";
+MeshNode::FileContents MeshNode::makeFileContents(const std::filesystem::path& filepath) const {
+    FileContents contents;
+    contents.filepath = filepath;
+    contents.numVertices = mNumVertices;
+    contents.numIndices = mNumIndices;
+    contents.type = mType;
+    contents.attributes = mAttributes;
+    for (auto& attribute : contents.attributes) {
+        if (!attribute.mappedData)
+            continue;
+        std::visit([&attribute, this](auto& data) {
+            using value_t = typename std::decay_t<decltype(data)>::value_type;
+            const auto* values = (const value_t*)attribute.mappedData;
+            data.assign(values, values + mNumVertices);
+        }, attribute.data);
+        attribute.mappedData = nullptr;
+    }
+    const unsigned int* indices = mMappedIndices ? mMappedIndices : mIndices.data();
+    contents.indices.assign(indices, indices + mNumIndices);
+    return contents;
+}
 
-    stream << mNumVertices << " " << mNumIndices << " " << (unsigned int)mType << "\n";
+void MeshNode::writeToFile(const std::filesystem::path& filepath) const {
+    waitForPendingWrite();
+    if (writeFileContents(makeFileContents(filepath))) {
+        mWrittenPath = filepath;
+        mWrittenVersion = mContentVersion;
+    }
+}
 
-    for (const auto& attribute : mAttributes) {
+void MeshNode::writeToFileAsync(const std::filesystem::path& filepath) const {
+    waitForPendingWrite();
+    mWrittenPath = filepath;
+    mWrittenVersion = mContentVersion;
+    mPendingWrite = std::async(std::launch::async, [contents = makeFileContents(filepath)]() {
+        return writeFileContents(contents);
+    });
+}
+
+void MeshNode::waitForPendingWrite() const {
+    if (mPendingWrite.valid() && !mPendingWrite.get())
+        mWrittenPath.clear();
+}
+
+bool MeshNode::needsWrite(const std::filesystem::path& filepath) const {
+    waitForPendingWrite();
+    return mContentVersion != mWrittenVersion || filepath != mWrittenPath || !std::filesystem::exists(filepath);
+}
+
+bool MeshNode::writeFileContents(const FileContents& contents) {
+    const bool binary = contents.filepath.extension() == std::string(".").append(getMeshBinaryExtension());
+    return FileUtils::writeFileAtomic(contents.filepath, binary, [&contents, binary](std::ostream& stream) {
+        if (binary)
+            writeToStreamMSHB(stream, contents);
+        else
+            writeToStreamMSH(stream, contents);
+    });
+}
+
+void MeshNode::writeToStreamMSH(std::ostream& stream, const FileContents& contents) {
+    stream << "# GLSandbox MSH File: " << contents.filepath << "\n";
+
+    stream << contents.numVertices << " " << contents.numIndices << " " << (unsigned int)contents.type << "\n";
+
+    for (const auto& attribute : contents.attributes) {
         stream << attribute.name << " ";
 
         std::visit(VisitOverload{
@@ -323,16 +446,16 @@ void MeshNode::writeToStreamMSH(std::ofstream& stream) const {
         stream << " " << attribute.binding << "\n";
 
         std::visit(VisitOverload{
-            [&stream, this](const std::vector<int>& data) {
-                for (unsigned int i = 0; i < mNumVertices; i++)
+            [&stream, &contents](const std::vector<int>& data) {
+                for (unsigned int i = 0; i < contents.numVertices; i++)
                     stream << data[i] << "\n";
             },
-            [&stream, this](const std::vector<float>& data) {
-                for (unsigned int i = 0; i < mNumVertices; i++)
+            [&stream, &contents](const std::vector<float>& data) {
+                for (unsigned int i = 0; i < contents.numVertices; i++)
                     stream << data[i] << "\n";
             },
-            [&stream, this](const auto& data) {
-                for (unsigned int i = 0; i < mNumVertices; i++) {
+            [&stream, &contents](const auto& data) {
+                for (unsigned int i = 0; i < contents.numVertices; i++) {
                     stream << data[i][0];
                     for (unsigned int j = 1; j < data[i].length(); j++)
                         stream << " " << data[i][j];
@@ -341,14 +464,80 @@ void MeshNode::writeToStreamMSH(std::ofstream& stream) const {
             },
         }, attribute.data);
     }
-    if (mNumIndices > 0) {
+    if (contents.numIndices > 0) {
         stream << "i\n";
-        for (unsigned int index : mIndices) {
-            stream << index << "\n";
+        for (unsigned int i = 0; i < contents.numIndices; i++) {
+            stream << contents.indices[i] << "\n";
         }
     }
 }
 
+void MeshNode::writeToStreamMSHB(std::ostream& stream, const FileContents& contents) {
+    mshb::Header header{};
+    std::memcpy(header.magic, mshb::cMAGIC, sizeof(header.magic));
+    header.version = mshb::cVERSION;
+    header.numVertices = contents.numVertices;
+    header.numIndices = contents.numIndices;
+    header.type = (uint32_t)contents.type;
+    header.numAttributes = (uint32_t)contents.attributes.size();
+
+    std::vector<mshb::AttributeRecord> records(contents.attributes.size());
+    std::vector<std::pair<const void*, uint64_t>> arrays(contents.attributes.size());
+    uint64_t offset = mshb::align(sizeof(header)) + records.size() * sizeof(mshb::AttributeRecord);
+    for (size_t i = 0; i < contents.attributes.size(); i++) {
+        const Attribute& attribute = contents.attributes[i];
+        mshb::AttributeRecord& record = records[i];
+        std::strncpy(record.name, attribute.name.c_str(), mshb::cMAX_NAME_LENGTH);
+        record.binding = attribute.binding;
+        std::visit([&record, &arrays, &contents, i](const auto& data) {
+            using value_t = typename std::decay_t<decltype(data)>::value_type;
+            using component_t = typename mshb::Component<value_t>::type;
+            record.length = (uint32_t)(sizeof(value_t) / sizeof(component_t));
+            record.dataType = std::is_floating_point_v<component_t> ? 'f' : 'i';
+            arrays[i] = {data.data(), (uint64_t)contents.numVertices * sizeof(value_t)};
+        }, attribute.data);
+        offset = mshb::align(offset);
+        record.offset = offset;
+        offset += arrays[i].second;
+    }
+    header.indexOffset = contents.numIndices > 0 ? mshb::align(offset) : 0;
+
+    uint64_t written = 0;
+    const auto writeArray = [&stream, &written](uint64_t arrayOffset, const void* data, uint64_t size) {
+        static constexpr char cPADDING[mshb::cARRAY_ALIGNMENT] = {};
+        stream.write(cPADDING, (std::streamsize)(arrayOffset - written));
+        stream.write((const char*)data, (std::streamsize)size);
+        written = arrayOffset + size;
+    };
+    writeArray(0, &header, sizeof(header));
+    writeArray(mshb::align(sizeof(header)), records.data(), records.size() * sizeof(mshb::AttributeRecord));
+    for (size_t i = 0; i < records.size(); i++)
+        writeArray(records[i].offset, arrays[i].first, arrays[i].second);
+    if (contents.numIndices > 0)
+        writeArray(header.indexOffset, contents.indices.data(), (uint64_t)contents.numIndices * sizeof(unsigned int));
+}
+
+void MeshNode::materializeMappedData() {
+    if (!mMappedFile)
+        return;
+
+    for (auto& attribute : mAttributes) {
+        if (!attribute.mappedData)
+            continue;
+        std::visit([&attribute, this](auto& data) {
+            using value_t = typename std::decay_t<decltype(data)>::value_type;
+            const auto* values = (const value_t*)attribute.mappedData;
+            data.assign(values, values + mNumVertices);
+        }, attribute.data);
+        attribute.mappedData = nullptr;
+    }
+    if (mMappedIndices) {
+        mIndices.assign(mMappedIndices, mMappedIndices + mNumIndices);
+        mMappedIndices = nullptr;
+    }
+    mMappedFile = nullptr;
+}
+
 std::filesystem::path MeshNode::generateFilename() {
     return SerializationUtils::generateFilename(getMeshAssetDirectory(), "Mesh", getMeshDefaultExtension());
 }
@@ -356,26 +545,85 @@ std::filesystem::path MeshNode::generateFilename() {
 void MeshNode::uploadMesh() {
     mMesh->hardClean();
     mMesh->setType(mType);
+    mMesh->setLayout(mLayout);
     mMesh->setNumVertices(mNumVertices);
-    mMesh->setIndices(mIndices);
+    mMesh->setIndices(mMappedIndices ? mMappedIndices : mIndices.data(), mNumIndices);
     for (const auto& attr : mAttributes) {
         std::visit(VisitOverload{
             [&attr, this](const std::vector<int>& data) {
                 using type = std::decay_t<decltype(data)>;
-                mMesh->addAttribute(data.data(), 1, sizeof(int), attr.binding, attr.name);
+                mMesh->addAttribute(attr.mappedData ? attr.mappedData : data.data(), 1, sizeof(int), attr.binding, attr.name);
             },
             [&attr, this](const std::vector<float>& data) {
                 using type = std::decay_t<decltype(data)>;
-                mMesh->addAttribute(data.data(), 1, sizeof(float), attr.binding, attr.name);
+                mMesh->addAttribute(attr.mappedData ? attr.mappedData : data.data(), 1, sizeof(float), attr.binding, attr.name,
+                                    attr.format);
             },
             [&attr, this](const auto& data) {
                 using type = std::decay_t<decltype(data)>;
-                mMesh->addAttribute(data.data(), type::value_type::length(), sizeof(typename type::value_type), attr.binding, attr.name);
+                mMesh->addAttribute(attr.mappedData ? attr.mappedData : data.data(), type::value_type::length(),
+                                    sizeof(typename type::value_type), attr.binding, attr.name,
+                                    isFloatAttr(attr.data) ? attr.format : Mesh::StorageFormat::Float);
             },
         }, attr.data);
     }
 
     mMesh->bufferData();
+
+    int uvBinding;
+    if (isScreenQuad(uvBinding))
+        mMesh->setScreenQuad(uvBinding);
+}
+
+bool MeshNode::isScreenQuad(int& uvBinding) const {
+    if (mType != Mesh::Type::TriangleStrip || mNumVertices != 4 || mNumIndices != 0)
+        return false;
+
+    // First four components of each vertex of every float vector attribute (padded with 0)
+    std::vector<std::pair<const Attribute*, std::array<glm::vec4, 4>>> vectors{};
+    for (const auto& attribute : mAttributes) {
+        std::visit([&](const auto& data) {
+            using value_t = typename std::decay_t<decltype(data)>::value_type;
+            if constexpr (std::is_same_v<value_t, glm::vec2> || std::is_same_v<value_t, glm::vec3> ||
+                          std::is_same_v<value_t, glm::vec4>) {
+                const value_t* values = attribute.mappedData ? (const value_t*)attribute.mappedData : data.data();
+                std::array<glm::vec4, 4>& vertices = vectors.emplace_back(&attribute,
+                                                                          std::array<glm::vec4, 4>{}).second;
+                for (int i = 0; i < 4; i++)
+                    for (int j = 0; j < value_t::length(); j++)
+                        vertices[i][j] = values[i][j];
+            }
+        }, attribute.data);
+    }
+
+    auto position = std::find_if(vectors.begin(), vectors.end(), [](const auto& vector) {
+        return vector.first->binding == 0;
+    });
+    if (position == vectors.end())
+        return false;
+    const std::array<glm::vec4, 4>& corners = position->second;
+    for (const glm::vec4& corner : corners)
+        if (std::abs(corner.x) != 1.0f || std::abs(corner.y) != 1.0f || std::abs(corner.z) > 1.0f)
+            return false;
+    // Both triangles of the strip share the diagonal between the middle two vertices, so the first and last (and the
+    // middle two) must be opposite corners
+    const auto xy = [&corners](int i) { return glm::vec2(corners[i]); };
+    if (xy(0) != -xy(3) || xy(1) != -xy(2) || xy(0) == xy(1) || xy(0) == xy(2))
+        return false;
+
+    uvBinding = -1;
+    for (const auto& [attribute, vertices] : vectors) {
+        if (!std::holds_alternative<std::vector<glm::vec2>>(attribute->data) || attribute->binding == 0)
+            continue;
+        bool isUV = true;
+        for (int i = 0; i < 4; i++)
+            isUV &= glm::vec2(vertices[i]) == xy(i) * 0.5f + 0.5f;
+        if (isUV) {
+            uvBinding = (int)attribute->binding;
+            break;
+        }
+    }
+    return true;
 }
 
 void MeshNode::drawGlobalParameters() {
@@ -385,9 +633,21 @@ void MeshNode::drawGlobalParameters() {
     if (ImUtils::button("Load", generateNodeLabelID("LoadButton")))
         loadFromFile();
 
+    drawSaveButton();
+
     if (mFromOBJ && ImUtils::button("Build Tangents", generateNodeLabelID("GenerateTangents")))
         generateTangents();
 
+    if (ImUtils::button("Optimize", generateNodeLabelID("Optimize"))) {
+        optimizeMesh();
+        uploadMesh();
+    }
+    ImGui::SameLine();
+    if (ImUtils::toggleButton(mOptimizeOnImport, "On Import", "On Import", generateNodeLabelID("OptimizeOnImport")))
+        markDirty();
+    if (!mOptimizeReport.empty())
+        ImGui::TextUnformatted(mOptimizeReport.c_str());
+
     ImGui::Text("Vertex Count:");
     if (ImUtils::inputInt((int*)&mNumVertices, generateNodeLabelID("NumVertices"), 1, INT_MAX)) {
         mNumVertices = std::max(mNumVertices, 1u);
@@ -395,19 +655,47 @@ void MeshNode::drawGlobalParameters() {
     }
 
     ImGui::Text("Primitive Type:");
-    ImUtils::cycleButton(generateNodeLabelID("PrimitiveType"), (size_t&)mType, (size_t)Mesh::Type::Max,
-                         [](size_t index) { return getPrimitiveTypeLabel((Mesh::Type)index); });
+    if (ImUtils::cycleButton(generateNodeLabelID("PrimitiveType"), (size_t&)mType, (size_t)Mesh::Type::Max,
+                             [](size_t index) { return getPrimitiveTypeLabel((Mesh::Type)index); }))
+        markContentChanged();
+
+    ImGui::Text("Vertex Layout:");
+    if (ImUtils::cycleButton(generateNodeLabelID("VertexLayout"), (size_t&)mLayout, (size_t)Mesh::Layout::Max,
+                             [](size_t index) { return getLayoutLabel((Mesh::Layout)index); }))
+        markDirty();
+}
+
+void MeshNode::drawSaveButton() {
+    if (!ImUtils::button("Save", generateNodeLabelID("SaveButton")))
+        return;
+
+    std::filesystem::path filepath = mFilepath;
+    if (!FileUtils::openSaveDialog(filepath, getMeshAssetDirectory(), getValidMeshFileExtensions()))
+        return;
+    if (filepath.extension() != std::string(".").append(getMeshDefaultExtension()) &&
+        filepath.extension() != std::string(".").append(getMeshBinaryExtension()))
+        filepath += std::string(".").append(getMeshDefaultExtension());
+
+    writeToFile(filepath);
+    if (mFromOBJ || filepath != mFilepath) {
+        materializeMappedData();
+        mFilepath = filepath;
+        mFromOBJ = false;
+        markDirty();
+    }
 }
 
 void MeshNode::drawAttributes() {
     for (auto& attribute : mAttributes)
         drawAttribute(attribute);
 
-    mAttributes.erase(
-        std::remove_if(mAttributes.begin(), mAttributes.end(),
-            [](const auto& attr) { return attr.isMarkedDelete; }
-        ), mAttributes.end()
+    const auto removed = std::remove_if(mAttributes.begin(), mAttributes.end(),
+        [](const auto& attr) { return attr.isMarkedDelete; }
     );
+    if (removed != mAttributes.end()) {
+        mAttributes.erase(removed, mAttributes.end());
+        markContentChanged();
+    }
 
     if (mNumIndices == 0)
         return;
@@ -418,7 +706,8 @@ void MeshNode::drawAttributes() {
 
             ImGui::TextUnformatted("Data:");
             for (unsigned int i = 0; i < mNumIndices; i++)
-                ImUtils::inputInt((int*)&mIndices[i], generateNodeLabelID("Index", i), 0, INT_MAX);
+                if (ImUtils::inputInt((int*)&mIndices[i], generateNodeLabelID("Index", i), 0, INT_MAX))
+                    markContentChanged();
         }
     );
 }
@@ -432,43 +721,60 @@ void MeshNode::drawAttribute(Attribute& attribute) {
                 return;
             }
 
-            ImUtils::inputText(attribute.name, generateAttributeLabelID(attribute, "Name"));
+            if (ImUtils::inputText(attribute.name, generateAttributeLabelID(attribute, "Name")))
+                markContentChanged();
             if (ImGui::IsItemHovered())
                 ImUtils::postTooltip([]() { ImGui::TextUnformatted("Attribute Name"); });
 
             ImGui::TextUnformatted("Binding");
-            ImUtils::inputInt((int*)&attribute.binding, generateAttributeLabelID(attribute, "Binding"), 0, INT_MAX);
+            if (ImUtils::inputInt((int*)&attribute.binding, generateAttributeLabelID(attribute, "Binding"), 0, INT_MAX))
+                markContentChanged();
+
+            if (isFloatAttr(attribute.data)) {
+                ImGui::TextUnformatted("Storage Format");
+                const size_t previous = (size_t)attribute.format, max = (size_t)Mesh::StorageFormat::Max;
+                if (ImUtils::cycleButton(generateAttributeLabelID(attribute, "StorageFormat"), (size_t&)attribute.format,
+                                         max, [](size_t index) { return getStorageFormatLabel((Mesh::StorageFormat)index); })) {
+                    const bool forward = (size_t)attribute.format == (previous + 1) % max;
+                    while (!Mesh::isStorageFormatValid(attribute.format, getAttrLength(attribute.data)))
+                        attribute.format = (Mesh::StorageFormat)((forward ? (size_t)attribute.format + 1
+                                                                          : (size_t)attribute.format + max - 1) % max);
+                    markDirty();
+                }
+            }
 
             ImGui::TextUnformatted("Data:");
             for (unsigned int i = 0; i < mNumVertices; i++) {
                 const std::string valueInputLabel = generateAttributeLabelID(attribute, "Value", std::to_string(i));
-                std::visit(VisitOverload{
+                const bool changed = std::visit(VisitOverload{
                     [valueInputLabel, i](std::vector<int>& data) {
-                        ImUtils::inputIntN(&data[i], 1, valueInputLabel);
+                        return ImUtils::inputIntN(&data[i], 1, valueInputLabel);
                     },
                     [valueInputLabel, i](std::vector<glm::ivec2>& data) {
-                        ImUtils::inputIntN(&data[i][0], 2, valueInputLabel);
+                        return ImUtils::inputIntN(&data[i][0], 2, valueInputLabel);
                     },
                     [valueInputLabel, i](std::vector<glm::ivec3>& data) {
-                        ImUtils::inputIntN(&data[i][0], 3, valueInputLabel);
+                        return ImUtils::inputIntN(&data[i][0], 3, valueInputLabel);
                     },
                     [valueInputLabel, i](std::vector<glm::ivec4>& data) {
-                        ImUtils::inputIntN(&data[i][0], 4, valueInputLabel);
+                        return ImUtils::inputIntN(&data[i][0], 4, valueInputLabel);
                     },
                     [valueInputLabel, i](std::vector<float>& data) {
-                        ImUtils::inputFloatN(&data[i], 1, valueInputLabel);
+                        return ImUtils::inputFloatN(&data[i], 1, valueInputLabel);
                     },
                     [valueInputLabel, i](std::vector<glm::vec2>& data) {
-                        ImUtils::inputFloatN(&data[i][0], 2, valueInputLabel);
+                        return ImUtils::inputFloatN(&data[i][0], 2, valueInputLabel);
                     },
                     [valueInputLabel, i](std::vector<glm::vec3>& data) {
-                        ImUtils::inputFloatN(&data[i][0], 3, valueInputLabel);
+                        return ImUtils::inputFloatN(&data[i][0], 3, valueInputLabel);
                     },
                     [valueInputLabel, i](std::vector<glm::vec4>& data) {
-                        ImUtils::inputFloatN(&data[i][0], 4, valueInputLabel);
+                        return ImUtils::inputFloatN(&data[i][0], 4, valueInputLabel);
                     },
-                    [](auto arg) { ImGui::Text("Undefined"); },
+                    [](auto arg) { ImGui::Text("Undefined"); return false; },
                 }, attribute.data);
+                if (changed)
+                    markContentChanged();
             }
         }
     );
@@ -487,6 +793,7 @@ void MeshNode::drawAddAttributePopup() {
         attribute.binding = mAttributes.size();
         attribute.data = generateAttributeDataset(type);
         std::visit([this](auto& data) { data.resize(mNumVertices); }, attribute.data);
+        markContentChanged();
     }
 
     ImUtils::endHeader();
@@ -508,14 +815,38 @@ void MeshNode::drawMeshStatus() {
     }
 
     drawMessage(text, colour);
+
+    if (mNumOBJCorners > 0)
+        ImGui::Text("Welded %u corners to %u vertices (%.2fx)", mNumOBJCorners, mNumVertices,
+                    (float)mNumOBJCorners / (float)std::max(mNumVertices, 1u));
+
+    drawVertexSize();
+}
+
+void MeshNode::drawVertexSize() {
+    size_t vertexSize = 0, fullVertexSize = 0;
+    for (const auto& attribute : mAttributes) {
+        const int length = getAttrLength(attribute.data);
+        vertexSize += Mesh::getStorageSize(attribute.format, length);
+        fullVertexSize += Mesh::getStorageSize(Mesh::StorageFormat::Float, length);
+    }
+    ImGui::Text("Bytes per vertex: %zu (%zu at full precision)", vertexSize, fullVertexSize);
+
+    if (mNumIndices > 0) {
+        ImGui::Text("Index size: %zu-bit", Mesh::getIndexSize(mNumVertices) * 8);
+    }
 }
 
 void MeshNode::resizeAttributes() {
+    materializeMappedData();
     for (auto& attribute : mAttributes)
         std::visit([this](auto& data) { data.resize(mNumVertices); }, attribute.data);
+    markContentChanged();
 }
 
 void MeshNode::generateTangents() {
+    materializeMappedData();
+
     Attribute* posAttr = nullptr;
     Attribute* uvAttr = nullptr;
 
@@ -562,6 +893,7 @@ void MeshNode::generateTangents() {
     tanAttr.binding = 3;
     tanAttr.data = tangents;
     tanAttr.name = "tangent";
+    markContentChanged();
 
     uploadMesh();
 
@@ -571,9 +903,56 @@ void MeshNode::generateTangents() {
     mFromOBJ = false;
 }
 
+void MeshNode::optimizeMesh() {
+    if (mType != Mesh::Type::Triangles || mNumIndices < 3)
+        return;
+
+    materializeMappedData();
+    for (unsigned int index : mIndices)
+        if (index >= mNumVertices)
+            return;
+
+    mIndices.resize(mNumIndices - mNumIndices % 3);
+    mNumIndices = mIndices.size();
+
+    const glm::vec3* positions = nullptr;
+    for (const auto& attribute : mAttributes) {
+        const auto* data = std::get_if<std::vector<glm::vec3>>(&attribute.data);
+        if (attribute.name == "position" && data)
+            positions = data->data();
+    }
+
+    MeshUtils::VertexCacheStats before = MeshUtils::analyzeVertexCache(mIndices, mNumVertices);
+
+    MeshUtils::optimizeVertexCache(mIndices, mNumVertices);
+    if (positions)
+        MeshUtils::optimizeOverdraw(mIndices, positions, mNumVertices);
+    std::vector<unsigned int> remap = MeshUtils::optimizeVertexFetch(mIndices, mNumVertices);
+
+    for (auto& attribute : mAttributes) {
+        std::visit([&remap, this](auto& data) {
+            auto remapped = data;
+            for (unsigned int i = 0; i < mNumVertices; i++)
+                remapped[remap[i]] = data[i];
+            data = std::move(remapped);
+        }, attribute.data);
+    }
+
+    MeshUtils::VertexCacheStats after = MeshUtils::analyzeVertexCache(mIndices, mNumVertices);
+    markContentChanged();
+
+    char report[128];
+    std::snprintf(report, sizeof(report), "ACMR %.3f -> %.3f\nATVR %.3f -> %.3f", before.acmr, after.acmr,
+                  before.atvr, after.atvr);
+    mOptimizeReport = report;
+}
+
 void MeshNode::clearMesh() {
     mNumVertices = 1;
     mNumIndices = 0;
+    mNumOBJCorners = 0;
+
+    mOptimizeReport.clear();
 
     mType = Mesh::Type::Triangles;
 
@@ -583,4 +962,7 @@ void MeshNode::clearMesh() {
 void MeshNode::clearAttributes() {
     mAttributes.clear();
     mIndices.clear();
+
+    mMappedIndices = nullptr;
+    mMappedFile = nullptr;
 }
@@ -5,6 +5,7 @@
 
 #include "../../Rendering/Mesh.h"
 
+#include "../../Utils/FileUtils.h"
 #include "../../Utils/VariantUtils.h"
 
 #include "../Assets.h"
@@ -16,6 +17,7 @@
 
 #include <any>
 #include <functional>
+#include <future>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -31,7 +33,7 @@ public:
     }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void onDeserialize() final;
 
@@ -50,22 +52,76 @@ private:
         unsigned int binding = 0;
 
         VectorVariant<Mesh::attribute_t> data;
+        /**
+         * @brief Attribute values still held in MeshNode::mMappedFile, or nullptr once they have been copied into data.
+         * While set, data holds the attribute type but no values.
+         */
+        const void* mappedData = nullptr;
+
+        /**
+         * @brief Format to store the attribute in on the GPU. Only applies to float attributes.
+         */
+        Mesh::StorageFormat format = Mesh::StorageFormat::Float;
 
         bool isMarkedDelete = false;
         bool show = false;
     };
 
     void loadFromFile();
-    void loadFromStreamOBJ(std::ifstream& stream);
+    void loadFromFileOBJ();
     void loadFromStreamMSH(std::ifstream& stream);
-    void writeToFile(const std::filesystem::path& filename) const;
-    void writeToStreamMSH(std::ofstream& stream) const;
+    /**
+     * @brief Map a binary mesh file, referencing its attribute and index arrays in place rather than copying them.
+     */
+    void loadFromFileMSHB();
+    /**
+     * @brief Copy of everything written to a mesh file, so it can be written without touching the node.
+     */
+    struct FileContents {
+        std::filesystem::path filepath;
+        unsigned int numVertices = 0;
+        unsigned int numIndices = 0;
+        Mesh::Type type = Mesh::Type::Triangles;
+        std::vector<Attribute> attributes;
+        std::vector<unsigned int> indices;
+    };
+
+    [[nodiscard]] FileContents makeFileContents(const std::filesystem::path& filepath) const;
+    void writeToFile(const std::filesystem::path& filepath) const;
+    /**
+     * @brief Snapshot the mesh and write it on a background thread. Only one write is in flight per node, so any
+     * previous write is waited on first.
+     */
+    void writeToFileAsync(const std::filesystem::path& filepath) const;
+    void waitForPendingWrite() const;
+    /**
+     * @returns true if the mesh has changed since it was last written to (or read from) filepath, otherwise false.
+     */
+    [[nodiscard]] bool needsWrite(const std::filesystem::path& filepath) const;
+    static bool writeFileContents(const FileContents& contents);
+    static void writeToStreamMSH(std::ostream& stream, const FileContents& contents);
+    static void writeToStreamMSHB(std::ostream& stream, const FileContents& contents);
+
+    inline void markContentChanged() {
+        mContentVersion++;
+    }
+
+    /**
+     * @brief Copy any data still referenced from a mapped file into attribute/index storage, so it can be edited.
+     */
+    void materializeMappedData();
 
     [[nodiscard]] static std::filesystem::path generateFilename() ;
 
     void uploadMesh();
+    /**
+     * @returns true if this mesh is a quad covering the whole viewport (see Mesh::setScreenQuad()), setting uvBinding
+     * to the binding of its texture coordinates (or -1 if it has none).
+     */
+    [[nodiscard]] bool isScreenQuad(int& uvBinding) const;
 
     void drawGlobalParameters();
+    void drawSaveButton();
 
     void drawAttributes();
     void drawAttribute(Attribute& attribute);
@@ -73,10 +129,16 @@ private:
     void drawAddAttributePopup();
 
     void drawMeshStatus();
+    void drawVertexSize();
 
     void resizeAttributes();
 
     void generateTangents();
+    /**
+     * @brief Reorder triangles for vertex cache reuse and overdraw, then reorder vertices for fetch locality.
+     * Only applies to indexed triangle lists.
+     */
+    void optimizeMesh();
 
     void clearMesh();
     void clearAttributes();
@@ -116,6 +178,23 @@ private:
             [](const std::vector<glm::vec4>& arg ) { return "Vec4";  },
         }, attr);
     }
+    static inline int getAttrLength(const VectorVariant<Mesh::attribute_t>& attr) {
+        return std::visit(VisitOverload{
+            [](const std::vector<int>&  ) { return 1; },
+            [](const std::vector<float>&) { return 1; },
+            [](const auto& arg          ) { return (int)std::decay_t<decltype(arg)>::value_type::length(); },
+        }, attr);
+    }
+    static inline bool isFloatAttr(const VectorVariant<Mesh::attribute_t>& attr) {
+        return std::visit(VisitOverload{
+            [](const auto&                  ) { return false; },
+
+            [](const std::vector<float>&    ) { return true; },
+            [](const std::vector<glm::vec2>&) { return true; },
+            [](const std::vector<glm::vec3>&) { return true; },
+            [](const std::vector<glm::vec4>&) { return true; },
+        }, attr);
+    }
     static inline std::size_t getAttrSize(Mesh::attribute_t attr) {
         return std::visit(VisitOverload{
             [](int arg       ) { return 1; },
@@ -173,24 +252,67 @@ private:
             case Mesh::Type::Points        : return "Points";
         }
     }
+    static inline std::string getLayoutLabel(Mesh::Layout layout) {
+        switch (layout) {
+            default: return "Undefined";
+            case Mesh::Layout::Separate    : return "Separate";
+            case Mesh::Layout::Interleaved : return "Interleaved";
+        }
+    }
+    static inline std::string getStorageFormatLabel(Mesh::StorageFormat format) {
+        switch (format) {
+            default: return "Undefined";
+            case Mesh::StorageFormat::Float   : return "Float (32-bit)";
+            case Mesh::StorageFormat::Half    : return "Half (16-bit)";
+            case Mesh::StorageFormat::Snorm10 : return "Snorm 10_10_10_2";
+            case Mesh::StorageFormat::Snorm8  : return "Snorm 8-bit";
+        }
+    }
 
     std::unique_ptr<Mesh> mMesh;
     Port<Mesh*> mMeshOut = Port<Mesh*>(*this, IPort::Direction::Out, "MeshOut", "Mesh", [&]() { return mMesh.get(); });
 
     unsigned int mNumVertices = 1;
     unsigned int mNumIndices = 0;
+    /**
+     * @brief Number of face corners read from the source OBJ file before welding, or 0 if not imported from OBJ.
+     */
+    unsigned int mNumOBJCorners = 0;
 
     Mesh::Type mType = Mesh::Type::Triangles;
+    Mesh::Layout mLayout = Mesh::Layout::Separate;
+    /**
+     * @brief Storage formats read during deserialization, applied (in attribute order) once the file has been loaded.
+     */
+    std::vector<Mesh::StorageFormat> mPendingStorageFormats;
 
     std::vector<Attribute> mAttributes;
     std::vector<unsigned int> mIndices{};
 
+    std::unique_ptr<MappedFile> mMappedFile = nullptr;
+    const unsigned int* mMappedIndices = nullptr;
+
     std::filesystem::path mFilepath;
     bool mCanWriteToFile = true;
 
+    /**
+     * @brief Incremented whenever anything written to the mesh file changes.
+     */
+    unsigned int mContentVersion = 0;
+    /**
+     * @brief Content version and path of the last file written or loaded, which need not be rewritten while the
+     * content version matches.
+     */
+    mutable unsigned int mWrittenVersion = 0;
+    mutable std::filesystem::path mWrittenPath;
+    mutable std::future<bool> mPendingWrite;
+
     bool mShowAttributes = false;
     bool mShowAddAttribute = false;
 
     bool mFromOBJ = false;
+
+    bool mOptimizeOnImport = false;
+    std::string mOptimizeReport;
 };
 
@@ -1,5 +1,8 @@
 #include "RenderPassNode.h"
 
+#include "../../Rendering/PassProfiler.h"
+#include "../../Rendering/ShaderFusion.h"
+
 #include "../../Utils/SerializationUtils.h"
 
 std::string getBlendFuncSrcLabel(RenderConfig::BlendFuncSrc srcFactor) {
@@ -63,6 +66,44 @@ std::string getDepthTestFuncLabel(RenderConfig::DepthTestFunc func) {
     }
 }
 
+/**
+ * @returns Reflected uniform of shader at location, or nullptr if there is none (or the uniform is not active).
+ */
+static const Shader::UniformInfo* findUniformAt(const Shader& shader, int location) {
+    if (location < 0)
+        return nullptr;
+    const std::vector<Shader::UniformInfo>& uniforms = shader.getUniformTable();
+    auto uniform = std::find_if(uniforms.begin(), uniforms.end(), [location](const Shader::UniformInfo& uniform) {
+        return uniform.location == location;
+    });
+    return uniform == uniforms.end() ? nullptr : &*uniform;
+}
+
+static bool isSampler(const Shader::UniformInfo& uniform) {
+    Shader::uniform_t value;
+    return Shader::generateUniform(uniform.type, value) && std::holds_alternative<Texture*>(value);
+}
+
+/**
+ * @brief Append a LoopIndex command for each int uniform of program named by loopIndexUniforms, where getName gives
+ * the name of a uniform within program.
+ */
+template<typename F>
+static void generateLoopIndices(CommandBuffer& commands, Shader& program,
+                                const std::vector<std::string>& loopIndexUniforms, F getName) {
+    for (std::size_t depth = loopIndexUniforms.size(); depth-- > 0;) {
+        const std::string& name = loopIndexUniforms[depth];
+        if (name.empty() || std::find(loopIndexUniforms.begin() + (std::ptrdiff_t)depth + 1, loopIndexUniforms.end(),
+                                      name) != loopIndexUniforms.end())
+            continue;
+        const Shader::UniformInfo* uniform = program.findUniform(getName(name));
+        Shader::uniform_t value;
+        if (uniform && uniform->blockIndex == -1 && Shader::generateUniform(uniform->type, value) &&
+            std::holds_alternative<int>(value))
+            commands.setLoopIndex(program, uniform->location, (std::uint32_t)depth);
+    }
+}
+
 RenderPassNode::RenderPassNode() : Node("Render Pass") {
     addPort(mExecutionIn);
     addPort(mExecutionOut);
@@ -72,6 +113,7 @@ RenderPassNode::RenderPassNode() : Node("Render Pass") {
     addPort(mShaderIn);
 
     mShaderIn.addOnUpdateEvent([this]() { onShaderUpdate(); });
+    mExecutionIn.addOnUnlinkEvent([this]() { mIsCulled = false; });
 }
 
 std::vector<std::pair<std::string, std::string>> RenderPassNode::generateSerializedData() const {
@@ -94,7 +136,7 @@ std::vector<std::pair<std::string, std::string>> RenderPassNode::generateSeriali
     return data;
 }
 
-void RenderPassNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void RenderPassNode::deserializeData(const std::string& dataID, std::istream& stream) {
     if (dataID == "Viewport") {
         SerializationUtils::deserializeData(stream, mViewport);
     } else if (dataID == "ClearColour") {
@@ -123,6 +165,7 @@ void RenderPassNode::deserializeData(const std::string& dataID, std::ifstream& s
 }
 
 void RenderPassNode::drawContents() {
+    drawTimings();
     drawSettings();
     drawValidationMessage();
 }
@@ -137,7 +180,10 @@ bool RenderPassNode::validate() const {
         mValidationState |= ValidationState::NoMesh;
     }
     if (mShaderIn.isLinked()) {
-        if (mShaderIn.getLinkedValue<Shader*>()->getState() != Shader::ErrorState::VALID)
+        Shader::ErrorState shaderState = mShaderIn.getLinkedValue<Shader*>()->getState();
+        if (shaderState == Shader::ErrorState::COMPILING)
+            mValidationState |= ValidationState::CompilingShader;
+        else if (shaderState != Shader::ErrorState::VALID)
             mValidationState |= ValidationState::InvalidShader;
     } else {
         mValidationState |= ValidationState::NoShader;
@@ -155,62 +201,193 @@ bool RenderPassNode::validate() const {
     return mValidationState == ValidationState::Unloaded;
 }
 
-RenderPassNode::pipeline_callback RenderPassNode::generateCallback() const {
+void RenderPassNode::generateCommands(CommandBuffer& commands, const std::vector<std::string>& loopIndexUniforms) const {
     mValidationState = ValidationState::Loaded;
+    mIsFused = false;
 
-    const Framebuffer* framebuffer = mFramebufferIn.isLinked() ? mFramebufferIn.getLinkedValue<Framebuffer*>() : nullptr;
+    Framebuffer* framebuffer = getFramebuffer();
     const Mesh* mesh = mMeshIn.getLinkedValue<Mesh*>();
-    const Shader* shader = mShaderIn.getLinkedValue<Shader*>();
+    Shader* shader = mShaderIn.getLinkedValue<Shader*>();
 
-    std::vector<std::function<void()>> passCallbacks{};
+    PassProfiler::registerPass(getID(), std::string(getName()).append(" ").append(std::to_string(getID())));
+    commands.beginTimer(getID());
 
-    bool useFramebuffer = framebuffer != nullptr;
+    if (framebuffer)
+        commands.bindFramebuffer(*framebuffer);
 
-    if (useFramebuffer)
-        passCallbacks.emplace_back([framebuffer]() { framebuffer->bind(); });
+    commands.useProgram(*shader);
+    if (!mUniformValues.empty())
+        commands.setUniforms(*shader, mUniformValues);
+    generateLoopIndices(commands, *shader, loopIndexUniforms, [](const std::string& name) { return name; });
 
-    passCallbacks.emplace_back([shader]() { shader->bind(); });
+    commands.setState(getRenderState());
 
-    passCallbacks.emplace_back([this]() {
-        if (mViewport == glm::vec4(0.0f))
-            RenderConfig::setViewport();
-        else
-            RenderConfig::setViewport(mViewport.x, mViewport.y, mViewport.z, mViewport.w);
+    const std::vector<Texture*> textures = getSampledTextures();
+    if (!textures.empty())
+        commands.bindTextures(textures);
+
+    commands.bindVAO(*mesh);
+    commands.draw(*mesh);
+
+    if (framebuffer)
+        commands.unbind();
+
+    commands.endTimer(getID());
+}
+
+void RenderPassNode::pullUniformValues() const {
+    for (const auto& pull : mUniformPulls)
+        pull();
+}
+
+int RenderPassNode::findFusedInput(const RenderPassNode& next) const {
+    const Framebuffer* framebuffer = getFramebuffer();
+    const Mesh* mesh = mMeshIn.getLinkedValue<Mesh*>();
+    if (!framebuffer || framebuffer->getAttachments().size() != 1 || !mesh || !mesh->isScreenQuad() ||
+        mesh != next.mMeshIn.getLinkedValue<Mesh*>())
+        return -1;
+    // Blending, depth testing or masking would make this pass's output depend on the existing contents of its target
+    if (mEnableBlend || mEnableDepthTest || mColourMask != glm::bvec4(true) || mViewport != next.mViewport ||
+        mEnableFaceCulling != next.mEnableFaceCulling || (mEnableFaceCulling && mCullFaceMode != next.mCullFaceMode))
+        return -1;
+
+    // Any other format would quantize or clamp values between the passes
+    const Texture* output = framebuffer->getAttachments().front().first;
+    if (output->getInternalFormat() != Texture::InternalFormat::RGBA32F)
+        return -1;
+
+    glm::vec2 targetSize = RenderConfig::getDefaultViewportBounds();
+    if (const Framebuffer* nextFramebuffer = next.getFramebuffer()) {
+        const auto& attachments = nextFramebuffer->getAttachments();
+        if (attachments.empty() || std::any_of(attachments.begin(), attachments.end(), [output](const auto& attachment) {
+            return attachment.first == output;
+        }))
+            return -1;
+        targetSize = glm::vec2(attachments.front().first->getWidth(), attachments.front().first->getHeight());
+    }
+    if (glm::vec2(output->getWidth(), output->getHeight()) != targetSize)
+        return -1;
+
+    const std::vector<Texture*> textures = next.getSampledTextures();
+    auto input = std::find(textures.begin(), textures.end(), output);
+    if (input == textures.end() || std::find(input + 1, textures.end(), output) != textures.end())
+        return -1;
+    return (int)(input - textures.begin());
+}
 
-        RenderConfig::setBlend(mEnableBlend, mBlendFuncSrc, mBlendFuncDst);
-        RenderConfig::setColourMask(mColourMask.r, mColourMask.g, mColourMask.b, mColourMask.a);
-        RenderConfig::setCullFace(mEnableFaceCulling, mCullFaceMode);
-        RenderConfig::setDepthTest(mEnableDepthTest, mDepthTestFunc, mDepthTestLimits.x, mDepthTestLimits.y);
-        RenderConfig::setDepthMask(mEnableDepthMask);
+bool RenderPassNode::generateFusedCommands(CommandBuffer& commands, const std::vector<const RenderPassNode*>& passes,
+                                           const std::vector<std::string>& loopIndexUniforms) {
+    // Sampler of each pass reading the previous pass's output
+    std::vector<int> inputs{-1};
+    std::vector<ShaderFusion::Stage> stages{{passes.front()->mShaderIn.getLinkedValue<Shader*>(), ""}};
+    for (std::size_t i = 1; i < passes.size(); i++) {
+        const RenderPassNode& pass = *passes[i];
+        const int input = passes[i - 1]->findFusedInput(pass);
+        const Shader& shader = *pass.mShaderIn.getLinkedValue<Shader*>();
+
+        auto sampler = std::find_if(pass.mUniformValues.begin(), pass.mUniformValues.end(), [&](const auto& value) {
+            const Shader::UniformInfo* uniform = findUniformAt(shader, value.first);
+            return uniform && isSampler(*uniform) && std::get<int>(value.second) == input;
+        });
+        if (input == -1 || sampler == pass.mUniformValues.end())
+            return false;
+        inputs.push_back(input);
+        stages.push_back({&shader, findUniformAt(shader, sampler->first)->name});
+    }
 
-        if (mDoClear) {
-            RenderConfig::setClearColour(mClearColour.r, mClearColour.g, mClearColour.b, mClearColour.a);
-            RenderConfig::clearBuffers(RenderConfig::ClearBit::Colour | RenderConfig::ClearBit::Depth | RenderConfig::ClearBit::Stencil);
+    const RenderPassNode& last = *passes.back();
+    Framebuffer* framebuffer = last.getFramebuffer();
+    const Mesh* mesh = last.mMeshIn.getLinkedValue<Mesh*>();
+
+    Shader* program = ShaderFusion::fuse(stages, mesh->getScreenQuadUVBinding());
+    if (!program)
+        return false;
+
+    std::string label = std::string(last.getName()).append(" ");
+    for (std::size_t i = 0; i < passes.size(); i++)
+        label.append(i == 0 ? "" : " + ").append(std::to_string(passes[i]->getID()));
+    PassProfiler::registerPass(last.getID(), label.append(" (Fused)"));
+    commands.beginTimer(last.getID());
+
+    if (framebuffer)
+        commands.bindFramebuffer(*framebuffer);
+
+    commands.useProgram(*program);
+
+    std::vector<Texture*> textures{};
+    for (std::size_t stage = 0; stage < passes.size(); stage++) {
+        const RenderPassNode& pass = *passes[stage];
+        const Shader& shader = *pass.mShaderIn.getLinkedValue<Shader*>();
+
+        // Texture unit of each of the pass's samplers within the fused program (the input is no longer sampled)
+        const std::vector<Texture*> passTextures = pass.getSampledTextures();
+        std::vector<int> units(passTextures.size(), -1);
+        for (std::size_t i = 0; i < passTextures.size(); i++) {
+            if ((int)i == inputs[stage])
+                continue;
+            units[i] = (int)textures.size();
+            textures.push_back(passTextures[i]);
         }
-    });
 
-    std::vector<const Texture*> textures{};
-    for (const auto& port : mSamplerPorts)
-        textures.push_back(dynamic_cast<Port<Texture*>*>(&port.get())->getLinkedValue<Texture*>());
-    if (!textures.empty()) {
-        passCallbacks.emplace_back([textures]() {
-            for (int i = 0; i < textures.size(); i++)
-            textures[i]->bind(i);
+        pass.mFusedUniformValues.clear();
+        for (const auto& [location, value] : pass.mUniformValues) {
+            const Shader::UniformInfo* uniform = findUniformAt(shader, location);
+            const int fusedLocation = uniform ?
+                program->getUniformLocation(ShaderFusion::getStageName(uniform->name, stage)) : -1;
+            if (uniform && isSampler(*uniform))
+                pass.mFusedUniformValues.emplace_back(fusedLocation, units[std::get<int>(value)]);
+            else
+                pass.mFusedUniformValues.emplace_back(fusedLocation, value);
+        }
+        if (!pass.mFusedUniformValues.empty())
+            commands.setUniforms(*program, pass.mFusedUniformValues);
+        generateLoopIndices(commands, *program, loopIndexUniforms, [stage](const std::string& name) {
+            return ShaderFusion::getStageName(name, stage);
         });
+
+        pass.mValidationState = ValidationState::Loaded;
+        pass.mIsFused = true;
     }
 
-    passCallbacks.emplace_back([mesh]() {
-        mesh->bind();
-        mesh->draw();
-    });
+    commands.setState(last.getRenderState());
+
+    if (!textures.empty())
+        commands.bindTextures(textures);
+
+    commands.bindVAO(*mesh);
+    commands.draw(*mesh);
 
-    if (useFramebuffer)
-        passCallbacks.emplace_back([]() { Framebuffer::unbind(); });
+    if (framebuffer)
+        commands.unbind();
 
-    return [passCallbacks]() {
-        for (const auto& callback : passCallbacks)
-            callback();
-    };
+    commands.endTimer(last.getID());
+    return true;
+}
+
+std::vector<Texture*> RenderPassNode::getSampledTextures() const {
+    std::vector<Texture*> textures{};
+    for (const auto& port : mSamplerPorts)
+        if (port.get().isLinked())
+            textures.push_back(dynamic_cast<Port<Texture*>*>(&port.get())->getLinkedValue<Texture*>());
+    return textures;
+}
+
+CommandBuffer::RenderState RenderPassNode::getRenderState() const {
+    CommandBuffer::RenderState state;
+    state.viewport = mViewport;
+    state.enableBlend = mEnableBlend;
+    state.blendFuncSrc = mBlendFuncSrc;
+    state.blendFuncDst = mBlendFuncDst;
+    state.colourMask = mColourMask;
+    state.enableFaceCulling = mEnableFaceCulling;
+    state.cullFaceMode = mCullFaceMode;
+    state.enableDepthTest = mEnableDepthTest;
+    state.depthTestFunc = mDepthTestFunc;
+    state.depthTestLimits = mDepthTestLimits;
+    state.enableDepthMask = mEnableDepthMask;
+    state.doClear = mDoClear;
+    state.clearColour = mClearColour;
+    return state;
 }
 
 void RenderPassNode::onShaderUpdate() {
@@ -236,23 +413,28 @@ void RenderPassNode::onShaderUpdate() {
                 );
 
                 Port<port_type>* rawPort = port.get();
-                std::string uniformName = uniform.name;
+                const int location = shader->getUniformLocation(uniform.name);
+                const size_t valueIndex = mUniformValues.size();
                 std::variant<port_type> variant;
                 std::visit(VisitOverload{
-                    [this, rawPort, shader, uniformName](Texture* arg2) {
+                    [this, rawPort, shader, location](Texture* arg2) {
                         mSamplerPorts.push_back(*rawPort);
                         shader->bind();
-                        shader->setUniform(uniformName, (int)mSamplerPorts.size() - 1);
+                        shader->setUniform(location, (int)mSamplerPorts.size() - 1);
+                        mUniformValues.emplace_back(location, (int)mSamplerPorts.size() - 1);
                     },
-                    [rawPort, shader, uniformName](auto arg2) {
-                        rawPort->addOnUpdateEvent([rawPort, shader, uniformName]() {
-                            if (!rawPort->isLinked())
+                    [this, rawPort, location, valueIndex, &uniform](auto arg2) {
+                        mUniformValues.emplace_back(location, uniform.value);
+                        mUniformPulls.emplace_back([this, rawPort, valueIndex, version = std::uint64_t(0)]() mutable {
+                            if (!rawPort->isLinked() || rawPort->getVersion() == version)
                                 return;
+                            version = rawPort->getVersion();
                             std::visit(VisitOverload{
                                 [](Texture* arg3) {},
-                                [shader, uniformName](auto arg3) {
-                                    shader->bind();
-                                    shader->setUniform(uniformName, arg3);
+                                [this, valueIndex](auto arg3) {
+                                    mUniformValues[valueIndex].second = arg3;
+                                    if (valueIndex < mFusedUniformValues.size())
+                                        mFusedUniformValues[valueIndex].second = arg3;
                                 },
                             }, rawPort->getLinkedValue());
                         });
@@ -271,6 +453,16 @@ void RenderPassNode::clearUniformPorts() {
         removePort(*port);
     mUniformInPorts.clear();
     mSamplerPorts.clear();
+    mUniformValues.clear();
+    mUniformPulls.clear();
+    mFusedUniformValues.clear();
+}
+
+void RenderPassNode::drawTimings() {
+    const PassProfiler::PassTiming* timing = PassProfiler::getPassTiming(getID());
+    if (!timing)
+        return;
+    ImGui::Text("GPU %.3f ms | CPU %.3f ms", timing->lastGPU, timing->lastCPU);
 }
 
 void RenderPassNode::drawSettings() {
@@ -324,11 +516,14 @@ void RenderPassNode::drawSettings() {
 }
 
 void RenderPassNode::drawValidationMessage() {
-    if (mValidationState == ValidationState::Unloaded) {
+    if (mIsCulled && (mValidationState == ValidationState::Unloaded || mValidationState == ValidationState::Loaded)) {
+        drawMessage("Culled (output unused)", ImVec4(1, 0.5f, 0, 1));
+        return;
+    } else if (mValidationState == ValidationState::Unloaded) {
         drawMessage("Not Loaded", ImVec4(1, 1, 0, 1));
         return;
     } else if (mValidationState == ValidationState::Loaded) {
-        drawMessage("Loaded", ImVec4(0, 1, 0, 1));
+        drawMessage(mIsFused ? "Loaded (Fused)" : "Loaded", ImVec4(0, 1, 0, 1));
         return;
     }
 
@@ -349,6 +544,8 @@ void RenderPassNode::drawValidationMessage() {
         drawMessage("Framebuffer Invalid", ImVec4(1, 0, 0, 1));
     if (mValidationState & ValidationState::MissingSampler)
         drawMessage("Missing Sampler Texture", ImVec4(1, 0, 0, 1));
+    if (mValidationState & ValidationState::CompilingShader)
+        drawMessage("Shader Compiling", ImVec4(1, 1, 0, 1));
 
     ImUtils::endHeader();
 }
@@ -3,6 +3,7 @@
 
 #include "../../NodeEditor/Ports.h"
 
+#include "../../Rendering/CommandBuffer.h"
 #include "../../Rendering/Framebuffer.h"
 #include "../../Rendering/Mesh.h"
 #include "../../Rendering/RenderConfig.h"
@@ -16,7 +17,6 @@
 
 class RenderPassNode final : public Node {
 public:
-    typedef std::function<void()> pipeline_callback;
     enum class ValidationState : unsigned int {
         Unloaded           = 0,
         Loaded             = 1 << 0,
@@ -27,6 +27,7 @@ public:
         InvalidShader      = 1 << 5,
         InvalidFramebuffer = 1 << 6,
         MissingSampler     = 1 << 7,
+        CompilingShader    = 1 << 8,
     };
 
     RenderPassNode();
@@ -37,15 +38,69 @@ public:
     }
 
     [[nodiscard]] bool validate() const final;
+    /**
+     * @returns true if the last validate() failed only because the shader is still compiling, otherwise false.
+     */
+    [[nodiscard]] inline bool isPending() const {
+        return mValidationState == ValidationState::CompilingShader;
+    }
 
-    [[nodiscard]] pipeline_callback generateCallback() const;
+    /**
+     * @brief Append the commands executing this pass to commands.
+     * @param loopIndexUniforms Index uniform name of each loop enclosing this pass, from outermost to innermost (empty
+     * for loops which do not expose their index). Where names clash, the innermost loop takes precedence.
+     */
+    void generateCommands(CommandBuffer& commands, const std::vector<std::string>& loopIndexUniforms = {}) const;
+    /**
+     * @brief Bring the value of every uniform up to date with its linked port, reading only those whose port has been
+     * invalidated since the last call (see IPort::getVersion()). Must be called before each time the pass runs.
+     */
+    void pullUniformValues() const;
+    /**
+     * @brief Check whether next can run in the same draw as this pass, reading this pass's output directly instead
+     * of through a texture (see ShaderFusion).
+     * @brief This requires both passes draw the same screen quad (see Mesh::setScreenQuad()) with the same viewport
+     * and face culling, and that this pass draws to a single RGBA32F texture without blending or depth testing, which
+     * next samples and which is the same size as next's target. Whether the shaders themselves can be fused is only
+     * known once fused.
+     * @returns Index of the sampler through which next reads this pass's output, or -1 if they cannot be fused.
+     */
+    [[nodiscard]] int findFusedInput(const RenderPassNode& next) const;
+    /**
+     * @brief Append commands executing passes (each able to be fused with the next, see findFusedInput()) as a single
+     * draw, using the state and target of the last pass.
+     * @returns true if successful, otherwise false (without appending any commands) if the shaders cannot be fused.
+     */
+    static bool generateFusedCommands(CommandBuffer& commands, const std::vector<const RenderPassNode*>& passes,
+                                      const std::vector<std::string>& loopIndexUniforms = {});
 
     [[nodiscard]] inline const Node* getNextPass() const {
         return mExecutionOut.isLinked() ? mExecutionOut.getLinkedValue<Node*>() : nullptr;
     }
+    /**
+     * @returns Framebuffer drawn to, or nullptr if drawing to the default framebuffer.
+     */
+    [[nodiscard]] inline Framebuffer* getFramebuffer() const {
+        return mFramebufferIn.isLinked() ? mFramebufferIn.getLinkedValue<Framebuffer*>() : nullptr;
+    }
+    /**
+     * @returns Textures linked to the shader's samplers (unlinked samplers are skipped).
+     */
+    [[nodiscard]] std::vector<Texture*> getSampledTextures() const;
+    [[nodiscard]] CommandBuffer::RenderState getRenderState() const;
+
+    /**
+     * @brief Mark this pass as having no observable output, so it is left out of the compiled pipeline.
+     */
+    inline void setCulled(bool isCulled) const {
+        mIsCulled = isCulled;
+    }
+    [[nodiscard]] inline bool isCulled() const {
+        return mIsCulled;
+    }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void drawContents() final;
 private:
@@ -53,6 +108,7 @@ private:
 
     void clearUniformPorts();
 
+    void drawTimings();
     void drawSettings();
     void drawValidationMessage();
 
@@ -65,6 +121,19 @@ private:
 
     std::vector<std::unique_ptr<IPort>> mUniformInPorts{};
     std::vector<std::reference_wrapper<IPort>> mSamplerPorts{};
+    /**
+     * @brief Location and current value of each uniform (or texture unit of each sampler). Applied every time the pass
+     * runs, as the shader program may be shared with other passes.
+     */
+    mutable CommandBuffer::uniform_values_t mUniformValues{};
+    /**
+     * @brief Per (non-sampler) uniform, reads the value of its port into mUniformValues if it has changed.
+     */
+    std::vector<std::function<void()>> mUniformPulls{};
+    /**
+     * @brief mUniformValues, with locations (and texture units) of the fused program this pass was last compiled into.
+     */
+    mutable CommandBuffer::uniform_values_t mFusedUniformValues{};
 
     glm::vec4 mViewport = glm::vec4(0.0f);
 
@@ -90,6 +159,8 @@ private:
     bool mShowProblems = false;
 
     mutable ValidationState mValidationState = ValidationState::Unloaded;
+    mutable bool mIsCulled = false;
+    mutable bool mIsFused = false;
 };
 
 inline unsigned int operator&(RenderPassNode::ValidationState a, RenderPassNode::ValidationState b) {
@@ -26,10 +26,14 @@ std::vector<std::pair<std::string, std::string>> ShaderNode::generateSerializedD
     if (!mGeomData.filepath.empty())
         data.emplace_back("Geometry", SerializationUtils::serializeData(mGeomData.filepath));
 
+    for (const auto& define : mDefines)
+        data.emplace_back("Define", SerializationUtils::serializeData(define.first).append(" ")
+                                        .append(SerializationUtils::serializeData(define.second)));
+
     return data;
 }
 
-void ShaderNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void ShaderNode::deserializeData(const std::string& dataID, std::istream& stream) {
     if (dataID == "Vertex") {
         SerializationUtils::deserializeData(stream, mVertData.filepath);
         SerializationUtils::readFile(mVertData.filepath, mVertData.code);
@@ -45,6 +49,10 @@ void ShaderNode::deserializeData(const std::string& dataID, std::ifstream& strea
     } else if (dataID == "Geometry") {
         SerializationUtils::deserializeData(stream, mGeomData.filepath);
         SerializationUtils::readFile(mGeomData.filepath, mGeomData.code);
+    } else if (dataID == "Define") {
+        auto& define = mDefines.emplace_back();
+        SerializationUtils::deserializeData(stream, define.first);
+        SerializationUtils::deserializeData(stream, define.second);
     }
 }
 void ShaderNode::onDeserialize() {
@@ -58,6 +66,10 @@ void ShaderNode::drawContents() {
     drawShaderInput(mTeseData);
     drawShaderInput(mGeomData);
 
+    drawDefines();
+
+    checkIncludes();
+
     ImGui::BeginDisabled(isLocked());
 
     if (ImUtils::button("Upload", generateNodeLabelID("Upload"))) {
@@ -115,6 +127,36 @@ void ShaderNode::drawShaderInput(ShaderPassData& data) {
     }
 }
 
+void ShaderNode::drawDefines() {
+    if (!ImUtils::beginHeader("Defines", generateNodeLabelID("DefinesHeader"), mShowDefines))
+        return;
+
+    ImGui::BeginDisabled(isLocked());
+
+    for (size_t i = 0; i < mDefines.size(); i++) {
+        bool valueUpdated = false;
+        valueUpdated |= ImUtils::inputText(mDefines[i].first, generateNodeLabelID("DefineName", i));
+        ImGui::SameLine();
+        valueUpdated |= ImUtils::inputText(mDefines[i].second, generateNodeLabelID("DefineValue", i));
+        ImGui::SameLine();
+        if (ImUtils::button("Remove", generateNodeLabelID("DefineRemove", i))) {
+            mDefines.erase(mDefines.begin() + (std::ptrdiff_t)i--);
+            valueUpdated = true;
+        }
+        if (valueUpdated)
+            markDirty();
+    }
+
+    if (ImUtils::button("Add Define", generateNodeLabelID("DefineAdd"))) {
+        mDefines.emplace_back("UNNAMED", "");
+        markDirty();
+    }
+
+    ImGui::EndDisabled();
+
+    ImUtils::endHeader();
+}
+
 void ShaderNode::drawShaderStatus() {
     std::string text;
     ImVec4 colour;
@@ -129,14 +171,20 @@ void ShaderNode::drawShaderStatus() {
                 text = "Tesselation Control selected, but no Tesselation Evaluation";
             else if (mTescData.filepath.empty() && !mTeseData.filepath.empty())
                 text = "Tesselation Evaluation selected, but no Tesselation Control";
+            else if (!mPreprocessError.empty())
+                text = mPreprocessError;
             else
                 text = mShader->getErrorMessage();
             colour = ImVec4(1, 0, 0, 1);
             break;
         case Shader::ErrorState::VALID:
-            text = "Shader loaded";
+            text = mShader.use_count() > 1 ? "Shader loaded (shared)" : "Shader loaded";
             colour = ImVec4(0, 1, 0, 1);
             break;
+        case Shader::ErrorState::COMPILING:
+            text = "Compiling...";
+            colour = ImVec4(1, 1, 0, 1);
+            break;
         case Shader::ErrorState::FILE_READ: case Shader::ErrorState::OGL_COMPILE: case Shader::ErrorState::OGL_LINK:
             text = mShader->getErrorMessage();
             colour = ImVec4(1, 0, 0, 1);
@@ -146,12 +194,59 @@ void ShaderNode::drawShaderStatus() {
     drawMessage(text, colour);
 }
 
+bool ShaderNode::preprocessPasses(std::array<std::string, 5>& codes, std::size_t& hash) {
+    const std::array<const ShaderPassData*, 5> passes = {&mVertData, &mFragData, &mTescData, &mTeseData, &mGeomData};
+
+    hash = 0;
+    for (size_t i = 0; i < passes.size(); i++) {
+        const ShaderPassData& pass = *passes[i];
+        // Optional passes are omitted entirely if they have no code
+        if (i >= 2 && pass.code.empty())
+            continue;
+
+        const ShaderPreprocessor::Result& result = ShaderPreprocessor::preprocess(pass.code, pass.filepath, mDefines);
+        if (!result.isValid()) {
+            mPreprocessError = std::string(pass.displayName).append(": ").append(result.error);
+            return false;
+        }
+        codes[i] = result.code;
+        hash = hash * 31 + result.hash;
+    }
+    return true;
+}
+
+void ShaderNode::checkIncludes() {
+    if (mPreprocessRevision == ShaderPreprocessor::getRevision())
+        return;
+    mPreprocessRevision = ShaderPreprocessor::getRevision();
+    if (mSourceHash == 0)
+        return;
+
+    std::array<std::string, 5> codes;
+    std::size_t hash = 0;
+    if (preprocessPasses(codes, hash) && hash == mSourceHash)
+        return;
+
+    uploadShader();
+    mShaderOut.valueUpdated();
+}
+
 void ShaderNode::uploadShader() {
+    mPreprocessError.clear();
+    mPreprocessRevision = ShaderPreprocessor::getRevision();
+    mSourceHash = 0;
+
     if (mVertData.filepath.empty() || mFragData.filepath.empty() || (mTescData.filepath.empty() != mTeseData.filepath.empty())) {
-        mShader = std::make_unique<Shader>();
+        mShader = std::make_shared<Shader>();
         return;
     }
-    mShader = std::make_unique<Shader>(
-        mVertData.code, mFragData.code, mTescData.code, mTeseData.code, mGeomData.code
-    );
+
+    std::array<std::string, 5> codes;
+    std::size_t hash = 0;
+    if (!preprocessPasses(codes, hash)) {
+        mShader = std::make_shared<Shader>();
+        return;
+    }
+    mSourceHash = hash;
+    mShader = ShaderPreprocessor::getProgram(codes[0], codes[1], codes[2], codes[3], codes[4]);
 }
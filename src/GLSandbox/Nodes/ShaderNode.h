@@ -4,10 +4,12 @@
 #include "../../NodeEditor/Ports.h"
 
 #include "../../Rendering/Shader.h"
+#include "../../Rendering/ShaderPreprocessor.h"
 
 #include "../Assets.h"
 #include "../NodeClassifications.h"
 
+#include <array>
 #include <filesystem>
 #include <functional>
 #include <memory>
@@ -30,7 +32,7 @@ public:
     }
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void onDeserialize() final;
 
@@ -57,12 +59,24 @@ private:
     typedef std::function<std::vector<std::string>&()> get_files_callback;
 
     void drawShaderInput(ShaderPassData& data);
+    void drawDefines();
 
     void drawShaderStatus();
 
+    /**
+     * @brief Preprocess each pass with the node's define set.
+     * @param hash Combined hash of every preprocessed pass.
+     * @returns true if every pass was preprocessed successfully, otherwise false (with mPreprocessError set).
+     */
+    bool preprocessPasses(std::array<std::string, 5>& codes, std::size_t& hash);
+    /**
+     * @brief Re-upload the shader if any file it includes has changed since it was uploaded.
+     */
+    void checkIncludes();
+
     void uploadShader();
 
-    std::unique_ptr<Shader> mShader = std::make_unique<Shader>();
+    std::shared_ptr<Shader> mShader = std::make_shared<Shader>();
     Port<Shader*> mShaderOut = Port<Shader*>(*this, IPort::Direction::Out, "ShaderOut", "Shader", [&]() { return mShader.get(); });
 
     ShaderPassData mVertData = ShaderPassData("Vertex",   getValidVertexShaderFileExtensions());
@@ -70,5 +84,15 @@ private:
     ShaderPassData mTescData = ShaderPassData("Tess-Cont", getValidTessContShaderFileExtensions());
     ShaderPassData mTeseData = ShaderPassData("Tess-Eval", getValidTessEvalShaderFileExtensions());
     ShaderPassData mGeomData = ShaderPassData("Geometry",  getValidGeometryShaderFileExtensions());
+
+    ShaderPreprocessor::defines_t mDefines{};
+    std::string mPreprocessError;
+    /**
+     * @brief Combined hash of the preprocessed passes of mShader, or 0 if it was not built from preprocessed passes.
+     */
+    std::size_t mSourceHash = 0;
+    unsigned int mPreprocessRevision = 0;
+
+    bool mShowDefines = false;
 };
 
@@ -18,7 +18,7 @@ std::vector<std::pair<std::string, std::string>> ScreenWidthNode::generateSerial
 	return {};
 }
 
-void ScreenWidthNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void ScreenWidthNode::deserializeData(const std::string& dataID, std::istream& stream) {
 }
 
 void ScreenWidthNode::drawContents() {
@@ -39,7 +39,7 @@ std::vector<std::pair<std::string, std::string>> TextureFileNode::generateSerial
     return data;
 }
 
-void TextureFileNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void TextureFileNode::deserializeData(const std::string& dataID, std::istream& stream) {
     if (dataID == "File")
         SerializationUtils::deserializeData(stream, mFilepath);
 }
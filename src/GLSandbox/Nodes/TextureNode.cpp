@@ -230,6 +230,7 @@ std::vector<std::pair<std::string, std::string>> TextureNode::generateSerialized
     std::vector<std::pair<std::string, std::string>> data{};
     data.emplace_back("Type", SerializationUtils::serializeData((int)mTextureType));
     data.emplace_back("ScreenLock", SerializationUtils::serializeData(mIsScreenLocked));
+    data.emplace_back("Transient", SerializationUtils::serializeData(mIsTransient));
     data.emplace_back("Bounds", SerializationUtils::serializeData(mTexBounds));
     data.emplace_back("Min", SerializationUtils::serializeData((int)mMinFilter));
     data.emplace_back("Mag", SerializationUtils::serializeData((int)mMagFilter));
@@ -243,11 +244,13 @@ std::vector<std::pair<std::string, std::string>> TextureNode::generateSerialized
     return data;
 }
 
-void TextureNode::deserializeData(const std::string& dataID, std::ifstream& stream) {
+void TextureNode::deserializeData(const std::string& dataID, std::istream& stream) {
     if (dataID == "Type")
         SerializationUtils::deserializeData(stream, (int&)mTextureType);
     else if (dataID == "ScreenLock")
         SerializationUtils::deserializeData(stream, mIsScreenLocked);
+    else if (dataID == "Transient")
+        SerializationUtils::deserializeData(stream, mIsTransient);
     else if (dataID == "Bounds")
         SerializationUtils::deserializeData(stream, mTexBounds);
     else if (dataID == "Min")
@@ -312,6 +315,11 @@ bool TextureNode::drawTextureSettings() {
     updateSettings |= ImUtils::inputIntN(&mTexBounds[0], 2, generateNodeLabelID("TextureBounds"), 1, 4096);
     ImGui::EndDisabled();
 
+    if (ImUtils::button(mIsTransient ? "Transient" : "Persistent", generateNodeLabelID("Transient"))) {
+        mIsTransient = !mIsTransient;
+        updateSettings = true;
+    }
+
     ImGui::Text("Min-Filter");
     updateSettings |= ImUtils::cycleButton(generateNodeLabelID("MinFilter"), (size_t&)mMinFilter, (size_t)Texture::MinFilter::Max,
                              [](size_t index) { return getMinFilterLabel((Texture::MinFilter)index); });
@@ -382,6 +390,8 @@ void TextureNode::updateTexture() {
     }
     if (mIsScreenLocked)
         mTexBounds = RenderConfig::getDefaultViewportBounds();
+    mTexture->setTransient(mIsTransient);
+    mTexture->removeAlias();
     mTexture->bind();
     mTexture->setInternalFormat(mInternalFormat);
     mTexture->setFilters(mMinFilter, mMagFilter);
@@ -46,7 +46,7 @@ public:
     void onResizeEvent() final;
 protected:
     [[nodiscard]] std::vector<std::pair<std::string, std::string>> generateSerializedData() const final;
-    void deserializeData(const std::string& dataID, std::ifstream& stream) final;
+    void deserializeData(const std::string& dataID, std::istream& stream) final;
 
     void onDeserialize() final;
 
@@ -61,6 +61,10 @@ private:
     Port<Texture*> mTextureOut = Port<Texture*>(*this, IPort::Direction::Out, "TextureOut", "Texture", [&]() { return mTexture.get(); });
 
     bool mIsScreenLocked = false;
+    /**
+     * @brief Contents are only needed within a frame, so storage may be shared with other transient textures.
+     */
+    bool mIsTransient = false;
     glm::ivec2 mTexBounds = glm::ivec2(512, 512);
 
     TextureType mTextureType = TextureType::Colour;
@@ -75,18 +75,24 @@ void PipelineGraph::drawOutputPanelContents() {
 }
 
 void PipelineGraph::onClear() {
+    mEntryNodes.clear();
     mInputNodes.clear();
     mOutputNodes.clear();
 }
 
 void PipelineGraph::onNodeAdd(Node& node) {
-    if (InputNode* inNode = dynamic_cast<InputNode*>(&node))
+    if (EntryNode* entryNode = dynamic_cast<EntryNode*>(&node))
+        mEntryNodes.emplace_back(*entryNode);
+    else if (InputNode* inNode = dynamic_cast<InputNode*>(&node))
         mInputNodes.emplace_back(*inNode);
     else if (OutputNode* outNode = dynamic_cast<OutputNode*>(&node))
         mOutputNodes.emplace_back(*outNode);
 }
 
 void PipelineGraph::onNodeDelete(Node& node) {
+    mEntryNodes.erase(std::remove_if(mEntryNodes.begin(), mEntryNodes.end(), [&node](const auto& entryNode) {
+        return &node == &entryNode.get();
+    }), mEntryNodes.end());
     mInputNodes.erase(std::remove_if(mInputNodes.begin(), mInputNodes.end(), [&node](const auto& inputNode) {
         return &node == &inputNode.get();
     }), mInputNodes.end());
@@ -95,6 +101,11 @@ void PipelineGraph::onNodeDelete(Node& node) {
     }), mOutputNodes.end());
 }
 
+void PipelineGraph::onLinksChanged() {
+    for (EntryNode& entryNode : mEntryNodes)
+        entryNode.updateCulling();
+}
+
 std::unique_ptr<Node> PipelineGraph::generateNode(NodeType type) const {
     switch (type) {
         case NodeType::Entry       : return std::make_unique<EntryNode>(mPipelineHandler);
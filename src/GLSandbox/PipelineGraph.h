@@ -12,6 +12,7 @@
 #include <unordered_map>
 #include <vector>
 
+class EntryNode;
 class InputNode;
 class OutputNode;
 
@@ -39,11 +40,13 @@ protected:
     void onClear() final;
     void onNodeAdd(Node& node) final;
     void onNodeDelete(Node& node) final;
+    void onLinksChanged() final;
 private:
     [[nodiscard]] std::unique_ptr<Node> generateNode(NodeType type) const;
 
     [[nodiscard]] static std::string getGroupName(NodeGroup group);
 
+    std::vector<std::reference_wrapper<EntryNode>> mEntryNodes{};
     std::vector<std::reference_wrapper<InputNode>> mInputNodes{};
     std::vector<std::reference_wrapper<OutputNode>> mOutputNodes{};
 
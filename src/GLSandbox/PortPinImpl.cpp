@@ -2,101 +2,39 @@
 
 #include "Nodes/MathNodes.h"
 
-template<typename... Types>
-std::size_t variantTypeHash(const std::variant<Types...>& variant) {
-    return typeHash<Types...>();
+/**
+ * @brief Same conversion as ImColor(r, g, b), usable in constant expressions.
+ */
+static constexpr ImU32 pinColour(float r, float g, float b) {
+    return IM_COL32((int)(r * 255.0f + 0.5f), (int)(g * 255.0f + 0.5f), (int)(b * 255.0f + 0.5f), 255);
 }
 
-void parsePinTypeData(size_t pinHash, float& pinSize, PinShape& shape, ImU32& colour, std::string& tooltip) {
-    if (pinHash == typeHash<Node*>()) {
-        pinSize = 14.0f;
-        shape = PinShape::Arrow;
-        colour = ImColor(1.0f, 1.0f, 1.0f);
-        tooltip = "Execution";
-    } else if (pinHash == typeHash<int>()) {
-        pinSize = 10.0f;
-        shape = PinShape::Circle;
-        colour = ImColor(1.0f, 1.0f, 0.0f);
-        tooltip = "Integer";
-    } else if (pinHash == typeHash<glm::ivec2>()) {
-        pinSize = 10.0f;
-        shape = PinShape::Triangle;
-        colour = ImColor(0.8f, 0.8f, 0.0f);
-        tooltip = "IVec2";
-    } else if (pinHash == typeHash<glm::ivec3>()) {
-        pinSize = 10.0f;
-        shape = PinShape::Triangle;
-        colour = ImColor(0.6f, 0.6f, 0.0f);
-        tooltip = "IVec3";
-    } else if (pinHash == typeHash<glm::ivec4>()) {
-        pinSize = 10.0f;
-        shape = PinShape::Triangle;
-        colour = ImColor(0.4f, 0.4f, 0.0f);
-        tooltip = "IVec4";
-    } else if (pinHash == typeHash<float>()) {
-        pinSize = 10.0f;
-        shape = PinShape::Circle;
-        colour = ImColor(0.0f, 1.0f, 1.0f);
-        tooltip = "Float";
-    } else if (pinHash == typeHash<glm::vec2>()) {
-        pinSize = 10.0f;
-        shape = PinShape::Triangle;
-        colour = ImColor(0.0f, 1.0f, 0.7f);
-        tooltip = "Vec2";
-    } else if (pinHash == typeHash<glm::vec3>()) {
-        pinSize = 10.0f;
-        shape = PinShape::Triangle;
-        colour = ImColor(0.0f, 1.0f, 0.4f);
-        tooltip = "Vec3";
-    } else if (pinHash == typeHash<glm::vec4>()) {
-        pinSize = 10.0f;
-        shape = PinShape::Triangle;
-        colour = ImColor(0.0f, 1.0f, 0.0f);
-        tooltip = "Vec4";
-    } else if (pinHash == typeHash<glm::mat2>()) {
-        pinSize = 8.0f;
-        shape = PinShape::Square;
-        colour = ImColor(0.0f, 1.0f, 0.7f);
-        tooltip = "Matrix2x2";
-    } else if (pinHash == typeHash<glm::mat3>()) {
-        pinSize = 8.0f;
-        shape = PinShape::Square;
-        colour = ImColor(0.0f, 1.0f, 0.4f);
-        tooltip = "Matrix3x3";
-    } else if (pinHash == typeHash<glm::mat4>()) {
-        pinSize = 8.0f;
-        shape = PinShape::Square;
-        colour = ImColor(0.0f, 1.0f, 0.0f);
-        tooltip = "Matrix4x4";
-    } else if (pinHash == typeHash<Framebuffer*>()) {
-        pinSize = 10.0f;
-        shape = PinShape::FlatSquare;
-        colour = ImColor(1.0f, 1.0f, 1.0f);
-        tooltip = "Framebuffer";
-    } else if (pinHash == typeHash<Mesh*>()) {
-        pinSize = 10.0f;
-        shape = PinShape::FlatSquare;
-        colour = ImColor(0.0f, 0.8f, 1.0f);
-        tooltip = "Mesh";
-    } else if (pinHash == typeHash<Shader*>()) {
-        pinSize = 10.0f;
-        shape = PinShape::FlatSquare;
-        colour = ImColor(1.0f, 0.4f, 0.0f);
-        tooltip = "Shader";
-    } else if (pinHash == typeHash<Texture*>()) {
-        pinSize = 10.0f;
-        shape = PinShape::FlatSquare;
-        colour = ImColor(0.0f, 1.0f, 0.0f);
-        tooltip = "Texture";
-    } else if (pinHash == variantTypeHash(ArithmeticNode::numeric_variant_t{})) {
-        pinSize = 10.0f;
-        shape = PinShape::Pentagon;
-        colour = ImColor(0.8f, 0.8f, 0.8f);
-        tooltip = "Number";
-    } else {
-        pinSize = 8.0f;
-        shape = PinShape::Circle;
-        colour = ImColor(1.0f, 1.0f, 1.0f);
-        tooltip = "";
-    }
+static constexpr std::pair<port_type_mask_t, PinStyle> cPIN_STYLES[] = {
+    {portTypeMask<Node*>(),        {14.0f, PinShape::Arrow,      pinColour(1.0f, 1.0f, 1.0f), "Execution"}},
+    {portTypeMask<int>(),          {10.0f, PinShape::Circle,     pinColour(1.0f, 1.0f, 0.0f), "Integer"}},
+    {portTypeMask<glm::ivec2>(),   {10.0f, PinShape::Triangle,   pinColour(0.8f, 0.8f, 0.0f), "IVec2"}},
+    {portTypeMask<glm::ivec3>(),   {10.0f, PinShape::Triangle,   pinColour(0.6f, 0.6f, 0.0f), "IVec3"}},
+    {portTypeMask<glm::ivec4>(),   {10.0f, PinShape::Triangle,   pinColour(0.4f, 0.4f, 0.0f), "IVec4"}},
+    {portTypeMask<float>(),        {10.0f, PinShape::Circle,     pinColour(0.0f, 1.0f, 1.0f), "Float"}},
+    {portTypeMask<glm::vec2>(),    {10.0f, PinShape::Triangle,   pinColour(0.0f, 1.0f, 0.7f), "Vec2"}},
+    {portTypeMask<glm::vec3>(),    {10.0f, PinShape::Triangle,   pinColour(0.0f, 1.0f, 0.4f), "Vec3"}},
+    {portTypeMask<glm::vec4>(),    {10.0f, PinShape::Triangle,   pinColour(0.0f, 1.0f, 0.0f), "Vec4"}},
+    {portTypeMask<glm::mat2>(),    { 8.0f, PinShape::Square,     pinColour(0.0f, 1.0f, 0.7f), "Matrix2x2"}},
+    {portTypeMask<glm::mat3>(),    { 8.0f, PinShape::Square,     pinColour(0.0f, 1.0f, 0.4f), "Matrix3x3"}},
+    {portTypeMask<glm::mat4>(),    { 8.0f, PinShape::Square,     pinColour(0.0f, 1.0f, 0.0f), "Matrix4x4"}},
+    {portTypeMask<Framebuffer*>(), {10.0f, PinShape::FlatSquare, pinColour(1.0f, 1.0f, 1.0f), "Framebuffer"}},
+    {portTypeMask<Mesh*>(),        {10.0f, PinShape::FlatSquare, pinColour(0.0f, 0.8f, 1.0f), "Mesh"}},
+    {portTypeMask<Shader*>(),      {10.0f, PinShape::FlatSquare, pinColour(1.0f, 0.4f, 0.0f), "Shader"}},
+    {portTypeMask<Texture*>(),     {10.0f, PinShape::FlatSquare, pinColour(0.0f, 1.0f, 0.0f), "Texture"}},
+    {ArithmeticNode::numeric_port_t::cTYPE_MASK,
+                                   {10.0f, PinShape::Pentagon,   pinColour(0.8f, 0.8f, 0.8f), "Number"}},
+};
+
+static constexpr PinStyle cDEFAULT_PIN_STYLE = {8.0f, PinShape::Circle, pinColour(1.0f, 1.0f, 1.0f), ""};
+
+const PinStyle& getPinStyle(port_type_mask_t typeMask) {
+    for (const auto& [mask, style] : cPIN_STYLES)
+        if (mask == typeMask)
+            return style;
+    return cDEFAULT_PIN_STYLE;
 }
@@ -1,42 +1,30 @@
 #include "Graph.h"
 
+#include "GraphFormat.h"
 #include "Ports.h"
-#include "../Utils/SerializationUtils.h"
 
 #include <imgui_node_editor.h>
 
+#include <algorithm>
 #include <chrono>
 
-static constexpr char gSERIAL_MARK_NODE[] = "Node";
-
-static constexpr char gSERIAL_DATA_PREFIX = '^';
-static constexpr char gSERIAL_DATA_NODE_TYPE[] = "NodeType";
-
-bool deserializeLinks(const Node::port_data_t& portData, const Node::link_data_t& linkData) {
-    bool changed = false;
-    for (const auto& linkPair : linkData) {
-        Node* nodeFrom = linkPair.first;
-        const std::vector<std::pair<std::string, int>>& nodeLinks = linkPair.second;
-
-        for (const std::pair<std::string, int>& link : nodeLinks) {
-            std::string portNameFrom = link.first;
-            int portID = link.second;
-            const auto match = portData.find(portID);
-            if (match == portData.end())
-                continue;
-
-            Node* nodeTo = match->second.first;
-            std::string portNameTo = match->second.second;
-
-            IPort* portFrom = nodeFrom->getPortByName(portNameFrom);
-            IPort* portTo = nodeTo->getPortByName(portNameTo);
+/**
+ * @brief Link restoration state for a single Graph::deserialize() call.
+ * @brief Links are attempted in the order they were serialized. Any link which cannot be resolved yet (because one of
+ * its ports is dynamic and has not been created) is only retried once a port it depends on is added.
+ */
+struct Graph::LinkRestoreState {
+    struct PendingLink {
+        Node* nodeIn;
+        std::string portIn;
+        Node* nodeOut;
+        std::string portOut;
+    };
 
-            if (portFrom && portTo && !(portFrom->isLinkedWith(*portTo) || portTo->isLinkedWith(*portFrom)))
-                changed |= portFrom->link(*portTo);
-        }
-    }
-    return changed;
-}
+    std::vector<PendingLink> links{};
+    std::unordered_map<Node*, std::unordered_map<std::string, std::vector<size_t>>> dependents{};
+    std::vector<size_t> worklist{};
+};
 
 Graph::Graph() {
     mContext = ed::CreateEditor();
@@ -59,69 +47,65 @@ void Graph::initializeDefault() {
     onDefaultInitialize();
 }
 
-void Graph::serialize(std::ofstream& streamOut) const {
-    streamOut << mID << "\n";
-    for (const auto& node : mNodes) {
-        SerializationUtils::writeBeginMark(streamOut, gSERIAL_MARK_NODE);
-        SerializationUtils::writeDataPoint(streamOut, gSERIAL_DATA_PREFIX, gSERIAL_DATA_NODE_TYPE,
-                                           getNodeSerialName(*node));
-        node->serialize(streamOut);
-        SerializationUtils::writeEndMark(streamOut, gSERIAL_MARK_NODE);
+void Graph::serialize(std::ostream& streamOut, bool binary) const {
+    SerialGraph serialGraph;
+    serialGraph.id = mID;
+    serialGraph.nodes.resize(mNodes.size());
+    for (size_t i = 0; i < mNodes.size(); i++) {
+        serialGraph.nodes[i].type = serialGraph.store(getNodeSerialName(*mNodes[i]));
+        mNodes[i]->serialize(serialGraph, serialGraph.nodes[i]);
     }
+
+    if (binary)
+        GraphFormat::writeBinary(streamOut, serialGraph);
+    else
+        GraphFormat::writeText(streamOut, serialGraph);
 }
 
-void Graph::deserialize(std::ifstream& streamIn) {
+bool Graph::deserialize(std::string_view contents) {
     onClear();
     mNodes.clear();
+    clearTables();
 
-    Node::port_data_t staticPortData, dynamicPortData;
-    Node::link_data_t staticLinkData, dynamicLinkData;
+    mLoadStats = LoadStats();
+    auto parseBegin = std::chrono::steady_clock::now();
 
-    std::streampos end = SerializationUtils::findEnd(streamIn);
+    SerialGraph serialGraph;
+    if (!GraphFormat::read(contents, serialGraph))
+        return false;
+    mID = serialGraph.id;
 
-    streamIn >> mID;
-
-    std::streampos markBegin, markEnd;
-    while (SerializationUtils::findNextMarkPair(streamIn, end, gSERIAL_MARK_NODE, markBegin, markEnd)) {
-        streamIn.seekg(markBegin);
-
-        std::string nodeType;
-
-        std::string dataID;
-        while (SerializationUtils::seekNextDataPoint(streamIn, markEnd, gSERIAL_DATA_PREFIX, dataID)) {
-            if (dataID == gSERIAL_DATA_NODE_TYPE) {
-                streamIn >> nodeType;
-                continue;
-            }
-            SerializationUtils::skipToNextLine(streamIn);
-        }
-        if (dataID.empty()) {
-            streamIn.seekg(markEnd);
+    // Index-aligned with serialGraph.nodes, null for any node of an unknown type
+    std::vector<Node*> nodes(serialGraph.nodes.size(), nullptr);
+    for (size_t i = 0; i < serialGraph.nodes.size(); i++) {
+        std::unique_ptr<Node> node = deserializeNodeType(std::string(serialGraph.nodes[i].type));
+        if (!node)
             continue;
-        }
+        node->deserialize(serialGraph.nodes[i]);
+        nodes[i] = node.get();
+        addNode(std::move(node));
+    }
 
-        std::unique_ptr<Node> node = deserializeNodeType(nodeType);
+    mLoadStats.parseTime = std::chrono::steady_clock::now() - parseBegin;
+    mLoadStats.numNodes = mNodes.size();
 
-        streamIn.seekg(markBegin);
-        if (node) {
-            node->deserialize(streamIn, markEnd, staticPortData, staticLinkData, dynamicPortData, dynamicLinkData);
-            addNode(std::move(node));
-        }
-        streamIn.seekg(markEnd);
-    }
+    mLoadStats.linkTime = ProfileUtils::time([&]() { restoreLinks(serialGraph, nodes); });
+
+    for (const auto& node : mNodes)
+        for (size_t i = 0; i < node->numPorts(); i++)
+            if (node->getPortByIndex(i).getDirection() == IPort::Direction::In)
+                mLoadStats.numLinks += node->getPortByIndex(i).getNumLinks();
 
-    deserializeLinks(staticPortData, staticLinkData);
-    bool dynamicUpdated;
-    do {
-        dynamicUpdated = false;
-        dynamicUpdated |= deserializeLinks(staticPortData, dynamicLinkData);
-        dynamicUpdated |= deserializeLinks(dynamicPortData, staticLinkData);
-        dynamicUpdated |= deserializeLinks(dynamicPortData, dynamicLinkData);
-    } while (dynamicUpdated);
+    onLinksChanged();
+    return true;
 }
 
 void Graph::preDraw() {
-
+    IPort::beginFrame();
+    const IPort::EvaluationStats& stats = IPort::getLastFrameStats();
+    ProfileUtils::setResult("Port Evaluation", std::to_string(stats.reads).append(" reads | ")
+                                .append(std::to_string(stats.evaluations)).append(" evaluated | ")
+                                .append(std::to_string(stats.invalidations)).append(" invalidated (per frame)"));
 }
 
 void Graph::draw() {
@@ -157,15 +141,214 @@ void Graph::markClean() {
         node->markClean();
 }
 
+Graph::MemoryStats Graph::getMemoryStats() const {
+    MemoryStats stats{};
+    stats.numNodes = mNodes.size();
+    stats.numPorts = mPortTable.size();
+    stats.numLinks = mLinkTable.size();
+
+    stats.nodeBytes = mNodes.capacity() * sizeof(std::unique_ptr<Node>);
+    for (const auto& node : mNodes)
+        stats.nodeBytes += node->getMemoryUsage();
+
+    constexpr size_t cNODE_OVERHEAD = sizeof(void*) + sizeof(size_t);
+    const auto getHandlesUsage = [](const std::unordered_map<int, handle_t>& handles) {
+        return handles.bucket_count() * sizeof(void*) +
+               handles.size() * (sizeof(std::pair<const int, handle_t>) + cNODE_OVERHEAD);
+    };
+    stats.tableBytes = getHandlesUsage(mPortHandles) + getHandlesUsage(mLinkHandles) +
+        mPortTable.ids.capacity() * sizeof(int) + mPortTable.ports.capacity() * sizeof(IPort*) +
+        mPortTable.nodes.capacity() * sizeof(Node*) +
+        (mLinkTable.ids.capacity() + mLinkTable.startPortIDs.capacity() +
+         mLinkTable.endPortIDs.capacity()) * sizeof(int) +
+        (mLinkTable.startPorts.capacity() + mLinkTable.endPorts.capacity()) * sizeof(IPort*);
+
+    stats.nameBytes = IPort::getNameMemoryUsage();
+    return stats;
+}
+
+IPort* Graph::findPort(int portID) const {
+    const auto match = mPortHandles.find(portID);
+    return match == mPortHandles.end() ? nullptr : mPortTable.ports[match->second];
+}
+
+std::pair<IPort*, IPort*> Graph::findLink(int linkID) const {
+    const auto match = mLinkHandles.find(linkID);
+    if (match == mLinkHandles.end())
+        return {nullptr, nullptr};
+    return {mLinkTable.endPorts[match->second], mLinkTable.startPorts[match->second]};
+}
+
+bool Graph::linkPorts(int portAID, int portBID) {
+    const auto handleA = mPortHandles.find(portAID);
+    const auto handleB = mPortHandles.find(portBID);
+    if (handleA == mPortHandles.end() || handleB == mPortHandles.end() ||
+        mPortTable.nodes[handleA->second]->isLocked() || mPortTable.nodes[handleB->second]->isLocked())
+        return false;
+    if (!mPortTable.ports[handleA->second]->link(*mPortTable.ports[handleB->second]))
+        return false;
+    onLinksChanged();
+    markDirty();
+    return true;
+}
+
+bool Graph::unlinkPorts(int linkID) {
+    const auto handle = mLinkHandles.find(linkID);
+    if (handle == mLinkHandles.end())
+        return false;
+    IPort& endPort = *mLinkTable.endPorts[handle->second];
+    IPort& startPort = *mLinkTable.startPorts[handle->second];
+    if (endPort.getParent().isLocked() || startPort.getParent().isLocked())
+        return false;
+    endPort.unlink(&startPort);
+    onLinksChanged();
+    markDirty();
+    return true;
+}
+
+void Graph::notifyPortAdded(IPort& port) {
+    addPortRow(port);
+
+    if (!mLinkRestore)
+        return;
+
+    const auto nodeMatch = mLinkRestore->dependents.find(&port.getParent());
+    if (nodeMatch == mLinkRestore->dependents.end())
+        return;
+    const auto portMatch = nodeMatch->second.find(port.getUniqueName());
+    if (portMatch == nodeMatch->second.end())
+        return;
+
+    mLinkRestore->worklist.insert(mLinkRestore->worklist.end(), portMatch->second.begin(), portMatch->second.end());
+}
+
+/**
+ * @brief Remove the row at handle from each column of a table, by moving the last row into its place.
+ * @param ids Column holding the ID each row is found by in handles.
+ */
+template<typename... Columns>
+static void removeRow(std::unordered_map<int, Graph::handle_t>& handles, Graph::handle_t handle, std::vector<int>& ids,
+                      Columns&... columns) {
+    handles.erase(ids[handle]);
+    if (handle + 1 != ids.size())
+        handles[ids.back()] = handle;
+    ids[handle] = ids.back();
+    ids.pop_back();
+    ((columns[handle] = columns.back(), columns.pop_back()), ...);
+}
+
+void Graph::notifyPortRemoved(const IPort& port) {
+    const auto match = mPortHandles.find(port.getID());
+    if (match != mPortHandles.end() && mPortTable.ports[match->second] == &port)
+        removeRow(mPortHandles, match->second, mPortTable.ids, mPortTable.ports, mPortTable.nodes);
+}
+
+void Graph::notifyLinked(IPort& port, IPort& linkTo, int linkID) {
+    const auto [handle, isNew] = mLinkHandles.try_emplace(linkID, (handle_t)mLinkTable.size());
+    if (!isNew)
+        return;
+    IPort& startPort = port.getDirection() == IPort::Direction::Out ? port : linkTo;
+    IPort& endPort = port.getDirection() == IPort::Direction::Out ? linkTo : port;
+    mLinkTable.ids.push_back(linkID);
+    mLinkTable.startPortIDs.push_back(startPort.getID());
+    mLinkTable.endPortIDs.push_back(endPort.getID());
+    mLinkTable.startPorts.push_back(&startPort);
+    mLinkTable.endPorts.push_back(&endPort);
+}
+
+void Graph::notifyUnlinked(int linkID) {
+    const auto match = mLinkHandles.find(linkID);
+    if (match != mLinkHandles.end())
+        removeRow(mLinkHandles, match->second, mLinkTable.ids, mLinkTable.startPortIDs, mLinkTable.endPortIDs,
+                  mLinkTable.startPorts, mLinkTable.endPorts);
+}
+
 void Graph::addNode(std::unique_ptr<Node> node) {
     if (node) {
         node->setParent(this);
+        indexNode(*node);
         onNodeAdd(*node);
         mNodes.push_back(std::move(node));
         markDirty();
     }
 }
 
+void Graph::restoreLinks(const SerialGraph& serialGraph, const std::vector<Node*>& nodes) {
+    std::unordered_map<int, std::pair<Node*, std::string_view>> outPorts;
+    for (size_t i = 0; i < nodes.size(); i++)
+        if (nodes[i])
+            for (const SerialPort& port : serialGraph.nodes[i].ports)
+                if (!port.isInput)
+                    outPorts.emplace(port.id, std::make_pair(nodes[i], port.name));
+
+    LinkRestoreState state;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i])
+            continue;
+        for (const SerialPort& port : serialGraph.nodes[i].ports) {
+            if (!port.isInput)
+                continue;
+            const auto match = outPorts.find(port.linkedID);
+            if (match == outPorts.end())
+                continue;
+            state.links.push_back({nodes[i], std::string(port.name), match->second.first,
+                                   std::string(match->second.second)});
+        }
+    }
+
+    state.worklist.reserve(state.links.size());
+    for (size_t i = 0; i < state.links.size(); i++) {
+        const LinkRestoreState::PendingLink& link = state.links[i];
+        state.dependents[link.nodeIn][link.portIn].push_back(i);
+        state.dependents[link.nodeOut][link.portOut].push_back(i);
+        state.worklist.push_back(i);
+    }
+
+    // Linking can add dynamic ports (and so extend the worklist), so the worklist must be indexed rather than iterated
+    mLinkRestore = &state;
+    for (size_t i = 0; i < state.worklist.size(); i++) {
+        const LinkRestoreState::PendingLink& link = state.links[state.worklist[i]];
+        IPort* portIn = link.nodeIn->getPortByName(link.portIn);
+        IPort* portOut = link.nodeOut->getPortByName(link.portOut);
+        if (portIn && portOut && !(portIn->isLinkedWith(*portOut) || portOut->isLinkedWith(*portIn)))
+            portIn->link(*portOut);
+    }
+    mLinkRestore = nullptr;
+}
+
+void Graph::indexNode(Node& node) {
+    for (size_t i = 0; i < node.numPorts(); i++) {
+        IPort& port = node.getPortByIndex(i);
+        addPortRow(port);
+        for (size_t j = 0; j < port.getNumLinks(); j++)
+            notifyLinked(port, *port.getLinkedPort(j), port.getLinkID(j));
+    }
+}
+
+void Graph::unindexNode(Node& node) {
+    for (size_t i = 0; i < node.numPorts(); i++)
+        notifyPortRemoved(node.getPortByIndex(i));
+}
+
+void Graph::addPortRow(IPort& port) {
+    const auto [handle, isNew] = mPortHandles.try_emplace(port.getID(), (handle_t)mPortTable.size());
+    if (isNew) {
+        mPortTable.ids.push_back(port.getID());
+        mPortTable.ports.push_back(&port);
+        mPortTable.nodes.push_back(&port.getParent());
+    } else {
+        mPortTable.ports[handle->second] = &port;
+        mPortTable.nodes[handle->second] = &port.getParent();
+    }
+}
+
+void Graph::clearTables() {
+    mPortTable = PortTable();
+    mPortHandles.clear();
+    mLinkTable = LinkTable();
+    mLinkHandles.clear();
+}
+
 void Graph::drawEditor() {
     ImGui::Begin("Editor", nullptr, ImGuiWindowFlags_NoCollapse);
     if (ImGui::IsItemHovered()) {
@@ -179,8 +362,8 @@ void Graph::drawEditor() {
 
     for (auto& node : mNodes)
         node->draw();
-    for (auto& node : mNodes)
-        node->drawLinks();
+    for (size_t i = 0; i < mLinkTable.size(); i++)
+        ed::Link(mLinkTable.ids[i], mLinkTable.startPortIDs[i], mLinkTable.endPortIDs[i]);
 
     if (ed::BeginCreate()) {
         checkLinkCreated();
@@ -227,21 +410,7 @@ void Graph::checkLinkCreated() {
     if (!ed::QueryNewLink(&portAID, &portBID) || !ed::AcceptNewItem())
         return;
 
-    IPort* portA = nullptr;
-    IPort* portB  = nullptr;
-    for (auto& node : mNodes) {
-        IPort* in = node->getPort(portAID.Get());
-        IPort* out = node->getPort(portBID.Get());
-        if (!portA && out)
-            portA = out;
-        if (!portB && in)
-            portB = in;
-    }
-
-    if (portA && portB && !portA->getParent().isLocked() & !portB->getParent().isLocked()) {
-        portB->link(*portA);
-        markDirty();
-    }
+    linkPorts(portAID.Get(), portBID.Get());
 }
 
 void Graph::checkLinksDeleted() {
@@ -249,18 +418,7 @@ void Graph::checkLinksDeleted() {
     if (!ed::QueryDeletedLink(&linkID) || !ed::AcceptDeletedItem())
         return;
 
-    for (auto& node : mNodes) {
-        for (size_t i = 0; i < node->numPorts(); i++) {
-            IPort& port = node->getPortByIndex(i);
-            for (size_t j = 0; j < port.getNumLinks(); j++) {
-                if (port.getLinkID(j) != linkID.Get() || port.getParent().isLocked() || port.getLinkedPort(j)->getParent().isLocked())
-                    continue;
-                port.unlink(linkID.Get());
-                markDirty();
-                return;
-            }
-        }
-    }
+    unlinkPorts(linkID.Get());
 }
 
 void Graph::checkNodesDeleted() {
@@ -270,12 +428,15 @@ void Graph::checkNodesDeleted() {
             return false;
         onNodeDelete(*node);
         node->safeDestroy();
+        unindexNode(*node);
         return true;
     };
     size_t initial = mNodes.size();
     while (ed::QueryDeletedNode(&nodeId)) {
         mNodes.erase(std::remove_if(mNodes.begin(), mNodes.end(), checkIfDeleteNode), mNodes.end());
     }
-    if (mNodes.size() != initial)
+    if (mNodes.size() != initial) {
+        onLinksChanged();
         markDirty();
+    }
 }
@@ -1,10 +1,16 @@
 #pragma once
 #include "Node.h"
 
+#include "../Utils/ProfileUtils.h"
+
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <memory>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace ed = ax::NodeEditor;
@@ -15,6 +21,82 @@ namespace ax::NodeEditor {
 
 class Graph {
 public:
+    /**
+     * @brief Breakdown of the most recent call to Graph::deserialize().
+     */
+    struct LoadStats {
+        ProfileUtils::milliseconds_t parseTime{0};
+        ProfileUtils::milliseconds_t linkTime{0};
+        size_t numNodes = 0;
+        size_t numLinks = 0;
+    };
+    /**
+     * @brief Approximate memory used by a graph, in bytes (see Graph::getMemoryStats()).
+     */
+    struct MemoryStats {
+        size_t numNodes = 0;
+        size_t numPorts = 0;
+        size_t numLinks = 0;
+        /**
+         * @brief Nodes and their ports, including the links held by each port.
+         */
+        size_t nodeBytes = 0;
+        /**
+         * @brief Port and link tables, and their handles by ID.
+         */
+        size_t tableBytes = 0;
+        /**
+         * @brief Interned port names, shared with every other graph (and so not included in getTotalBytes()).
+         */
+        size_t nameBytes = 0;
+
+        /**
+         * @returns Bytes used by this graph alone.
+         */
+        [[nodiscard]] inline size_t getTotalBytes() const {
+            return nodeBytes + tableBytes;
+        }
+    };
+
+    /**
+     * @brief Index of a row of the port or link table. Rows are moved as others are removed, so handles are only
+     * valid until the table next changes.
+     */
+    typedef std::uint32_t handle_t;
+    /**
+     * @brief Every port of every node in this graph, as parallel arrays indexed by handle.
+     */
+    struct PortTable {
+        std::vector<int> ids;
+        std::vector<IPort*> ports;
+        std::vector<Node*> nodes;
+
+        [[nodiscard]] inline size_t size() const {
+            return ids.size();
+        }
+    };
+    /**
+     * @brief Every link in this graph, as parallel arrays indexed by handle.
+     * @brief This is an index over the links, which are still stored by the ports they join (see Port::mLinks).
+     */
+    struct LinkTable {
+        std::vector<int> ids;
+        /**
+         * @brief Output port each link starts from.
+         */
+        std::vector<int> startPortIDs;
+        /**
+         * @brief Input port each link ends at.
+         */
+        std::vector<int> endPortIDs;
+        std::vector<IPort*> startPorts;
+        std::vector<IPort*> endPorts;
+
+        [[nodiscard]] inline size_t size() const {
+            return ids.size();
+        }
+    };
+
     Graph();
     virtual ~Graph();
 
@@ -22,8 +104,21 @@ public:
 
     void initializeDefault();
 
-    void serialize(std::ofstream& streamOut) const;
-    void deserialize(std::ifstream& streamIn);
+    /**
+     * @param binary Write in the binary (.graphb) format rather than the text (.graph) format.
+     */
+    void serialize(std::ostream& streamOut, bool binary = false) const;
+    /**
+     * @brief Replace this graph with the contents of a serialized graph, in either format.
+     * @returns false if contents is not a valid graph, otherwise true.
+     */
+    bool deserialize(std::string_view contents);
+
+    [[nodiscard]] inline const LoadStats& getLoadStats() const {
+        return mLoadStats;
+    }
+
+    [[nodiscard]] MemoryStats getMemoryStats() const;
 
     void preDraw();
     void draw();
@@ -31,12 +126,44 @@ public:
 
     inline void clearNodes() {
         mNodes.clear();
+        clearTables();
         onClear();
     }
 
     [[nodiscard]] inline size_t getNumNodes() const {
         return mNodes.size();
     }
+    [[nodiscard]] inline Node& getNodeByIndex(size_t i) {
+        return *mNodes[i];
+    }
+
+    /**
+     * @returns Port with the given ID belonging to any node in this graph, or nullptr if there is no such port.
+     */
+    [[nodiscard]] IPort* findPort(int portID) const;
+    /**
+     * @returns Ports at either end of the link with the given ID, or a pair of nullptr if there is no such link.
+     */
+    [[nodiscard]] std::pair<IPort*, IPort*> findLink(int linkID) const;
+
+    [[nodiscard]] inline const PortTable& getPortTable() const {
+        return mPortTable;
+    }
+    [[nodiscard]] inline const LinkTable& getLinkTable() const {
+        return mLinkTable;
+    }
+
+    /**
+     * @brief Link the ports with the given IDs, as if linked from the editor.
+     * @returns true if the link was created, otherwise false if either port does not exist, is locked, or cannot be
+     * linked.
+     */
+    bool linkPorts(int portAID, int portBID);
+    /**
+     * @brief Break the link with the given ID, as if deleted from the editor.
+     * @returns true if the link was broken, otherwise false if it does not exist or either end is locked.
+     */
+    bool unlinkPorts(int linkID);
 
     void regenerateID();
     [[nodiscard]] inline long getID() const {
@@ -59,6 +186,23 @@ public:
         return mIsDirty;
     };
 
+    /**
+     * @brief Called by a node whenever it adds a port after being added to this graph.
+     */
+    void notifyPortAdded(IPort& port);
+    /**
+     * @brief Called by a node whenever it removes a port after being added to this graph.
+     */
+    void notifyPortRemoved(const IPort& port);
+    /**
+     * @brief Called by a node whenever one of its ports gains a link (once for each end of the link).
+     */
+    void notifyLinked(IPort& port, IPort& linkTo, int linkID);
+    /**
+     * @brief Called by a node whenever one of its ports loses a link (once for each end of the link).
+     */
+    void notifyUnlinked(int linkID);
+
     inline void addOnDirtyEvent(std::function<void()> event) {
         mOnDirtyEvents.push_back(std::move(event));
     }
@@ -78,9 +222,36 @@ protected:
     virtual void onClear() = 0;
     virtual void onNodeAdd(Node& node) = 0;
     virtual void onNodeDelete(Node& node) = 0;
+    /**
+     * @brief Called after links have been created or broken from the editor (including by deleting nodes), or
+     * restored on deserialization.
+     */
+    virtual void onLinksChanged() = 0;
 
     void addNode(std::unique_ptr<Node> node);
 private:
+    struct LinkRestoreState;
+
+    /**
+     * @brief Re-create all serialized links, as a worklist in which unresolved links wait on the ports they depend on.
+     */
+    void restoreLinks(const SerialGraph& serialGraph, const std::vector<Node*>& nodes);
+
+    /**
+     * @brief Add every port of node, and all of their links, to the port and link tables.
+     */
+    void indexNode(Node& node);
+    /**
+     * @brief Remove every port of node from the port table. The node must already have been unlinked.
+     */
+    void unindexNode(Node& node);
+
+    /**
+     * @brief Add port to the port table, replacing the row of any port already registered under its ID.
+     */
+    void addPortRow(IPort& port);
+    void clearTables();
+
     void drawEditor();
     void drawConfig();
     void drawInputPanel();
@@ -96,8 +267,22 @@ private:
 
     std::vector<std::unique_ptr<Node>> mNodes{};
 
+    /**
+     * @brief Kept up to date by the nodes as ports are added or removed.
+     */
+    PortTable mPortTable{};
+    std::unordered_map<int, handle_t> mPortHandles{};
+    /**
+     * @brief Kept up to date by the ports as they are linked or unlinked. Drawn directly by drawEditor().
+     */
+    LinkTable mLinkTable{};
+    std::unordered_map<int, handle_t> mLinkHandles{};
+
     std::unordered_set<int> mDependencies;
 
+    LinkRestoreState* mLinkRestore = nullptr;
+    LoadStats mLoadStats{};
+
     bool mConfigPanelOpen = true;
 
     bool mIsDirty = false;
@@ -0,0 +1,436 @@
+#include "GraphFormat.h"
+
+#include "../Utils/FileUtils.h"
+#include "../Utils/SerializationUtils.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <unordered_map>
+
+static_assert(std::endian::native == std::endian::little, "Binary graph format assumes a little-endian host");
+
+static constexpr char gSERIAL_MARK_NODE[] = "Node";
+static constexpr char gSERIAL_MARK_DATA[] = "Data";
+
+static constexpr char gSERIAL_NODE_TYPE_PREFIX = '^';
+static constexpr char gSERIAL_DATA_NODE_TYPE[] = "NodeType";
+
+static constexpr char gSERIAL_DATA_PREFIX = '-';
+static constexpr char gSERIAL_DATA_ID[] = "NodeID";
+static constexpr char gSERIAL_DATA_NAME[] = "NodeName";
+static constexpr char gSERIAL_DATA_POSITION[] = "NodePosition";
+static constexpr char gSERIAL_DATA_INPORT[] = "InPort";
+static constexpr char gSERIAL_DATA_OUTPORT[] = "OutPort";
+static constexpr char gSERIAL_DATA_DYNAMIC_INPORT[] = "Dynamic-InPort";
+static constexpr char gSERIAL_DATA_DYNAMIC_OUTPORT[] = "Dynamic-OutPort";
+
+static constexpr char gSERIAL_SUBDATA_PREFIX = '-';
+
+namespace binary {
+    constexpr char cMAGIC[4] = {'G', 'S', 'B', 'G'};
+    constexpr uint32_t cVERSION = 1;
+
+    constexpr uint32_t cNODE_HAS_NAME     = 1 << 0;
+    constexpr uint32_t cNODE_HAS_POSITION = 1 << 1;
+
+    constexpr uint32_t cPORT_IS_INPUT   = 1 << 0;
+    constexpr uint32_t cPORT_IS_DYNAMIC = 1 << 1;
+
+    /**
+     * @brief Byte range within the string table.
+     */
+    struct StringRef {
+        uint32_t offset;
+        uint32_t size;
+    };
+    /**
+     * @brief Byte offset (from the start of the file) and number of elements of a table.
+     */
+    struct TableRef {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        int64_t graphID;
+        TableRef nodes;
+        TableRef ports;
+        TableRef data;
+        TableRef links;
+        TableRef strings;
+    };
+
+    struct NodeRecord {
+        StringRef type;
+        StringRef name;
+        int32_t id;
+        uint32_t flags;
+        float position[2];
+        uint32_t firstPort;
+        uint32_t numPorts;
+        uint32_t firstData;
+        uint32_t numData;
+    };
+
+    struct PortRecord {
+        StringRef name;
+        int32_t id;
+        uint32_t flags;
+    };
+
+    struct DataRecord {
+        StringRef id;
+        StringRef value;
+    };
+
+    /**
+     * @brief Link between two port records, referenced by their index in the port table.
+     */
+    struct LinkRecord {
+        uint32_t portIn;
+        uint32_t portOut;
+    };
+
+    constexpr size_t cTABLE_ALIGNMENT = 8;
+
+    template<typename T>
+    std::span<const T> getTable(std::string_view contents, const TableRef& table) {
+        static_assert(alignof(T) <= cTABLE_ALIGNMENT);
+        if (table.offset % alignof(T) != 0 || table.offset > contents.size() ||
+            table.count > (contents.size() - table.offset) / sizeof(T))
+            return {};
+        return {reinterpret_cast<const T*>(contents.data() + table.offset), table.count};
+    }
+}
+
+static bool parseInt(std::string_view text, int& value) {
+    text = text.substr(std::min(text.find_first_not_of(" \t"), text.size()));
+    return std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc();
+}
+
+/**
+ * @brief Parse port data in the format "<unique-name> <id>".
+ */
+static bool parsePortData(std::string_view data, std::string_view& name, int& id) {
+    size_t nameEnd = std::min(data.find_first_of(" \t"), data.size());
+    name = data.substr(0, nameEnd);
+    return parseInt(data.substr(nameEnd), id);
+}
+
+bool GraphFormat::isBinary(std::string_view contents) {
+    return contents.size() >= sizeof(binary::Header) &&
+           std::memcmp(contents.data(), binary::cMAGIC, sizeof(binary::cMAGIC)) == 0;
+}
+
+bool GraphFormat::read(std::string_view contents, SerialGraph& graph) {
+    return isBinary(contents) ? readBinary(contents, graph) : readText(contents, graph);
+}
+
+long long GraphFormat::readID(std::string_view contents) {
+    if (isBinary(contents)) {
+        binary::Header header{};
+        std::memcpy(&header, contents.data(), sizeof(header));
+        return header.graphID;
+    }
+
+    long long id = 0;
+    SerializationUtils::ViewStream(contents.substr(0, std::min(contents.find('\n'), contents.size()))) >> id;
+    return id;
+}
+
+bool GraphFormat::readText(std::string_view contents, SerialGraph& graph) {
+    size_t headerEnd = std::min(contents.find('\n'), contents.size());
+    graph.id = readID(contents);
+
+    std::vector<SerializationUtils::Token> tokens;
+    SerializationUtils::tokenize(contents.substr(headerEnd), tokens);
+
+    const auto isNodeEnd = [](const SerializationUtils::Token& token) {
+        return SerializationUtils::isEndMark(token, gSERIAL_MARK_NODE);
+    };
+    for (auto markBegin = tokens.begin(); markBegin != tokens.end(); markBegin++) {
+        if (!SerializationUtils::isBeginMark(*markBegin, gSERIAL_MARK_NODE))
+            continue;
+        auto markEnd = std::find_if(markBegin + 1, tokens.end(), isNodeEnd);
+        if (markEnd == tokens.end())
+            break;
+
+        std::span<const SerializationUtils::Token> nodeTokens(markBegin + 1, markEnd);
+        markBegin = markEnd;
+
+        SerialNode node;
+        bool inDataBlock = false;
+        for (const SerializationUtils::Token& token : nodeTokens) {
+            if (SerializationUtils::isBeginMark(token, gSERIAL_MARK_DATA)) {
+                inDataBlock = true;
+                continue;
+            }
+            if (SerializationUtils::isEndMark(token, gSERIAL_MARK_DATA)) {
+                inDataBlock = false;
+                continue;
+            }
+
+            if (inDataBlock) {
+                if (token.prefix == gSERIAL_SUBDATA_PREFIX)
+                    node.data.emplace_back(token.id, token.data);
+                continue;
+            }
+
+            if (token.prefix == gSERIAL_NODE_TYPE_PREFIX) {
+                if (token.id == gSERIAL_DATA_NODE_TYPE)
+                    node.type = token.data.substr(0, std::min(token.data.find_first_of(" \t"), token.data.size()));
+                continue;
+            }
+            if (token.prefix != gSERIAL_DATA_PREFIX)
+                continue;
+
+            if (token.id == gSERIAL_DATA_ID) {
+                parseInt(token.data, node.id);
+            } else if (token.id == gSERIAL_DATA_NAME) {
+                node.name = token.data;
+                node.hasName = true;
+            } else if (token.id == gSERIAL_DATA_POSITION) {
+                SerializationUtils::ViewStream stream(token.data);
+                stream >> node.position.x;
+                stream >> node.position.y;
+                node.hasPosition = true;
+            } else if (token.id == gSERIAL_DATA_INPORT || token.id == gSERIAL_DATA_DYNAMIC_INPORT) {
+                SerialPort& port = node.ports.emplace_back();
+                parsePortData(token.data, port.name, port.linkedID);
+                port.isInput = true;
+                port.isDynamic = token.id == gSERIAL_DATA_DYNAMIC_INPORT;
+            } else if (token.id == gSERIAL_DATA_OUTPORT || token.id == gSERIAL_DATA_DYNAMIC_OUTPORT) {
+                SerialPort& port = node.ports.emplace_back();
+                parsePortData(token.data, port.name, port.id);
+                port.isDynamic = token.id == gSERIAL_DATA_DYNAMIC_OUTPORT;
+            }
+        }
+
+        if (!node.type.empty())
+            graph.nodes.push_back(std::move(node));
+    }
+    return true;
+}
+
+bool GraphFormat::readBinary(std::string_view contents, SerialGraph& graph) {
+    if (!isBinary(contents))
+        return false;
+
+    binary::Header header{};
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (header.version != binary::cVERSION)
+        return false;
+
+    const auto nodeRecords = binary::getTable<binary::NodeRecord>(contents, header.nodes);
+    const auto portRecords = binary::getTable<binary::PortRecord>(contents, header.ports);
+    const auto dataRecords = binary::getTable<binary::DataRecord>(contents, header.data);
+    const auto linkRecords = binary::getTable<binary::LinkRecord>(contents, header.links);
+    const auto strings     = binary::getTable<char>(contents, header.strings);
+    if (nodeRecords.size() != header.nodes.count || portRecords.size() != header.ports.count ||
+        dataRecords.size() != header.data.count || linkRecords.size() != header.links.count ||
+        strings.size() != header.strings.count)
+        return false;
+
+    bool isValid = true;
+    const auto getString = [&strings, &isValid](const binary::StringRef& ref)->std::string_view {
+        if (ref.offset > strings.size() || ref.size > strings.size() - ref.offset) {
+            isValid = false;
+            return {};
+        }
+        return {strings.data() + ref.offset, ref.size};
+    };
+
+    graph.id = header.graphID;
+    graph.nodes.resize(nodeRecords.size());
+
+    std::vector<SerialPort*> ports(portRecords.size(), nullptr);
+    for (size_t i = 0; i < nodeRecords.size(); i++) {
+        const binary::NodeRecord& record = nodeRecords[i];
+        if (record.firstPort > portRecords.size() || record.numPorts > portRecords.size() - record.firstPort ||
+            record.firstData > dataRecords.size() || record.numData > dataRecords.size() - record.firstData)
+            return false;
+
+        SerialNode& node = graph.nodes[i];
+        node.type = getString(record.type);
+        node.id = record.id;
+        node.name = getString(record.name);
+        node.hasName = record.flags & binary::cNODE_HAS_NAME;
+        node.position = ImVec2(record.position[0], record.position[1]);
+        node.hasPosition = record.flags & binary::cNODE_HAS_POSITION;
+
+        node.ports.resize(record.numPorts);
+        for (uint32_t j = 0; j < record.numPorts; j++) {
+            const binary::PortRecord& portRecord = portRecords[record.firstPort + j];
+            SerialPort& port = node.ports[j];
+            port.name = getString(portRecord.name);
+            port.id = portRecord.id;
+            port.isInput = portRecord.flags & binary::cPORT_IS_INPUT;
+            port.isDynamic = portRecord.flags & binary::cPORT_IS_DYNAMIC;
+            ports[record.firstPort + j] = &port;
+        }
+
+        node.data.resize(record.numData);
+        for (uint32_t j = 0; j < record.numData; j++) {
+            const binary::DataRecord& dataRecord = dataRecords[record.firstData + j];
+            node.data[j] = {getString(dataRecord.id), getString(dataRecord.value)};
+        }
+    }
+
+    for (const binary::LinkRecord& link : linkRecords) {
+        if (link.portIn >= ports.size() || link.portOut >= ports.size() || !ports[link.portIn] || !ports[link.portOut])
+            return false;
+        ports[link.portIn]->linkedID = ports[link.portOut]->id;
+    }
+
+    return isValid;
+}
+
+void GraphFormat::writeText(std::ostream& stream, const SerialGraph& graph) {
+    stream << graph.id << "\n";
+
+    std::vector<std::pair<std::string, std::string>> data{};
+    for (const SerialNode& node : graph.nodes) {
+        SerializationUtils::writeBeginMark(stream, gSERIAL_MARK_NODE);
+        SerializationUtils::writeDataPoint(stream, gSERIAL_NODE_TYPE_PREFIX, gSERIAL_DATA_NODE_TYPE,
+                                           std::string(node.type));
+
+        data.clear();
+        data.emplace_back(gSERIAL_DATA_ID, std::to_string(node.id));
+        if (node.hasName)
+            data.emplace_back(gSERIAL_DATA_NAME, node.name);
+        if (node.hasPosition)
+            data.emplace_back(gSERIAL_DATA_POSITION, std::to_string(node.position.x).append(" ")
+                                                         .append(std::to_string(node.position.y)));
+        for (const SerialPort& port : node.ports)
+            if (port.isInput)
+                data.emplace_back(port.isDynamic ? gSERIAL_DATA_DYNAMIC_INPORT : gSERIAL_DATA_INPORT,
+                                  std::string(port.name).append(" ").append(std::to_string(port.linkedID)));
+        for (const SerialPort& port : node.ports)
+            if (!port.isInput)
+                data.emplace_back(port.isDynamic ? gSERIAL_DATA_DYNAMIC_OUTPORT : gSERIAL_DATA_OUTPORT,
+                                  std::string(port.name).append(" ").append(std::to_string(port.id)));
+        for (const auto& dataPoint : data)
+            SerializationUtils::writeDataPoint(stream, gSERIAL_DATA_PREFIX, dataPoint.first, dataPoint.second);
+
+        SerializationUtils::writeBeginMark(stream, gSERIAL_MARK_DATA);
+        for (const auto& dataPoint : node.data)
+            SerializationUtils::writeDataPoint(stream, gSERIAL_SUBDATA_PREFIX, std::string(dataPoint.first),
+                                               std::string(dataPoint.second));
+        SerializationUtils::writeEndMark(stream, gSERIAL_MARK_DATA);
+
+        SerializationUtils::writeEndMark(stream, gSERIAL_MARK_NODE);
+    }
+}
+
+void GraphFormat::writeBinary(std::ostream& stream, const SerialGraph& graph) {
+    std::vector<binary::NodeRecord> nodeRecords;
+    std::vector<binary::PortRecord> portRecords;
+    std::vector<binary::DataRecord> dataRecords;
+    std::vector<binary::LinkRecord> linkRecords;
+    std::string strings;
+
+    std::unordered_map<std::string_view, binary::StringRef> stringRefs;
+    const auto addString = [&strings, &stringRefs](std::string_view value) {
+        auto match = stringRefs.find(value);
+        if (match != stringRefs.end())
+            return match->second;
+        binary::StringRef ref{(uint32_t)strings.size(), (uint32_t)value.size()};
+        strings.append(value);
+        stringRefs.emplace(value, ref);
+        return ref;
+    };
+
+    std::unordered_map<int, uint32_t> outPortIndices;
+    nodeRecords.reserve(graph.nodes.size());
+    for (const SerialNode& node : graph.nodes) {
+        binary::NodeRecord& record = nodeRecords.emplace_back();
+        record.type = addString(node.type);
+        record.name = addString(node.name);
+        record.id = node.id;
+        record.flags = (node.hasName ? binary::cNODE_HAS_NAME : 0) | (node.hasPosition ? binary::cNODE_HAS_POSITION : 0);
+        record.position[0] = node.position.x;
+        record.position[1] = node.position.y;
+
+        record.firstPort = (uint32_t)portRecords.size();
+        record.numPorts = (uint32_t)node.ports.size();
+        for (const SerialPort& port : node.ports) {
+            if (!port.isInput)
+                outPortIndices.emplace(port.id, (uint32_t)portRecords.size());
+            portRecords.push_back({addString(port.name), port.id,
+                                   (port.isInput ? binary::cPORT_IS_INPUT : 0) |
+                                   (port.isDynamic ? binary::cPORT_IS_DYNAMIC : 0)});
+        }
+
+        record.firstData = (uint32_t)dataRecords.size();
+        record.numData = (uint32_t)node.data.size();
+        for (const auto& dataPoint : node.data)
+            dataRecords.push_back({addString(dataPoint.first), addString(dataPoint.second)});
+    }
+
+    for (const binary::NodeRecord& record : nodeRecords) {
+        const SerialNode& node = graph.nodes[&record - nodeRecords.data()];
+        for (uint32_t i = 0; i < record.numPorts; i++) {
+            const SerialPort& port = node.ports[i];
+            if (!port.isInput || port.linkedID < 0)
+                continue;
+            auto match = outPortIndices.find(port.linkedID);
+            if (match != outPortIndices.end())
+                linkRecords.push_back({record.firstPort + i, match->second});
+        }
+    }
+
+    binary::Header header{};
+    std::memcpy(header.magic, binary::cMAGIC, sizeof(header.magic));
+    header.version = binary::cVERSION;
+    header.graphID = graph.id;
+
+    uint32_t offset = sizeof(binary::Header);
+    const auto placeTable = [&offset](binary::TableRef& table, size_t count, size_t elementSize) {
+        offset = (offset + binary::cTABLE_ALIGNMENT - 1) / binary::cTABLE_ALIGNMENT * binary::cTABLE_ALIGNMENT;
+        table = {offset, (uint32_t)count};
+        offset += (uint32_t)(count * elementSize);
+    };
+    placeTable(header.nodes, nodeRecords.size(), sizeof(binary::NodeRecord));
+    placeTable(header.ports, portRecords.size(), sizeof(binary::PortRecord));
+    placeTable(header.data, dataRecords.size(), sizeof(binary::DataRecord));
+    placeTable(header.links, linkRecords.size(), sizeof(binary::LinkRecord));
+    placeTable(header.strings, strings.size(), sizeof(char));
+
+    size_t written = 0;
+    const auto writeTable = [&stream, &written](const binary::TableRef& table, const void* data, size_t size) {
+        static constexpr char cPADDING[binary::cTABLE_ALIGNMENT] = {};
+        stream.write(cPADDING, (std::streamsize)(table.offset - written));
+        stream.write((const char*)data, (std::streamsize)size);
+        written = table.offset + size;
+    };
+    stream.write((const char*)&header, sizeof(header));
+    written = sizeof(header);
+    writeTable(header.nodes, nodeRecords.data(), nodeRecords.size() * sizeof(binary::NodeRecord));
+    writeTable(header.ports, portRecords.data(), portRecords.size() * sizeof(binary::PortRecord));
+    writeTable(header.data, dataRecords.data(), dataRecords.size() * sizeof(binary::DataRecord));
+    writeTable(header.links, linkRecords.data(), linkRecords.size() * sizeof(binary::LinkRecord));
+    writeTable(header.strings, strings.data(), strings.size());
+}
+
+bool GraphFormat::convert(const std::filesystem::path& source, const std::filesystem::path& destination, bool binary) {
+    MappedFile file(source);
+    SerialGraph graph;
+    if (!file.isOpen() || !read(file.view(), graph))
+        return false;
+
+    std::ofstream stream(destination, std::ios::out | std::ios::binary);
+    if (!stream)
+        return false;
+    if (binary)
+        writeBinary(stream, graph);
+    else
+        writeText(stream, graph);
+    return stream.good();
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <imgui.h>
+
+#include <deque>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Serialized port, as stored by either graph format.
+ */
+struct SerialPort {
+    std::string_view name;
+    int id = -1;
+    /**
+     * @brief ID of the (output) port linked to this port, or -1 if unlinked. Only used by input ports.
+     */
+    int linkedID = -1;
+    bool isInput = false;
+    bool isDynamic = false;
+};
+
+/**
+ * @brief Serialized node, as stored by either graph format.
+ */
+struct SerialNode {
+    std::string_view type;
+    int id = -1;
+    std::string_view name;
+    bool hasName = false;
+    ImVec2 position = ImVec2(0.0f, 0.0f);
+    bool hasPosition = false;
+    std::vector<SerialPort> ports{};
+    std::vector<std::pair<std::string_view, std::string_view>> data{};
+};
+
+/**
+ * @brief Format-independent flat table of a serialized graph, shared by the text (.graph) and binary (.graphb)
+ * formats.
+ * @brief All string views reference either the buffer the graph was read from, or strings owned by the graph itself
+ * (see SerialGraph::store()), and so must not outlive either.
+ */
+struct SerialGraph {
+    long long id = 0;
+    std::vector<SerialNode> nodes{};
+
+    /**
+     * @brief Take ownership of value, returning a view which remains valid for the lifetime of this graph.
+     */
+    std::string_view store(std::string value) {
+        return mStorage.emplace_back(std::move(value));
+    }
+private:
+    std::deque<std::string> mStorage{};
+};
+
+class GraphFormat {
+public:
+    /**
+     * @returns true if contents begins with the binary format header, otherwise false.
+     */
+    [[nodiscard]] static bool isBinary(std::string_view contents);
+
+    /**
+     * @brief Read contents in either format (detected from the header) into graph.
+     * @returns false if contents is not a valid graph, otherwise true.
+     */
+    static bool read(std::string_view contents, SerialGraph& graph);
+    /**
+     * @returns Graph ID stored in contents (in either format), or 0 if contents is not a valid graph.
+     */
+    [[nodiscard]] static long long readID(std::string_view contents);
+
+    /**
+     * @brief Tokenize contents in a single forward pass and split it into its node blocks.
+     */
+    static bool readText(std::string_view contents, SerialGraph& graph);
+    /**
+     * @brief Walk the fixed-size records of a binary graph in place. Performs no per-field parsing.
+     */
+    static bool readBinary(std::string_view contents, SerialGraph& graph);
+
+    static void writeText(std::ostream& stream, const SerialGraph& graph);
+    static void writeBinary(std::ostream& stream, const SerialGraph& graph);
+
+    /**
+     * @brief Re-write the graph file at source to destination in the given format, without instantiating its nodes.
+     * @returns true if conversion is successful, otherwise false.
+     */
+    static bool convert(const std::filesystem::path& source, const std::filesystem::path& destination, bool binary);
+};
@@ -14,26 +14,6 @@ namespace ed = ax::NodeEditor;
 
 int gGraphIDCounter = 1;
 
-static constexpr char gSERIAL_MARK_PREFIX = '%';
-static constexpr char gSERIAL_MARK_DATA[] = "Data";
-
-static constexpr char gSERIAL_DATA_PREFIX = '-';
-static constexpr char gSERIAL_DATA_ID[] = "NodeID";
-static constexpr char gSERIAL_DATA_NAME[] = "NodeName";
-static constexpr char gSERIAL_DATA_POSITION[] = "NodePosition";
-static constexpr char gSERIAL_DATA_INPORT[] = "InPort";
-static constexpr char gSERIAL_DATA_OUTPORT[] = "OutPort";
-static constexpr char gSERIAL_DATA_DYNAMIC_INPORT[] = "Dynamic-InPort";
-static constexpr char gSERIAL_DATA_DYNAMIC_OUTPORT[] = "Dynamic-OutPort";
-
-static constexpr char gSERIAL_SUBDATA_PREFIX = '-';
-
-void writeDataPoints(std::ofstream& streamOut, char prefix,
-                     const std::vector<std::pair<std::string, std::string>>& dataPoints) {
-    for (const auto& dataPair : dataPoints)
-        SerializationUtils::writeDataPoint(streamOut, prefix, dataPair.first, dataPair.second);
-}
-
 Node::Node(std::string title) : mName(std::move(title)), mID{gGraphIDCounter++} {
     setRelativePosition(ImVec2(50.0f, 50.0f));
 }
@@ -51,88 +31,33 @@ void Node::setParent(Graph* parent) {
     mParent = parent;
 }
 
-void Node::serialize(std::ofstream& streamOut) const {
-    std::string serializedID = std::to_string(getID());
-    ImVec2 position = getAbsolutePosition();
-    std::string serializedPosition = std::to_string(position.x).append(" ").append(std::to_string(position.y));
-
-    std::vector<std::pair<std::string, std::string>> data{};
-
-    data.emplace_back(gSERIAL_DATA_ID, serializedID);
-    data.emplace_back(gSERIAL_DATA_NAME, mName);
-    data.emplace_back(gSERIAL_DATA_POSITION, serializedPosition);
+void Node::serialize(SerialGraph& graph, SerialNode& serialNode) const {
+    serialNode.id = getID();
+    serialNode.name = mName;
+    serialNode.hasName = true;
+    serialNode.position = getAbsolutePosition();
+    serialNode.hasPosition = true;
 
+    serialNode.ports.reserve(mPorts.size());
     for (const IPort& port : mInPorts)
-        data.emplace_back(port.isDynamic() ? gSERIAL_DATA_DYNAMIC_INPORT : gSERIAL_DATA_INPORT,
-                          std::string(port.getUniqueName()).append(" ").append(std::to_string(port.getLinkedPortID(0))));
+        serialNode.ports.push_back({port.getUniqueName(), port.getID(), port.getLinkedPortID(0), true, port.isDynamic()});
     for (const IPort& port : mOutPorts)
-        data.emplace_back(port.isDynamic() ? gSERIAL_DATA_DYNAMIC_OUTPORT : gSERIAL_DATA_OUTPORT,
-                          std::string(port.getUniqueName()).append(" ").append(std::to_string(port.getID())));
+        serialNode.ports.push_back({port.getUniqueName(), port.getID(), -1, false, port.isDynamic()});
 
-    writeDataPoints(streamOut, gSERIAL_DATA_PREFIX, data);
-
-    SerializationUtils::writeBeginMark(streamOut, gSERIAL_MARK_DATA);
-    writeDataPoints(streamOut, gSERIAL_SUBDATA_PREFIX, generateSerializedData());
-    SerializationUtils::writeEndMark(streamOut, gSERIAL_MARK_DATA);
+    for (auto& dataPoint : generateSerializedData())
+        serialNode.data.emplace_back(graph.store(std::move(dataPoint.first)), graph.store(std::move(dataPoint.second)));
 }
 
-void Node::deserialize(std::ifstream& streamIn, std::streampos end,
-                       port_data_t& staticPortData, link_data_t& staticLinkData,
-                       port_data_t& dynamicPortData, link_data_t& dynamicLinkData) {
-    std::streampos begin = streamIn.tellg();
-
-    std::string dataID;
-    while (SerializationUtils::seekNextDataPoint(streamIn, end, gSERIAL_DATA_PREFIX, dataID)) {
-        if (dataID == gSERIAL_DATA_NAME) {
-            mName = SerializationUtils::readLine(streamIn);
-        } else if (dataID == gSERIAL_DATA_POSITION) {
-            ImVec2 position;
-            streamIn >> position.x;
-            streamIn >> position.y;
-            setAbsolutePosition(position);
-        } else if (dataID == gSERIAL_DATA_INPORT) {
-            std::string uniqueName;
-            int linkID;
-            streamIn >> uniqueName;
-            streamIn >> linkID;
-            staticLinkData[this].emplace_back(uniqueName, linkID);
-        } else if (dataID == gSERIAL_DATA_OUTPORT) {
-            std::string uniqueName;
-            int id;
-            streamIn >> uniqueName;
-            streamIn >> id;
-            staticPortData.emplace(id, std::make_pair(this, uniqueName));
-        } else if (dataID == gSERIAL_DATA_DYNAMIC_INPORT) {
-            std::string uniqueName;
-            int linkID;
-            streamIn >> uniqueName;
-            streamIn >> linkID;
-            dynamicLinkData[this].emplace_back(uniqueName, linkID);
-        } else if (dataID == gSERIAL_DATA_DYNAMIC_OUTPORT) {
-            std::string uniqueName;
-            int id;
-            streamIn >> uniqueName;
-            streamIn >> id;
-            dynamicPortData.emplace(id, std::make_pair(this, uniqueName));
-        } else {
-            SerializationUtils::skipToNextLine(streamIn);
-        }
-    }
+void Node::deserialize(const SerialNode& serialNode) {
+    if (serialNode.hasName)
+        mName = serialNode.name;
+    if (serialNode.hasPosition)
+        setAbsolutePosition(serialNode.position);
 
-    streamIn.seekg(begin);
-    std::streampos markBegin, markEnd;
-    while (SerializationUtils::findNextMarkPair(streamIn, end, gSERIAL_MARK_DATA, markBegin, markEnd)) {
-        streamIn.seekg(markBegin);
-        std::string subdataID;
-        while (SerializationUtils::seekNextDataPoint(streamIn, markEnd, gSERIAL_SUBDATA_PREFIX, subdataID)) {
-            std::streampos current = streamIn.tellg();
-            deserializeData(subdataID, streamIn);
-            streamIn.seekg(current);
-            SerializationUtils::skipToNextLine(streamIn);
-        }
-        streamIn.seekg(markEnd);
+    for (const auto& dataPoint : serialNode.data) {
+        SerializationUtils::ViewStream stream(dataPoint.second);
+        deserializeData(std::string(dataPoint.first), stream);
     }
-    streamIn.seekg(end);
 
     onDeserialize();
 }
@@ -173,11 +98,6 @@ void Node::draw() {
     ed::EndNode();
 }
 
-void Node::drawLinks() {
-    for (auto port : mPorts)
-        port.get().drawLinks();
-}
-
 ImVec2 Node::getAbsolutePosition() const {
     return mPosition;
 }
@@ -208,6 +128,10 @@ void Node::addPort(IPort& port) {
         case IPort::Direction::In  : mInPorts.emplace_back(port) ; break;
         case IPort::Direction::Out : mOutPorts.emplace_back(port); break;
     }
+    mPortNameIndex.emplace(port.getUniqueName(), &port);
+
+    if (mParent)
+        mParent->notifyPortAdded(port);
 }
 
 void Node::removePort(const IPort& port) {
@@ -225,6 +149,30 @@ void Node::removePort(const IPort& port) {
     mPorts.erase(std::remove_if(mPorts.begin(), mPorts.end(), destroyPortCallback), mPorts.end());
     mInPorts.erase(std::remove_if(mInPorts.begin(), mInPorts.end(), removePortCallback), mInPorts.end());
     mOutPorts.erase(std::remove_if(mOutPorts.begin(), mOutPorts.end(), removePortCallback), mOutPorts.end());
+
+    if (mParent)
+        mParent->notifyPortRemoved(port);
+
+    auto indexed = mPortNameIndex.find(port.getUniqueName());
+    if (indexed == mPortNameIndex.end() || indexed->second->getID() != port.getID())
+        return;
+    mPortNameIndex.erase(indexed);
+    for (auto& other : mPorts) {
+        if (other.get().getUniqueName() == port.getUniqueName()) {
+            mPortNameIndex.emplace(other.get().getUniqueName(), &other.get());
+            break;
+        }
+    }
+}
+
+std::size_t Node::getMemoryUsage() const {
+    std::size_t usage = sizeof(Node) + getHeapUsage(mName) +
+        (mPorts.capacity() + mInPorts.capacity() + mOutPorts.capacity()) * sizeof(std::reference_wrapper<IPort>) +
+        mPortNameIndex.bucket_count() * sizeof(void*) +
+        mPortNameIndex.size() * (sizeof(decltype(mPortNameIndex)::value_type) + sizeof(void*) + sizeof(std::size_t));
+    for (const auto& port : mPorts)
+        usage += port.get().getMemoryUsage();
+    return usage;
 }
 
 size_t Node::numPorts() const {
@@ -232,10 +180,8 @@ size_t Node::numPorts() const {
 }
 
 IPort* Node::getPortByName(const std::string& uniqueName) {
-    for (auto& port : mPorts)
-        if (port.get().getUniqueName() == uniqueName)
-            return &port.get();
-    return nullptr;
+    auto match = mPortNameIndex.find(uniqueName);
+    return match == mPortNameIndex.end() ? nullptr : match->second;
 }
 
 IPort& Node::getPortByIndex(size_t i) {
@@ -243,12 +189,26 @@ IPort& Node::getPortByIndex(size_t i) {
 }
 
 IPort* Node::getPort(int portID) {
+    if (mParent) {
+        IPort* port = mParent->findPort(portID);
+        return port && &port->getParent() == this ? port : nullptr;
+    }
     for (auto& port : mPorts)
         if (port.get().getID() == portID)
             return &port.get();
     return nullptr;
 }
 
+void Node::notifyLinked(IPort& port, IPort& linkTo, int linkID) {
+    if (mParent)
+        mParent->notifyLinked(port, linkTo, linkID);
+}
+
+void Node::notifyUnlinked(int linkID) {
+    if (mParent)
+        mParent->notifyUnlinked(linkID);
+}
+
 void Node::markDirty() {
     mIsDirty = true;
     mParent->markDirty();
@@ -1,4 +1,5 @@
 #pragma once
+#include "GraphFormat.h"
 #include "../Utils/ImUtils.h"
 
 #include <glm/vec2.hpp>
@@ -11,6 +12,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -25,9 +27,6 @@ namespace ax::NodeEditor {
 
 class Node {
 public:
-    typedef std::unordered_map<int, std::pair<Node*, std::string>> port_data_t;
-    typedef std::unordered_map<Node*, std::vector<std::pair<std::string, int>>> link_data_t;
-
     virtual ~Node();
 
     void setParent(Graph* parent);
@@ -43,13 +42,17 @@ public:
         return true;
     }
 
-    void serialize(std::ofstream& streamOut) const;
-    void deserialize(std::ifstream& streamIn, std::streampos end,
-                     port_data_t& staticPortData, link_data_t& staticLinkData,
-                     port_data_t& dynamicPortData, link_data_t& dynamicLinkData);
+    /**
+     * @brief Write this node's header, ports and custom data into serialNode.
+     * @param graph Owner of any strings generated by this node.
+     */
+    void serialize(SerialGraph& graph, SerialNode& serialNode) const;
+    /**
+     * @brief Restore this node's header and custom data from serialNode. Links are restored separately by the graph.
+     */
+    void deserialize(const SerialNode& serialNode);
 
     void draw();
-    void drawLinks();
 
     void setAbsolutePosition(const ImVec2& pos);
     [[nodiscard]] ImVec2 getAbsolutePosition() const;
@@ -67,12 +70,31 @@ public:
         return mName;
     }
 
+    /**
+     * @returns Approximate number of bytes used by this node and its ports, not counting any other data held by
+     * derived types.
+     */
+    [[nodiscard]] std::size_t getMemoryUsage() const;
+
     [[nodiscard]] size_t numPorts() const;
 
     [[nodiscard]] IPort* getPortByName(const std::string& uniqueName);
     [[nodiscard]] IPort& getPortByIndex(size_t i);
+    /**
+     * @returns Port of this node with the given ID, or nullptr if there is no such port. Looked up through the
+     * parent graph's port index once this node has been added to a graph.
+     */
     [[nodiscard]] IPort* getPort(int portID);
 
+    /**
+     * @brief Called by a port of this node whenever it gains a link.
+     */
+    void notifyLinked(IPort& port, IPort& linkTo, int linkID);
+    /**
+     * @brief Called by a port of this node whenever it loses a link, before any of its unlink events.
+     */
+    void notifyUnlinked(int linkID);
+
     void markDirty();
     void markClean();
     [[nodiscard]] inline bool isDirty() const {
@@ -95,7 +117,7 @@ protected:
     explicit Node(std::string title);
 
     [[nodiscard]] virtual std::vector<std::pair<std::string, std::string>> generateSerializedData() const = 0;
-    virtual void deserializeData(const std::string& dataID, std::ifstream& stream) = 0;
+    virtual void deserializeData(const std::string& dataID, std::istream& stream) = 0;
 
     virtual void onDeserialize() {}
 
@@ -137,6 +159,10 @@ private:
     std::vector<std::reference_wrapper<IPort>> mPorts;
     std::vector<std::reference_wrapper<IPort>> mInPorts;
     std::vector<std::reference_wrapper<IPort>> mOutPorts;
+    /**
+     * @brief Keyed by the interned unique names of the ports (see IPort::internName()).
+     */
+    std::unordered_map<std::string_view, IPort*> mPortNameIndex;
 
     bool mIsDirty = true;
 
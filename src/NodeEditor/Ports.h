@@ -14,10 +14,13 @@
 #include <imgui_node_editor.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <memory>
-#include <set>
-#include <typeindex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 #include <variant>
 
@@ -35,8 +38,35 @@ enum class PinShape {
     Arrow,
 };
 
+/**
+ * @brief Set of types carried by a port, with one bit per alternative of IPort::value_t (see portTypeMask()).
+ */
+typedef std::uint32_t port_type_mask_t;
+
+/**
+ * @brief Appearance of the pins of ports carrying a particular set of types.
+ */
+struct PinStyle {
+    float size;
+    PinShape shape;
+    ImU32 colour;
+    const char* tooltip;
+};
+
 class IPort {
 public:
+    /**
+     * @brief Every type a port may carry. Values are passed between linked ports as this, which holds any of them
+     * inline (and so never allocates).
+     */
+    typedef std::variant<
+        Node*,
+        int, glm::ivec2, glm::ivec3, glm::ivec4,
+        float, glm::vec2, glm::vec3, glm::vec4,
+        glm::mat2, glm::mat3, glm::mat4,
+        Framebuffer*, Mesh*, Shader*, Texture*
+    > value_t;
+
     typedef std::function<bool(IPort& linkTo)> validate_link_callback;
     typedef std::function<void()> on_link_callback;
     typedef std::function<void()> on_value_update_callback;
@@ -47,6 +77,25 @@ public:
         Out,
     };
 
+    /**
+     * @brief Port value traffic over a single frame.
+     */
+    struct EvaluationStats {
+        /**
+         * @brief Values read from ports with a getValue callback, each of which would be an evaluation without
+         * caching.
+         */
+        std::size_t reads = 0;
+        /**
+         * @brief Calls to a getValue callback.
+         */
+        std::size_t evaluations = 0;
+        /**
+         * @brief Calls to IPort::halfValueUpdated().
+         */
+        std::size_t invalidations = 0;
+    };
+
     IPort() = default;
     virtual ~IPort() = default;
 
@@ -110,14 +159,20 @@ public:
     virtual void halfUnlink(IPort* unlinkFrom) = 0;
 
     /**
-     * @brief Call any update events in this port or a linked port, if present.
+     * @brief Invalidate the value of this port and any linked ports, and call their update events.
      * @see <a href="IPort::addOnUpdateEvent(const on_value_update_callback& callback)">addOnUpdateEvent</a>
      */
     virtual void valueUpdated() = 0;
     /**
-     * @brief Call any update events in this port, without affecting any linked ports.
+     * @brief Invalidate the value of this port (see IPort::getVersion()) and call its update events, without
+     * affecting any linked ports.
      */
     virtual void halfValueUpdated() = 0;
+    /**
+     * @returns Stamp which increases every time the value of this port (or a port linked to it) is invalidated,
+     * including when linked or unlinked. Consumers may hold on to a value read from this port until it changes.
+     */
+    [[nodiscard]] virtual std::uint64_t getVersion() const = 0;
 
     [[nodiscard]] virtual bool isLinked() const = 0;
     [[nodiscard]] virtual bool isLinkedWith(IPort& other) const = 0;
@@ -159,34 +214,119 @@ public:
     [[nodiscard]] virtual const std::string& getDisplayName() const = 0;
 
     virtual void drawPort() = 0;
-    virtual void drawLinks() = 0;
 
     virtual void setTooltip(const std::string& tooltip) = 0;
 
-    [[nodiscard]] virtual std::set<std::type_index> getParameterTypes() const = 0;
+    [[nodiscard]] virtual port_type_mask_t getTypeMask() const = 0;
+
+    /**
+     * @returns Approximate number of bytes used by this port, including any heap memory it owns (but not its names,
+     * which are shared, see IPort::internName()).
+     */
+    [[nodiscard]] virtual std::size_t getMemoryUsage() const = 0;
+
+    /**
+     * @return Value resulting from this port's getValue callback (see Port::getValue()).
+     */
+    [[nodiscard]] virtual value_t getPortValue() const = 0;
+    /**
+     * @return Value retrieved from the first port linked to this port (see Port::getLinkedValue()).
+     */
+    [[nodiscard]] virtual value_t getLinkedPortValue() const = 0;
+
+    /**
+     * @brief Start a new frame, discarding every cached port value.
+     */
+    static inline void beginFrame() {
+        sLastFrameStats = sFrameStats;
+        sFrameStats = EvaluationStats();
+        sFrame++;
+    }
+    [[nodiscard]] static inline const EvaluationStats& getLastFrameStats() {
+        return sLastFrameStats;
+    }
+
+    /**
+     * @returns Shared copy of name, which lives until every call to internName() for it has been matched by a call to
+     * releaseName(). Ports store their names this way, as the same few names are repeated across every node of a
+     * type.
+     */
+    static inline const std::string& internName(std::string name) {
+        auto entry = sNames.try_emplace(std::move(name), 0).first;
+        entry->second++;
+        return entry->first;
+    }
+    /**
+     * @brief Release a reference to a name returned by internName(), freeing it if it is no longer used.
+     */
+    static inline void releaseName(const std::string& name) {
+        auto entry = sNames.find(name);
+        if (entry != sNames.end() && --entry->second == 0)
+            sNames.erase(entry);
+    }
+    /**
+     * @returns Approximate number of bytes used by every interned name.
+     */
+    [[nodiscard]] static std::size_t getNameMemoryUsage();
+protected:
+    static std::uint64_t sVersionCounter;
+    static std::uint64_t sFrame;
+
+    static EvaluationStats sFrameStats;
+    static EvaluationStats sLastFrameStats;
 
-    [[nodiscard]] virtual std::any getAnyValue() const = 0;
-    [[nodiscard]] virtual std::any getAnyLinkedValue() const = 0;
+    /**
+     * @brief Interned names, with the number of references to each.
+     */
+    static std::unordered_map<std::string, std::size_t> sNames;
 };
 
-template<typename... Ts>
-std::size_t typeHash() {
-    size_t result = 0;
-    std::unordered_set<std::type_index> typeSet = { std::type_index(typeid(Ts))... };
+inline std::uint64_t IPort::sVersionCounter = 0;
+inline std::uint64_t IPort::sFrame = 0;
+
+inline IPort::EvaluationStats IPort::sFrameStats{};
+inline IPort::EvaluationStats IPort::sLastFrameStats{};
 
-    for (const auto& type : typeSet)
-        result ^= type.hash_code();
+inline std::unordered_map<std::string, std::size_t> IPort::sNames{};
 
-    return result;
+/**
+ * @returns Number of bytes allocated by str, other than the std::string itself.
+ */
+inline std::size_t getHeapUsage(const std::string& str) {
+    return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
 }
 
-void parsePinTypeData(size_t pinHash, float& pinSize, PinShape& shape, ImU32& colour, std::string& tooltip);
+inline std::size_t IPort::getNameMemoryUsage() {
+    std::size_t usage = sNames.bucket_count() * sizeof(void*);
+    for (const auto& [name, numReferences] : sNames)
+        usage += sizeof(std::string) + sizeof(numReferences) + sizeof(void*) + sizeof(std::size_t) + getHeapUsage(name);
+    return usage;
+}
+
+static_assert(std::variant_size_v<IPort::value_t> <= sizeof(port_type_mask_t) * 8,
+              "IPort::value_t has more types than port_type_mask_t has bits");
+
+/**
+ * @returns Mask with the bit of each of Types set. Every type must be listed in IPort::value_t.
+ */
+template<typename... Types>
+constexpr port_type_mask_t portTypeMask() {
+    return ((port_type_mask_t(1) << VariantIndex<Types, IPort::value_t>::value) | ...);
+}
+
+/**
+ * @returns Style of the pins of ports carrying exactly the types in typeMask (or a default style for any unknown
+ * combination of types).
+ */
+const PinStyle& getPinStyle(port_type_mask_t typeMask);
 
 template<typename... Types>
 class Port final : public IPort {
 public:
     typedef std::function<std::variant<Types...>()> value_get_callback;
 
+    static constexpr port_type_mask_t cTYPE_MASK = portTypeMask<Types...>();
+
     /**
      * @brief Construct a new port.
      * @param parent Parent node which contains this port.
@@ -199,15 +339,14 @@ public:
     Port(Node& parent, Direction direction, std::string uniqueName, std::string displayName,
         const value_get_callback& getValue = nullptr, bool useDefault = false, bool isDynamic = false) :
         mID(gGraphIDCounter++), mParent(parent),
-        mDirection(direction), mUniqueName(std::move(uniqueName)), mDisplayName(std::move(displayName)),
-        mGetValue(getValue), mUseDefault(useDefault), mIsDynamic(isDynamic) {
-        generatePinData();
-        switch (mDirection) {
-            case Direction::In  : mDrawPort = [this]() { drawIn();  }; break;
-            case Direction::Out : mDrawPort = [this]() { drawOut(); }; break;
-        }
+        mDirection(direction), mUniqueName(internName(std::move(uniqueName))),
+        mDisplayName(internName(std::move(displayName))),
+        mGetValue(getValue), mUseDefault(useDefault), mIsDynamic(isDynamic), mPinStyle(getStyle()) {}
+    Port(const Port&) = delete;
+    ~Port() final {
+        releaseName(mUniqueName);
+        releaseName(mDisplayName);
     }
-    ~Port() final = default;
 
     void safeDestroy() final {
         for (const Link& l : mLinks)
@@ -216,22 +355,23 @@ public:
     }
 
     void addValidateLinkEvent(const validate_link_callback& callback) final {
-        mValidateLinks.emplace_back(callback);
+        getEvents().validateLinks.emplace_back(callback);
     }
     void addOnLinkEvent(const on_link_callback& callback) final {
-        mOnLinks.emplace_back(callback);
+        getEvents().onLinks.emplace_back(callback);
     }
     void addOnUpdateEvent(const on_value_update_callback& callback) final {
-        mOnUpdates.emplace_back(callback);
+        getEvents().onUpdates.emplace_back(callback);
     }
     void addOnUnlinkEvent(const on_unlink_callback& callback) final {
-        mOnUnlinks.emplace_back(callback);
+        getEvents().onUnlinks.emplace_back(callback);
     }
 
     bool validateLink(IPort& linkTo) final {
-        for (const auto& callback : mValidateLinks)
-            if (!callback(linkTo))
-                return false;
+        if (mEvents)
+            for (const auto& callback : mEvents->validateLinks)
+                if (!callback(linkTo))
+                    return false;
         return true;
     }
 
@@ -251,8 +391,10 @@ public:
     }
     void halfLink(IPort& linkTo, int linkID) final {
         mLinks.push_back(Link{ &linkTo, linkID });
-        for (const auto& callback : mOnLinks)
-            callback();
+        mParent.notifyLinked(*this, linkTo, linkID);
+        if (mEvents)
+            for (const auto& callback : mEvents->onLinks)
+                callback();
         valueUpdated();
     }
     void unlink(IPort* unlinkFrom) final {
@@ -273,17 +415,24 @@ public:
         }
     }
     void unlink(int linkID) final {
-        for (Link& l : mLinks)
-            if (l.linkID == linkID)
+        for (Link& l : mLinks) {
+            if (l.linkID == linkID) {
                 unlink(l.linkTo);
+                break;
+            }
+        }
     }
     void halfUnlink(IPort* unlinkFrom) final {
+        for (const Link& l : mLinks)
+            if (unlinkFrom == nullptr || l.linkTo == unlinkFrom)
+                mParent.notifyUnlinked(l.linkID);
         if (unlinkFrom == nullptr)
             mLinks.clear();
         else
             mLinks.erase(std::remove_if(mLinks.begin(), mLinks.end(), [unlinkFrom](Link& l) { return l.linkTo == unlinkFrom; }), mLinks.end());
-        for (const auto& callback : mOnUnlinks)
-            callback();
+        if (mEvents)
+            for (const auto& callback : mEvents->onUnlinks)
+                callback();
         valueUpdated();
     }
 
@@ -293,8 +442,14 @@ public:
             l.linkTo->halfValueUpdated();
     }
     void halfValueUpdated() final {
-        for (const auto& callback : mOnUpdates)
-            callback();
+        mVersion = ++sVersionCounter;
+        sFrameStats.invalidations++;
+        if (mEvents)
+            for (const auto& callback : mEvents->onUpdates)
+                callback();
+    }
+    [[nodiscard]] std::uint64_t getVersion() const final {
+        return mVersion;
     }
 
     [[nodiscard]] bool isLinked() const final {
@@ -345,28 +500,52 @@ public:
     }
 
     void drawPort() final {
-        mDrawPort();
-    }
-    void drawLinks() final {
-        if (mDirection == Direction::In)
-            for (const Link& l : mLinks)
-                ed::Link(l.linkID, l.linkTo->getID(), getID());
+        switch (mDirection) {
+            case Direction::In  : drawIn();  break;
+            case Direction::Out : drawOut(); break;
+        }
     }
 
     void setTooltip(const std::string& tooltip) final {
         mPinTooltip = tooltip;
     }
 
-    [[nodiscard]] std::set<std::type_index> getParameterTypes() const final {
-        return { typeid(Types)... };
-    };
+    [[nodiscard]] port_type_mask_t getTypeMask() const final {
+        return cTYPE_MASK;
+    }
+
+    [[nodiscard]] std::size_t getMemoryUsage() const final {
+        std::size_t usage = sizeof(*this) + mLinks.capacity() * sizeof(Link) + getHeapUsage(mPinTooltip);
+        if (mDefaultValue)
+            usage += sizeof(std::variant<Types...>);
+        if (mEvents)
+            usage += sizeof(Events) + mEvents->validateLinks.capacity() * sizeof(validate_link_callback) +
+                     mEvents->onLinks.capacity() * sizeof(on_link_callback) +
+                     mEvents->onUpdates.capacity() * sizeof(on_value_update_callback) +
+                     mEvents->onUnlinks.capacity() * sizeof(on_unlink_callback);
+        return usage;
+    }
 
     /**
      * @brief Will cause undefined behaviour if no getValue callback is defined for this port.
+     * @brief Values (other than pointers, which are cheap to get and may change without invalidating this port) are
+     * cached until this port is invalidated or the frame ends, so are evaluated at most once per frame.
      * @return Value resulting from the getValue callback passed during construction (see Port::Port).
      */
     std::variant<Types...> getValue() const {
-        return mGetValue();
+        sFrameStats.reads++;
+        if constexpr (cCACHE_VALUES) {
+            if (mCache.value && mCache.version == mVersion && mCache.frame == sFrame)
+                return *mCache.value;
+            sFrameStats.evaluations++;
+            mCache.value = mGetValue();
+            mCache.version = mVersion;
+            mCache.frame = sFrame;
+            return *mCache.value;
+        } else {
+            sFrameStats.evaluations++;
+            return mGetValue();
+        }
     }
     /**
      * @brief Will cause undefined behaviour if no getValue callback is defined for this port, or if T is not one of
@@ -386,7 +565,7 @@ public:
      * is present.
      */
     std::variant<Types...> getLinkedValue(size_t linkIndex = 0) const {
-        return mLinks[linkIndex].linkTo ? anyToVariant<Types...>(mLinks[linkIndex].linkTo->getAnyValue()) : *mDefaultValue;
+        return mLinks[linkIndex].linkTo ? fromPortValue(mLinks[linkIndex].linkTo->getPortValue()) : *mDefaultValue;
     }
     /**
      * @brief Will cause undefined behaviour if no getValue callback is defined for the port linked to this port, or if
@@ -402,124 +581,126 @@ public:
         }, getLinkedValue(linkIndex));
     }
 
-    [[nodiscard]] std::any getAnyValue() const final {
-        return std::visit([](const auto& arg)->std::any { return arg; }, getValue());
+    [[nodiscard]] value_t getPortValue() const final {
+        return std::visit([](const auto& arg)->value_t { return arg; }, getValue());
     }
-    [[nodiscard]] std::any getAnyLinkedValue() const final {
-        return std::visit([](const auto& arg)->std::any { return arg; }, getLinkedValue());
+    [[nodiscard]] value_t getLinkedPortValue() const final {
+        return std::visit([](const auto& arg)->value_t { return arg; }, getLinkedValue());
     }
 private:
-    typedef std::function<void()> draw_port_callback;
-    typedef std::function<void()> draw_pin_callback;
+    /**
+     * @brief Event callbacks, which most ports have none of.
+     */
+    struct Events {
+        std::vector<validate_link_callback> validateLinks;
+        std::vector<on_link_callback> onLinks;
+        std::vector<on_value_update_callback> onUpdates;
+        std::vector<on_unlink_callback> onUnlinks;
+    };
+
+    struct ValueCache {
+        std::optional<std::variant<Types...>> value{};
+        std::uint64_t version = 0;
+        std::uint64_t frame = 0;
+    };
+
+    static_assert((VariantContains<Types, value_t>::value && ...), "Port types must be listed in IPort::value_t");
+
+    static constexpr bool cCACHE_VALUES = (!std::is_pointer_v<Types> && ...);
+
+    /**
+     * @brief value must hold one of Types, which is guaranteed for any linked port by isTypeMatch().
+     */
+    static std::variant<Types...> fromPortValue(const value_t& value) {
+        return std::visit([](const auto& arg)->std::variant<Types...> {
+            using value_type = std::decay_t<decltype(arg)>;
+            if constexpr ((std::is_same_v<value_type, Types> || ...))
+                return arg;
+            else
+                throw std::runtime_error("Unsupported type");
+        }, value);
+    }
 
     struct Link {
         IPort* linkTo;
         int linkID;
     };
 
+    /**
+     * @returns true if every type an output may carry can be taken by the input.
+     */
     [[nodiscard]] bool isTypeMatch(IPort& other) const {
-        const auto thisTypes = getParameterTypes();
-        const auto otherTypes = other.getParameterTypes();
         switch (mDirection) {
             default: return false;
-            case Direction::Out:
-                return std::includes(otherTypes.begin(), otherTypes.end(), thisTypes.begin(), thisTypes.end());
-            case Direction::In:
-                return std::includes(thisTypes.begin(), thisTypes.end(), otherTypes.begin(), otherTypes.end());
+            case Direction::Out: return (cTYPE_MASK & ~other.getTypeMask()) == 0;
+            case Direction::In:  return (other.getTypeMask() & ~cTYPE_MASK) == 0;
         }
     }
 
+    /**
+     * @brief Looked up once per set of types.
+     */
+    static const PinStyle& getStyle() {
+        static const PinStyle& cSTYLE = getPinStyle(cTYPE_MASK);
+        return cSTYLE;
+    }
+
     void drawIn() {
         ed::BeginPin(mID, ed::PinKind::Input);
         ed::PinPivotAlignment(ImVec2(0.0f, 0.5f));
         ed::PinPivotSize(ImVec2(0.0f, 0.0f));
 
-        mDrawPin();
+        drawPin();
         if (ImGui::IsItemHovered())
-            ImUtils::postTooltip([this]() { ImGui::TextUnformatted(mPinTooltip.c_str()); });
+            ImUtils::postTooltip([this]() { ImGui::TextUnformatted(getTooltip()); });
         ImGui::SameLine();
         ImGui::TextUnformatted(mDisplayName.c_str());
 
         ed::EndPin();
     }
     void drawOut() {
-        ImGui::SameLine(mParent.getSize().x - ImGui::CalcTextSize(mDisplayName.c_str()).x - ImGui::GetStyle().FramePadding.x * 2.0f - ed::GetStyle().NodePadding.x - ed::GetStyle().NodePadding.z - mPinSize);
+        ImGui::SameLine(mParent.getSize().x - ImGui::CalcTextSize(mDisplayName.c_str()).x - ImGui::GetStyle().FramePadding.x * 2.0f - ed::GetStyle().NodePadding.x - ed::GetStyle().NodePadding.z - mPinStyle.size);
         ed::BeginPin(mID, ed::PinKind::Output);
         ed::PinPivotAlignment(ImVec2(1.0f, 0.5f));
         ed::PinPivotSize(ImVec2(0.0f, 0.0f));
 
         ImGui::TextUnformatted(mDisplayName.c_str());
         ImGui::SameLine();
-        mDrawPin();
+        drawPin();
         if (ImGui::IsItemHovered())
-            ImUtils::postTooltip([this]() { ImGui::TextUnformatted(mPinTooltip.c_str()); });
+            ImUtils::postTooltip([this]() { ImGui::TextUnformatted(getTooltip()); });
 
         ed::EndPin();
     }
 
-    void generatePinCallback(PinShape shape, ImU32 colour) {
-        float pinSize = mPinSize;
-        switch (shape) {
+    void drawPin() const {
+        const float size = mPinStyle.size;
+        const ImU32 colour = mPinStyle.colour;
+        switch (mPinStyle.shape) {
             default:
-            case PinShape::Circle:
-                mDrawPin = [pinSize, colour]() {
-                    ImUtils::Pins::circleIcon(pinSize, colour, ImColor(0.0f, 0.0f, 0.0f));
-                };
-                break;
-            case PinShape::Octagon:
-                mDrawPin = [pinSize, colour]() {
-                    ImUtils::Pins::nGonIcon(pinSize, 8, colour, ImColor(0.0f, 0.0f, 0.0f));
-                };
-                break;
-            case PinShape::Septagon:
-                mDrawPin = [pinSize, colour]() {
-                    ImUtils::Pins::nGonIcon(pinSize, 7, colour, ImColor(0.0f, 0.0f, 0.0f));
-                };
-                break;
-            case PinShape::Hexagon:
-                mDrawPin = [pinSize, colour]() {
-                    ImUtils::Pins::nGonIcon(pinSize, 6, colour, ImColor(0.0f, 0.0f, 0.0f));
-                };
-                break;
-            case PinShape::Pentagon:
-                mDrawPin = [pinSize, colour]() {
-                    ImUtils::Pins::nGonIcon(pinSize, 5, colour, ImColor(0.0f, 0.0f, 0.0f));
-                };
-                break;
-            case PinShape::FlatSquare:
-                mDrawPin = [pinSize, colour]() {
-                    ImUtils::Pins::squareIcon(pinSize, colour, ImColor(0.0f, 0.0f, 0.0f));
-                };
-                break;
-            case PinShape::Square:
-                mDrawPin = [pinSize, colour]() {
-                    ImUtils::Pins::nGonIcon(pinSize, 4, colour, ImColor(0.0f, 0.0f, 0.0f));
-                };
-                break;
-            case PinShape::Triangle:
-                mDrawPin = [pinSize, colour]() {
-                    ImUtils::Pins::nGonIcon(pinSize, 3, colour, ImColor(0.0f, 0.0f, 0.0f));
-                };
-                break;
-            case PinShape::Arrow:
-                mDrawPin = [pinSize, colour]() {
-                    ImUtils::Pins::arrowIcon(pinSize, colour, ImColor(0.0f, 0.0f, 0.0f));
-                };
-                break;
+            case PinShape::Circle     : ImUtils::Pins::circleIcon(size, colour, ImColor(0.0f, 0.0f, 0.0f)); break;
+            case PinShape::Octagon    : ImUtils::Pins::nGonIcon(size, 8, colour, ImColor(0.0f, 0.0f, 0.0f)); break;
+            case PinShape::Septagon   : ImUtils::Pins::nGonIcon(size, 7, colour, ImColor(0.0f, 0.0f, 0.0f)); break;
+            case PinShape::Hexagon    : ImUtils::Pins::nGonIcon(size, 6, colour, ImColor(0.0f, 0.0f, 0.0f)); break;
+            case PinShape::Pentagon   : ImUtils::Pins::nGonIcon(size, 5, colour, ImColor(0.0f, 0.0f, 0.0f)); break;
+            case PinShape::FlatSquare : ImUtils::Pins::squareIcon(size, colour, ImColor(0.0f, 0.0f, 0.0f)); break;
+            case PinShape::Square     : ImUtils::Pins::nGonIcon(size, 4, colour, ImColor(0.0f, 0.0f, 0.0f)); break;
+            case PinShape::Triangle   : ImUtils::Pins::nGonIcon(size, 3, colour, ImColor(0.0f, 0.0f, 0.0f)); break;
+            case PinShape::Arrow      : ImUtils::Pins::arrowIcon(size, colour, ImColor(0.0f, 0.0f, 0.0f)); break;
         }
     }
 
-    void generatePinData() {
-        size_t hash = typeHash<Types...>();
-        PinShape shape;
-        ImU32 colour;
-        parsePinTypeData(hash, mPinSize, shape, colour, mPinTooltip);
-        generatePinCallback(shape, colour);
+    Events& getEvents() {
+        if (!mEvents)
+            mEvents = std::make_unique<Events>();
+        return *mEvents;
+    }
+
+    [[nodiscard]] const char* getTooltip() const {
+        return mPinTooltip.empty() ? mPinStyle.tooltip : mPinTooltip.c_str();
     }
 
     value_get_callback mGetValue;
-    draw_port_callback mDrawPort;
-    draw_pin_callback mDrawPin;
 
     Node& mParent;
 
@@ -527,20 +708,30 @@ private:
 
     Direction mDirection;
 
-    std::string mDisplayName;
-    std::string mUniqueName;
-
     bool mIsDynamic;
     bool mUseDefault;
+
+    const std::string& mDisplayName;
+    const std::string& mUniqueName;
+
     std::unique_ptr<std::variant<Types...>> mDefaultValue = nullptr;
 
     std::vector<Link> mLinks{};
 
-    std::vector<validate_link_callback> mValidateLinks;
-    std::vector<on_link_callback> mOnLinks;
-    std::vector<on_value_update_callback> mOnUpdates;
-    std::vector<on_unlink_callback> mOnUnlinks;
+    std::uint64_t mVersion = 0;
+    /**
+     * @brief Only present for types which are cached (see Port::getValue()).
+     */
+    [[no_unique_address]] mutable std::conditional_t<cCACHE_VALUES, ValueCache, std::monostate> mCache{};
+
+    /**
+     * @brief Only allocated once a callback is added.
+     */
+    std::unique_ptr<Events> mEvents = nullptr;
 
-    float mPinSize = 0.0f;
+    const PinStyle& mPinStyle;
+    /**
+     * @brief Overrides the style's tooltip if set.
+     */
     std::string mPinTooltip;
 };
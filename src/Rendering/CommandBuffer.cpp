@@ -0,0 +1,78 @@
+#include "CommandBuffer.h"
+
+#include <algorithm>
+
+void CommandBuffer::clear() {
+    mCommands.clear();
+    mStates.clear();
+    mTextures.clear();
+    mCallbacks.clear();
+    mOpenLoops.clear();
+    mMaxLoopDepth = 0;
+}
+
+void CommandBuffer::bindFramebuffer(Framebuffer& framebuffer) {
+    push(CommandType::BindFramebuffer).framebuffer = &framebuffer;
+}
+
+void CommandBuffer::useProgram(const Shader& shader) {
+    push(CommandType::UseProgram).shader = &shader;
+}
+
+void CommandBuffer::setUniforms(Shader& shader, const uniform_values_t& values) {
+    push(CommandType::SetUniforms).uniforms = {&shader, &values};
+}
+
+void CommandBuffer::setState(const RenderState& state) {
+    push(CommandType::SetState).state = (std::uint32_t)mStates.size();
+    mStates.push_back(state);
+}
+
+void CommandBuffer::bindTextures(const std::vector<Texture*>& textures) {
+    push(CommandType::BindTextures).textures = {(std::uint32_t)mTextures.size(), (std::uint32_t)textures.size()};
+    mTextures.insert(mTextures.end(), textures.begin(), textures.end());
+}
+
+void CommandBuffer::bindVAO(const Mesh& mesh) {
+    push(CommandType::BindVAO).mesh = &mesh;
+}
+
+void CommandBuffer::draw(const Mesh& mesh) {
+    push(CommandType::Draw).mesh = &mesh;
+}
+
+void CommandBuffer::unbind() {
+    push(CommandType::Unbind);
+}
+
+void CommandBuffer::callback(std::function<void()> function) {
+    push(CommandType::Callback).callback = (std::uint32_t)mCallbacks.size();
+    mCallbacks.push_back(std::move(function));
+}
+
+void CommandBuffer::beginLoop(std::uint32_t count) {
+    mOpenLoops.push_back((std::uint32_t)mCommands.size());
+    mMaxLoopDepth = std::max(mMaxLoopDepth, mOpenLoops.size());
+    push(CommandType::LoopBegin).loop = {count, 0};
+}
+
+void CommandBuffer::endLoop() {
+    const std::uint32_t begin = mOpenLoops.back();
+    mOpenLoops.pop_back();
+
+    const std::uint32_t end = (std::uint32_t)mCommands.size();
+    mCommands[begin].loop.jump = end;
+    push(CommandType::LoopEnd).loop = {mCommands[begin].loop.count, begin};
+}
+
+void CommandBuffer::setLoopIndex(Shader& shader, int location, std::uint32_t depth) {
+    push(CommandType::LoopIndex).loopIndex = {&shader, location, depth};
+}
+
+void CommandBuffer::beginTimer(int id) {
+    push(CommandType::BeginTimer).timer = id;
+}
+
+void CommandBuffer::endTimer(int id) {
+    push(CommandType::EndTimer).timer = id;
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include "RenderConfig.h"
+#include "Shader.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+class Framebuffer;
+class Mesh;
+class Texture;
+
+/**
+ * @brief Flat list of render commands making up a compiled pipeline, executed in order by Renderer::drawScene().
+ * @brief Commands are plain data referencing the objects they operate on. Anything too large to store inline
+ * (render states, texture lists and arbitrary callbacks) is kept in a side array and referenced by index.
+ */
+class CommandBuffer {
+public:
+    typedef std::vector<std::pair<int, Shader::uniform_t>> uniform_values_t;
+
+    /**
+     * @brief Fixed function state applied by a SetState command. A zero viewport means the default viewport.
+     */
+    struct RenderState {
+        glm::vec4 viewport = glm::vec4(0.0f);
+
+        bool enableBlend = false;
+        RenderConfig::BlendFuncSrc blendFuncSrc = RenderConfig::BlendFuncSrc::One;
+        RenderConfig::BlendFuncDst blendFuncDst = RenderConfig::BlendFuncDst::Zero;
+
+        glm::bvec4 colourMask = glm::bvec4(true);
+
+        bool enableFaceCulling = true;
+        RenderConfig::CullFaceMode cullFaceMode = RenderConfig::CullFaceMode::Back;
+
+        bool enableDepthTest = false;
+        RenderConfig::DepthTestFunc depthTestFunc = RenderConfig::DepthTestFunc::Less;
+        glm::vec2 depthTestLimits = glm::vec2(0.0f, 1.0f);
+
+        bool enableDepthMask = false;
+
+        /**
+         * @brief Clear all buffers (after applying the rest of the state).
+         */
+        bool doClear = false;
+        glm::vec4 clearColour = glm::vec4(0.0f);
+    };
+
+    enum class CommandType : std::uint8_t {
+        BindFramebuffer,
+        UseProgram,
+        SetUniforms,
+        SetState,
+        BindTextures,
+        BindVAO,
+        Draw,
+        Unbind,
+        Callback,
+        LoopBegin,
+        LoopEnd,
+        LoopIndex,
+        BeginTimer,
+        EndTimer,
+    };
+
+    struct UniformValues {
+        Shader* shader;
+        const uniform_values_t* values;
+    };
+    /**
+     * @brief Range of the texture list, bound to consecutive slots starting at 0.
+     */
+    struct TextureRange {
+        std::uint32_t first;
+        std::uint32_t count;
+    };
+    /**
+     * @brief Trip count of a loop, and the index of the matching LoopEnd (for LoopBegin) or LoopBegin (for LoopEnd).
+     */
+    struct LoopRange {
+        std::uint32_t count;
+        std::uint32_t jump;
+    };
+    struct LoopIndex {
+        Shader* shader;
+        int location;
+        /**
+         * @brief Nesting depth of the loop whose index is used, where 0 is the outermost loop.
+         */
+        std::uint32_t depth;
+    };
+
+    struct Command {
+        CommandType type;
+        union {
+            Framebuffer* framebuffer;
+            const Shader* shader;
+            UniformValues uniforms;
+            /**
+             * @brief Index into the render states.
+             */
+            std::uint32_t state;
+            TextureRange textures;
+            const Mesh* mesh;
+            /**
+             * @brief Index into the callbacks.
+             */
+            std::uint32_t callback;
+            LoopRange loop;
+            LoopIndex loopIndex;
+            /**
+             * @brief ID of the pass timed (see PassProfiler).
+             */
+            int timer;
+        };
+    };
+
+    void clear();
+
+    void bindFramebuffer(Framebuffer& framebuffer);
+    void useProgram(const Shader& shader);
+    /**
+     * @brief Apply values (location, value pairs) to shader, which must be in use. values is read when the command
+     * is executed, so must outlive the command buffer.
+     */
+    void setUniforms(Shader& shader, const uniform_values_t& values);
+    void setState(const RenderState& state);
+    void bindTextures(const std::vector<Texture*>& textures);
+    void bindVAO(const Mesh& mesh);
+    void draw(const Mesh& mesh);
+    /**
+     * @brief Rebind the default framebuffer.
+     */
+    void unbind();
+    /**
+     * @brief Call an arbitrary function (for pipelines not built from render passes).
+     */
+    void callback(std::function<void()> function);
+    /**
+     * @brief Repeat every command up to the matching endLoop() count times (or skip them if count is 0). Loops may be
+     * nested.
+     */
+    void beginLoop(std::uint32_t count);
+    void endLoop();
+    /**
+     * @brief Set the int uniform at location to the current iteration of the loop at the given nesting depth. shader
+     * must be in use.
+     */
+    void setLoopIndex(Shader& shader, int location, std::uint32_t depth);
+    /**
+     * @brief Time the GPU and CPU cost of the commands up to the matching endTimer() as the pass with the given ID.
+     */
+    void beginTimer(int id);
+    void endTimer(int id);
+
+    [[nodiscard]] inline const std::vector<Command>& getCommands() const {
+        return mCommands;
+    }
+    [[nodiscard]] inline const RenderState& getState(std::uint32_t index) const {
+        return mStates[index];
+    }
+    [[nodiscard]] inline Texture* const* getTextures(std::uint32_t first) const {
+        return mTextures.data() + first;
+    }
+    [[nodiscard]] inline const std::function<void()>& getCallback(std::uint32_t index) const {
+        return mCallbacks[index];
+    }
+    [[nodiscard]] inline std::size_t getMaxLoopDepth() const {
+        return mMaxLoopDepth;
+    }
+private:
+    inline Command& push(CommandType type) {
+        Command& command = mCommands.emplace_back();
+        command.type = type;
+        return command;
+    }
+
+    std::vector<Command> mCommands{};
+
+    std::vector<RenderState> mStates{};
+    std::vector<Texture*> mTextures{};
+    std::vector<std::function<void()>> mCallbacks{};
+
+    /**
+     * @brief Indices of the LoopBegin commands not yet closed by endLoop().
+     */
+    std::vector<std::uint32_t> mOpenLoops{};
+    std::size_t mMaxLoopDepth = 0;
+};
@@ -1,5 +1,6 @@
 #include "Framebuffer.h"
 
+#include "RenderConfig.h"
 #include "Texture.h"
 
 #include <glad/glad.h>
@@ -36,19 +37,21 @@ Framebuffer::Framebuffer() {
 }
 
 Framebuffer::~Framebuffer() {
+    RenderConfig::releaseFramebuffer(mFBO);
     glDeleteFramebuffers(1, &mFBO);
 }
 
 void Framebuffer::bind() const {
-    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    RenderConfig::bindFramebuffer(mFBO);
 }
 
 void Framebuffer::unbind() {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    RenderConfig::bindFramebuffer(0);
 }
 
 void Framebuffer::reset() {
     mNumColourBuffers = 0;
+    mAttachments.clear();
 
     mErrorState = ErrorState::Invalid;
     glDrawBuffer(GL_NONE);
@@ -62,7 +65,7 @@ void Framebuffer::drawBuffers() {
     mErrorState = parseErrorState(glCheckFramebufferStatus(GL_FRAMEBUFFER));
 }
 
-void Framebuffer::bindTexture(const Texture& texture) {
+void Framebuffer::bindTexture(Texture& texture) {
     GLenum attachmentType;
     switch (texture.getInternalFormat()) {
         default: attachmentType = GL_COLOR_ATTACHMENT0 + mNumColourBuffers++; break;
@@ -70,9 +73,10 @@ void Framebuffer::bindTexture(const Texture& texture) {
         case Texture::InternalFormat::DepthStencil   : attachmentType = GL_DEPTH_STENCIL_ATTACHMENT; break;
     }
     glFramebufferTexture2D(GL_FRAMEBUFFER, attachmentType, GL_TEXTURE_2D, texture.getID(), 0);
+    mAttachments.emplace_back(&texture, attachmentType);
 }
 
-void Framebuffer::bindTexture(const Texture& texture, unsigned int attachment) {
+void Framebuffer::bindTexture(Texture& texture, unsigned int attachment) {
     mNumColourBuffers = std::max(mNumColourBuffers, attachment + 1);
     GLenum attachmentType;
     switch (texture.getInternalFormat()) {
@@ -81,4 +85,12 @@ void Framebuffer::bindTexture(const Texture& texture, unsigned int attachment) {
         case Texture::InternalFormat::DepthStencil   : attachmentType = GL_DEPTH_STENCIL_ATTACHMENT; break;
     }
     glFramebufferTexture2D(GL_FRAMEBUFFER, attachmentType, GL_TEXTURE_2D, texture.getID(), 0);
+    mAttachments.emplace_back(&texture, attachmentType);
+}
+
+void Framebuffer::updateAttachments() {
+    bind();
+    for (const auto& [texture, attachmentType] : mAttachments)
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachmentType, GL_TEXTURE_2D, texture->getID(), 0);
+    unbind();
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <functional>
+#include <utility>
 #include <vector>
 
 class Texture;
@@ -27,8 +28,20 @@ public:
     void reset();
 
     void drawBuffers();
-    void bindTexture(const Texture& texture);
-    void bindTexture(const Texture& texture, unsigned int attachment);
+    void bindTexture(Texture& texture);
+    void bindTexture(Texture& texture, unsigned int attachment);
+    /**
+     * @brief Attach every texture again, picking up any change to the storage they use (see Texture::setAlias()).
+     * Leaves the default framebuffer bound.
+     */
+    void updateAttachments();
+
+    /**
+     * @returns Each attached texture, with its GL attachment point.
+     */
+    [[nodiscard]] inline const std::vector<std::pair<Texture*, unsigned int>>& getAttachments() const {
+        return mAttachments;
+    }
 
     [[nodiscard]] inline ErrorState getState() const {
         return mErrorState;
@@ -37,6 +50,7 @@ private:
     unsigned int mFBO = 0;
 
     unsigned int mNumColourBuffers = 0;
+    std::vector<std::pair<Texture*, unsigned int>> mAttachments{};
 
     ErrorState mErrorState = ErrorState::Invalid;
 };
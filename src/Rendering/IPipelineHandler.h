@@ -1,4 +1,6 @@
 #pragma once
+#include "CommandBuffer.h"
+
 #include <functional>
 
 class IPipelineEntry {
@@ -7,6 +9,13 @@ public:
 
     virtual void setEntry() = 0;
     virtual void unsetEntry() = 0;
+
+    /**
+     * @returns true if the entry is waiting on resources (e.g. shaders still compiling) before it can be set.
+     */
+    [[nodiscard]] virtual bool isPending() const {
+        return false;
+    }
 protected:
     IPipelineEntry() = default;
 };
@@ -20,6 +29,10 @@ public:
     virtual void clearPipeline(bool resetEntryPoint) = 0;
     virtual void resetPipeline() = 0;
     virtual void appendPipeline(pipeline_callback callback) = 0;
+    /**
+     * @returns Commands making up the current pipeline, which may be appended to.
+     */
+    [[nodiscard]] virtual CommandBuffer& getCommandBuffer() = 0;
 
     virtual void loadAnalysisPipeline(unsigned int bulk, std::size_t iterations) = 0;
 
@@ -1,13 +1,21 @@
 #include "Mesh.h"
 
+#include "RenderConfig.h"
+
 #include <glad/glad.h>
 
+#include <glm/gtc/packing.hpp>
+
+#include <cstring>
+#include <limits>
+
 Mesh::Mesh() {
     glGenVertexArrays(1, &mArrayObject);
     hardClean();
 }
 
 Mesh::~Mesh() {
+    RenderConfig::releaseVertexArray(mArrayObject);
     glDeleteVertexArrays(1, &mArrayObject);
     softClean();
 }
@@ -17,6 +25,10 @@ void Mesh::softClean() {
         glDeleteBuffers(1, &attrib.vbo);
         attrib.vbo = 0;
     }
+    glDeleteBuffers(1, &mInterleavedVBO);
+    mInterleavedVBO = 0;
+    glDeleteBuffers(1, &mIndexVBO);
+    mIndexVBO = 0;
     mErrorState = ErrorState::INVALID;
 }
 
@@ -26,46 +38,87 @@ void Mesh::hardClean() {
     mType = GL_TRIANGLES;
     mNumVertices = 0;
 
-    mIndexVBO = 0;
+    mIndexType = GL_UNSIGNED_INT;
+
+    mLayout = Layout::Separate;
 
     mIndices.clear();
+    mIndexData = nullptr;
+    mNumIndices = 0;
     mAttributes.clear();
+
+    mIsScreenQuad = false;
+    mScreenQuadUVBinding = -1;
 }
 
 void Mesh::draw() const {
-    if (mIndices.empty())
+    if (mNumIndices == 0)
         glDrawArrays(mType, 0, mNumVertices);
     else
-        glDrawElements(mType, mIndices.size(), GL_UNSIGNED_INT, nullptr);
+        glDrawElements(mType, mNumIndices, mIndexType, nullptr);
 }
 
 void Mesh::draw(int instanceCount) const {
-    if (mIndices.empty())
+    if (mNumIndices == 0)
         glDrawArraysInstanced(mType, 0, mNumVertices, instanceCount);
     else
-        glDrawElementsInstanced(mType, mIndices.size(), GL_UNSIGNED_INT, nullptr, instanceCount);
+        glDrawElementsInstanced(mType, mNumIndices, mIndexType, nullptr, instanceCount);
 }
 
 void Mesh::bind() const {
-    glBindVertexArray(mArrayObject);
-    if (!mIndices.empty())
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexVBO);
+    RenderConfig::bindVertexArray(mArrayObject, mNumIndices > 0 ? mIndexVBO : 0);
 }
 
 void Mesh::unbind() {
-    glBindVertexArray(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    RenderConfig::bindVertexArray(0);
 }
 
-void Mesh::addAttribute(const void* data, GLint attribSize, size_t dataSize, unsigned int binding, const std::string& debugName) {
+void Mesh::addAttribute(const void* data, GLint attribSize, size_t dataSize, unsigned int binding, const std::string& debugName,
+                        StorageFormat format) {
     VertexAttribute& attribute = mAttributes.emplace_back();
     attribute.index = binding;
     attribute.data = data;
     attribute.attribSize = attribSize;
     attribute.dataSize = dataSize;
+    attribute.format = isStorageFormatValid(format, attribSize) ? format : StorageFormat::Float;
     attribute.debugName = debugName;
 }
 
+size_t Mesh::getVertexSize() const {
+    size_t size = 0;
+    for (const VertexAttribute& attrib : mAttributes)
+        size += getStorageSize(attrib.format, attrib.attribSize);
+    return size;
+}
+
+size_t Mesh::getIndexSize() const {
+    return getIndexSize(mNumVertices);
+}
+
+size_t Mesh::getIndexSize(size_t numVertices) {
+    return numVertices <= std::numeric_limits<GLushort>::max() ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+size_t Mesh::getStorageSize(StorageFormat format, int attribSize) {
+    switch (format) {
+        default:
+        case StorageFormat::Float   : return attribSize * sizeof(GLfloat);
+        case StorageFormat::Half    : return (attribSize * sizeof(GLhalf) + 3) / 4 * 4;
+        case StorageFormat::Snorm10 : return sizeof(GLuint);
+        case StorageFormat::Snorm8  : return (attribSize * sizeof(GLbyte) + 3) / 4 * 4;
+    }
+}
+
+bool Mesh::isStorageFormatValid(StorageFormat format, int attribSize) {
+    switch (format) {
+        default:
+        case StorageFormat::Float   :
+        case StorageFormat::Half    :
+        case StorageFormat::Snorm8  : return attribSize >= 1 && attribSize <= 4;
+        case StorageFormat::Snorm10 : return attribSize >= 3 && attribSize <= 4;
+    }
+}
+
 void Mesh::makeScreenQuad(Mesh& mesh) {
     mesh.hardClean();
 
@@ -81,15 +134,20 @@ void Mesh::makeScreenQuad(Mesh& mesh) {
     mesh.addAttribute(positions, 2, sizeof(glm::vec2), 0, "Position");
     mesh.bind();
     mesh.bufferData();
+    mesh.setScreenQuad(-1);
     unbind();
 }
 
 void Mesh::bufferData() {
     bind();
-    for (VertexAttribute& attrib : mAttributes)
-        uploadAttribute(attrib);
+    if (mLayout == Layout::Interleaved) {
+        uploadInterleaved();
+    } else {
+        for (VertexAttribute& attrib : mAttributes)
+            uploadAttribute(attrib);
+    }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    if (!mIndices.empty())
+    if (mNumIndices > 0)
         uploadIndices();
 
     mErrorState = ErrorState::VALID;
@@ -99,8 +157,89 @@ void Mesh::uploadAttribute(Mesh::VertexAttribute& attrib) const {
     glGenBuffers(1, &attrib.vbo);
     glBindBuffer(GL_ARRAY_BUFFER, attrib.vbo);
 
-    glBufferData(GL_ARRAY_BUFFER, mNumVertices * attrib.dataSize, attrib.data, GL_STATIC_DRAW);
-    glVertexAttribPointer(attrib.index, attrib.attribSize, GL_FLOAT, GL_FALSE, 0, nullptr);
+    if (attrib.format == StorageFormat::Float) {
+        glBufferData(GL_ARRAY_BUFFER, mNumVertices * attrib.dataSize, attrib.data, GL_STATIC_DRAW);
+        setAttributePointer(attrib, 0, 0);
+    } else {
+        size_t stride = getStorageSize(attrib.format, attrib.attribSize);
+        std::vector<char> encoded(mNumVertices * stride);
+        encodeAttribute(attrib, encoded.data(), stride);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)encoded.size(), encoded.data(), GL_STATIC_DRAW);
+        setAttributePointer(attrib, stride, 0);
+    }
+}
+
+void Mesh::uploadInterleaved() {
+    size_t stride = getVertexSize();
+    std::vector<char> interleaved(mNumVertices * stride);
+    size_t offset = 0;
+    for (const VertexAttribute& attrib : mAttributes) {
+        encodeAttribute(attrib, interleaved.data() + offset, stride);
+        offset += getStorageSize(attrib.format, attrib.attribSize);
+    }
+
+    glGenBuffers(1, &mInterleavedVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mInterleavedVBO);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)interleaved.size(), interleaved.data(), GL_STATIC_DRAW);
+    glObjectLabel(GL_BUFFER, mInterleavedVBO, -1, "Interleaved Vertices");
+
+    offset = 0;
+    for (const VertexAttribute& attrib : mAttributes) {
+        setAttributePointer(attrib, stride, offset);
+        offset += getStorageSize(attrib.format, attrib.attribSize);
+    }
+}
+
+void Mesh::encodeAttribute(const VertexAttribute& attrib, char* dest, size_t stride) const {
+    for (unsigned int i = 0; i < mNumVertices; i++, dest += stride) {
+        const char* source = (const char*)attrib.data + i * attrib.dataSize;
+        if (attrib.format == StorageFormat::Float) {
+            std::memcpy(dest, source, attrib.attribSize * sizeof(GLfloat));
+            continue;
+        }
+
+        glm::vec4 value(0.0f);
+        std::memcpy(&value[0], source, attrib.attribSize * sizeof(GLfloat));
+        switch (attrib.format) {
+            default:
+            case StorageFormat::Half: {
+                GLhalf encoded[4];
+                for (int j = 0; j < attrib.attribSize; j++)
+                    encoded[j] = glm::packHalf1x16(value[j]);
+                std::memcpy(dest, encoded, attrib.attribSize * sizeof(GLhalf));
+                break;
+            }
+            case StorageFormat::Snorm10: {
+                GLuint encoded = glm::packSnorm3x10_1x2(value);
+                std::memcpy(dest, &encoded, sizeof(encoded));
+                break;
+            }
+            case StorageFormat::Snorm8: {
+                for (int j = 0; j < attrib.attribSize; j++)
+                    dest[j] = (char)glm::packSnorm1x8(value[j]);
+                break;
+            }
+        }
+    }
+}
+
+void Mesh::setAttributePointer(const VertexAttribute& attrib, size_t stride, size_t offset) const {
+    const void* pointer = (const void*)offset;
+    switch (attrib.format) {
+        default:
+        case StorageFormat::Float:
+            glVertexAttribPointer(attrib.index, attrib.attribSize, GL_FLOAT, GL_FALSE, (GLsizei)stride, pointer);
+            break;
+        case StorageFormat::Half:
+            glVertexAttribPointer(attrib.index, attrib.attribSize, GL_HALF_FLOAT, GL_FALSE, (GLsizei)stride, pointer);
+            break;
+        case StorageFormat::Snorm10:
+            glVertexAttribPointer(attrib.index, 4, GL_INT_2_10_10_10_REV, GL_TRUE, (GLsizei)stride, pointer);
+            break;
+        case StorageFormat::Snorm8:
+            glVertexAttribPointer(attrib.index, attrib.attribSize, GL_BYTE, GL_TRUE, (GLsizei)stride, pointer);
+            break;
+    }
     glEnableVertexAttribArray(attrib.index);
 }
 
@@ -108,11 +247,16 @@ void Mesh::uploadIndices() {
     glGenBuffers(1, &mIndexVBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexVBO);
 
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(GLuint), mIndices.data(), GL_STATIC_DRAW);
+    if (getIndexSize() == sizeof(GLushort)) {
+        std::vector<GLushort> shortIndices(mIndexData, mIndexData + mNumIndices);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mNumIndices * sizeof(GLushort), shortIndices.data(), GL_STATIC_DRAW);
+        mIndexType = GL_UNSIGNED_SHORT;
+    } else {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mNumIndices * sizeof(GLuint), mIndexData, GL_STATIC_DRAW);
+        mIndexType = GL_UNSIGNED_INT;
+    }
 
     glObjectLabel(GL_BUFFER, mIndexVBO, -1, "Indices");
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void Mesh::setType(Mesh::Type type) {
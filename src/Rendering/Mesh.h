@@ -43,6 +43,28 @@ public:
         Max,
     };
 
+    /**
+     * @brief How vertex attributes are arranged in GPU memory.
+     */
+    enum class Layout {
+        Separate = 0,
+        Interleaved,
+
+        Max,
+    };
+
+    /**
+     * @brief GPU-side format of a (float) vertex attribute. Every format other than Float is converted on upload.
+     */
+    enum class StorageFormat {
+        Float = 0,
+        Half,
+        Snorm10,
+        Snorm8,
+
+        Max,
+    };
+
     Mesh();
     ~Mesh();
 
@@ -50,12 +72,23 @@ public:
     void hardClean();
 
     void setType(Type type);
+    inline void setLayout(Layout layout) {
+        mLayout = layout;
+    }
     inline void setNumVertices(unsigned int numVertices) {
         mNumVertices = numVertices;
     }
 
     inline void setIndices(const std::vector<unsigned int>& indices) {
         mIndices = indices;
+        setIndices(mIndices.data(), mIndices.size());
+    }
+    /**
+     * @param indices Index data to be uploaded. Caller is responsible for maintaining the lifecycle of the data.
+     */
+    inline void setIndices(const unsigned int* indices, size_t numIndices) {
+        mIndexData = indices;
+        mNumIndices = numIndices;
     }
 
     void draw() const;
@@ -72,12 +105,56 @@ public:
      * @param attribSize Number of elements in the data type (e.g. vec3 is 3).
      * @param dataSize Size of the data type (e.g. vec3 is sizeof(vec3)).
      * @param debugName Label for printing debug information about this attribute.
+     * @param format Format to store the attribute in on the GPU. Formats other than Float require float data.
      */
-    void addAttribute(const void* data, int attribSize, size_t dataSize, unsigned int binding, const std::string& debugName);
+    void addAttribute(const void* data, int attribSize, size_t dataSize, unsigned int binding, const std::string& debugName,
+                      StorageFormat format = StorageFormat::Float);
     void bufferData();
 
+    /**
+     * @returns Bytes per vertex of all attributes in their storage formats (including any padding).
+     */
+    [[nodiscard]] size_t getVertexSize() const;
+    /**
+     * @returns Bytes per index of the index buffer. 16-bit indices are used whenever the vertex count allows it.
+     */
+    [[nodiscard]] size_t getIndexSize() const;
+    /**
+     * @returns Bytes per index of the index buffer of a mesh with numVertices vertices.
+     */
+    [[nodiscard]] static size_t getIndexSize(size_t numVertices);
+
+    /**
+     * @returns Bytes taken by a single element of attribSize components stored in the given format, padded to 4 bytes.
+     */
+    [[nodiscard]] static size_t getStorageSize(StorageFormat format, int attribSize);
+    /**
+     * @returns true if format can store an attribute of attribSize components, otherwise false.
+     */
+    [[nodiscard]] static bool isStorageFormatValid(StorageFormat format, int attribSize);
+
+    /**
+     * @brief Build a quad covering the whole viewport (see setScreenQuad()), without texture coordinates.
+     */
     static void makeScreenQuad(Mesh& mesh);
 
+    /**
+     * @brief Mark this mesh as a quad covering the whole viewport, drawn as a four vertex strip with its position at
+     * binding 0. Passes drawing it may be fused (see ShaderFusion). Reset by hardClean().
+     * @param uvBinding Binding of the attribute holding each vertex's position remapped to [0, 1], or -1 if there is
+     * none.
+     */
+    inline void setScreenQuad(int uvBinding) {
+        mIsScreenQuad = true;
+        mScreenQuadUVBinding = uvBinding;
+    }
+    [[nodiscard]] inline bool isScreenQuad() const {
+        return mIsScreenQuad;
+    }
+    [[nodiscard]] inline int getScreenQuadUVBinding() const {
+        return mScreenQuadUVBinding;
+    }
+
     [[nodiscard]] inline ErrorState getState() const {
         return mErrorState;
     }
@@ -93,10 +170,17 @@ private:
         const void* data{};
         int attribSize{};
         size_t dataSize{};
+        StorageFormat format = StorageFormat::Float;
         std::string debugName;
     };
 
     void uploadAttribute(VertexAttribute& attrib) const;
+    void uploadInterleaved();
+    /**
+     * @brief Convert numVertices elements of attrib into its storage format, writing each stride bytes apart.
+     */
+    void encodeAttribute(const VertexAttribute& attrib, char* dest, size_t stride) const;
+    void setAttributePointer(const VertexAttribute& attrib, size_t stride, size_t offset) const;
 
     void uploadIndices();
 
@@ -106,10 +190,19 @@ private:
     unsigned int mNumVertices = 0;
 
     unsigned int mIndexVBO = 0;
+    unsigned int mIndexType = 0;
+
+    Layout mLayout = Layout::Separate;
+    unsigned int mInterleavedVBO = 0;
 
     std::vector<unsigned int> mIndices;
+    const unsigned int* mIndexData = nullptr;
+    size_t mNumIndices = 0;
     std::vector<VertexAttribute> mAttributes{};
 
+    bool mIsScreenQuad = false;
+    int mScreenQuadUVBinding = -1;
+
     ErrorState mErrorState = ErrorState::INVALID;
     std::string mMessage;
 };
@@ -0,0 +1,159 @@
+#include "PassProfiler.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <numeric>
+
+std::unordered_map<int, PassProfiler::Pass> PassProfiler::sPasses{};
+std::vector<int> PassProfiler::sPassOrder{};
+
+std::array<PassProfiler::FrameQueries, PassProfiler::cFRAME_LATENCY> PassProfiler::sFrames{};
+std::size_t PassProfiler::sFrameIndex = 0;
+bool PassProfiler::sInFrame = false;
+
+std::chrono::steady_clock::time_point PassProfiler::sFrameStart{};
+std::chrono::steady_clock::time_point PassProfiler::sPassStart{};
+
+PassProfiler::Timeline PassProfiler::sTimeline{};
+std::size_t PassProfiler::sDroppedFrames = 0;
+
+typedef std::chrono::duration<float, std::milli> milliseconds_t;
+
+void PassProfiler::History::push(float sample) {
+    if (samples.size() < cHISTORY_SIZE) {
+        samples.push_back(sample);
+    } else {
+        samples[next] = sample;
+        next = (next + 1) % cHISTORY_SIZE;
+    }
+}
+
+PassProfiler::Stats PassProfiler::History::getStats() const {
+    if (samples.empty())
+        return {};
+
+    std::vector<float> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    Stats stats;
+    stats.min = sorted.front();
+    stats.avg = std::accumulate(sorted.begin(), sorted.end(), 0.0f) / (float)sorted.size();
+    stats.p95 = sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+    return stats;
+}
+
+void PassProfiler::registerPass(int id, const std::string& label) {
+    if (sPasses.find(id) == sPasses.end())
+        sPassOrder.push_back(id);
+    Pass& pass = sPasses[id];
+    pass = Pass();
+    pass.timing.label = label;
+}
+
+void PassProfiler::clearPasses() {
+    sPasses.clear();
+    sPassOrder.clear();
+    sTimeline = Timeline();
+}
+
+void PassProfiler::beginFrame() {
+    sFrameIndex = (sFrameIndex + 1) % cFRAME_LATENCY;
+    FrameQueries& frame = sFrames[sFrameIndex];
+    if (frame.numUsed > 0)
+        readBack(frame);
+    frame.numUsed = 0;
+    frame.passIDs.clear();
+
+    glQueryCounter(nextQuery(frame), GL_TIMESTAMP);
+
+    sTimeline.cpu.clear();
+    sFrameStart = std::chrono::steady_clock::now();
+    sInFrame = true;
+}
+
+void PassProfiler::endFrame() {
+    sInFrame = false;
+    sTimeline.cpuTotal = milliseconds_t(std::chrono::steady_clock::now() - sFrameStart).count();
+
+    std::unordered_map<int, float> frameTimes{};
+    for (const Interval& interval : sTimeline.cpu)
+        frameTimes[interval.id] += interval.end - interval.begin;
+    for (const auto& [id, time] : frameTimes) {
+        auto pass = sPasses.find(id);
+        if (pass == sPasses.end())
+            continue;
+        pass->second.timing.lastCPU = time;
+        pass->second.cpuHistory.push(time);
+        pass->second.timing.cpu = pass->second.cpuHistory.getStats();
+    }
+}
+
+void PassProfiler::beginPass(int id) {
+    if (!sInFrame)
+        return;
+    FrameQueries& frame = sFrames[sFrameIndex];
+    glQueryCounter(nextQuery(frame), GL_TIMESTAMP);
+    frame.passIDs.push_back(id);
+
+    sPassStart = std::chrono::steady_clock::now();
+}
+
+void PassProfiler::endPass(int id) {
+    if (!sInFrame)
+        return;
+    const auto passEnd = std::chrono::steady_clock::now();
+    sTimeline.cpu.push_back({
+        id, milliseconds_t(sPassStart - sFrameStart).count(), milliseconds_t(passEnd - sFrameStart).count()
+    });
+
+    glQueryCounter(nextQuery(sFrames[sFrameIndex]), GL_TIMESTAMP);
+}
+
+const PassProfiler::PassTiming* PassProfiler::getPassTiming(int id) {
+    auto pass = sPasses.find(id);
+    return pass == sPasses.end() ? nullptr : &pass->second.timing;
+}
+
+unsigned int PassProfiler::nextQuery(FrameQueries& frame) {
+    if (frame.numUsed == frame.queries.size())
+        glGenQueries(1, &frame.queries.emplace_back());
+    return frame.queries[frame.numUsed++];
+}
+
+void PassProfiler::readBack(FrameQueries& frame) {
+    // Timestamps complete in order, so if the last is available then so are the rest
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(frame.queries[frame.numUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available != GL_TRUE) {
+        sDroppedFrames++;
+        return;
+    }
+
+    std::vector<GLuint64> timestamps(frame.numUsed);
+    for (std::size_t i = 0; i < frame.numUsed; i++)
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+
+    const auto toMilliseconds = [&timestamps](GLuint64 timestamp) {
+        return (float)(timestamp - timestamps[0]) / 1000000.0f;
+    };
+
+    sTimeline.gpu.clear();
+    std::unordered_map<int, float> frameTimes{};
+    for (std::size_t i = 0; i < frame.passIDs.size(); i++) {
+        const Interval& interval = sTimeline.gpu.emplace_back(Interval{
+            frame.passIDs[i], toMilliseconds(timestamps[1 + 2 * i]), toMilliseconds(timestamps[2 + 2 * i])
+        });
+        frameTimes[interval.id] += interval.end - interval.begin;
+    }
+    sTimeline.gpuTotal = sTimeline.gpu.empty() ? 0.0f : sTimeline.gpu.back().end;
+
+    for (const auto& [id, time] : frameTimes) {
+        auto pass = sPasses.find(id);
+        if (pass == sPasses.end())
+            continue;
+        pass->second.timing.lastGPU = time;
+        pass->second.gpuHistory.push(time);
+        pass->second.timing.gpu = pass->second.gpuHistory.getStats();
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Measures the GPU and CPU time taken by each pass of the pipeline, identified by an arbitrary integer ID.
+ * @brief GPU times come from GL_TIMESTAMP queries, which are read back cFRAME_LATENCY frames later so the CPU never
+ * waits on the GPU. If a frame's results are still unavailable by then, that frame is dropped.
+ */
+class PassProfiler {
+public:
+    struct Stats {
+        float min = 0.0f;
+        float avg = 0.0f;
+        float p95 = 0.0f;
+    };
+
+    struct PassTiming {
+        std::string label;
+        /**
+         * @brief Total time taken by every execution of the pass in the last measured frame, in milliseconds.
+         */
+        float lastGPU = 0.0f;
+        float lastCPU = 0.0f;
+        Stats gpu;
+        Stats cpu;
+    };
+
+    /**
+     * @brief Time span of a single execution of a pass, in milliseconds since the start of the frame.
+     */
+    struct Interval {
+        int id;
+        float begin;
+        float end;
+    };
+
+    struct Timeline {
+        std::vector<Interval> gpu;
+        std::vector<Interval> cpu;
+        float gpuTotal = 0.0f;
+        float cpuTotal = 0.0f;
+    };
+
+    /**
+     * @brief Start collecting timings for a pass, discarding any existing timings with the same id.
+     */
+    static void registerPass(int id, const std::string& label);
+    static void clearPasses();
+
+    static void beginFrame();
+    static void endFrame();
+
+    /**
+     * @brief Mark the start of an execution of the pass. Has no effect outside of beginFrame()/endFrame().
+     */
+    static void beginPass(int id);
+    static void endPass(int id);
+
+    /**
+     * @returns Timings of the pass, or nullptr if it has not been registered.
+     */
+    [[nodiscard]] static const PassTiming* getPassTiming(int id);
+    /**
+     * @returns IDs of every registered pass, in order of registration.
+     */
+    [[nodiscard]] static inline const std::vector<int>& getPasses() {
+        return sPassOrder;
+    }
+    /**
+     * @returns Intervals of the last frame with GPU results, and the CPU intervals of the last frame.
+     */
+    [[nodiscard]] static inline const Timeline& getTimeline() {
+        return sTimeline;
+    }
+    [[nodiscard]] static inline std::size_t getDroppedFrames() {
+        return sDroppedFrames;
+    }
+private:
+    static constexpr std::size_t cFRAME_LATENCY = 3;
+    static constexpr std::size_t cHISTORY_SIZE = 120;
+
+    struct History {
+        std::vector<float> samples;
+        std::size_t next = 0;
+
+        void push(float sample);
+        [[nodiscard]] Stats getStats() const;
+    };
+
+    struct Pass {
+        PassTiming timing;
+        History gpuHistory;
+        History cpuHistory;
+    };
+
+    /**
+     * @brief Queries issued during a frame. The first is the start of the frame, followed by a begin/end pair for each
+     * execution of a pass.
+     */
+    struct FrameQueries {
+        std::vector<unsigned int> queries;
+        std::size_t numUsed = 0;
+        std::vector<int> passIDs;
+    };
+
+    [[nodiscard]] static unsigned int nextQuery(FrameQueries& frame);
+    /**
+     * @brief Read the results of frame if they are available, adding them to each pass's history.
+     */
+    static void readBack(FrameQueries& frame);
+
+    static std::unordered_map<int, Pass> sPasses;
+    static std::vector<int> sPassOrder;
+
+    static std::array<FrameQueries, cFRAME_LATENCY> sFrames;
+    static std::size_t sFrameIndex;
+    static bool sInFrame;
+
+    static std::chrono::steady_clock::time_point sFrameStart;
+    static std::chrono::steady_clock::time_point sPassStart;
+
+    static Timeline sTimeline;
+    static std::size_t sDroppedFrames;
+};
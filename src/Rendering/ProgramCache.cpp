@@ -0,0 +1,140 @@
+#include "ProgramCache.h"
+
+#include "../Utils/FileUtils.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace entry {
+    constexpr char cMAGIC[4] = {'G', 'S', 'P', 'C'};
+    constexpr uint32_t cVERSION = 1;
+
+    /**
+     * @brief Followed by keySize bytes of key, then binarySize bytes of program binary.
+     */
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t binaryFormat;
+        uint32_t keySize;
+        uint64_t binarySize;
+        float compileTime;
+        uint32_t padding;
+    };
+}
+
+std::filesystem::path ProgramCache::sDirectory{};
+ProgramCache::Stats ProgramCache::sStats{};
+
+void ProgramCache::setDirectory(const std::filesystem::path& directory) {
+    sDirectory = directory;
+}
+
+std::string ProgramCache::makeKey(const std::string& key) {
+    const auto getString = [](GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string((const char*)value) : std::string();
+    };
+    return std::string(key).append("\n").append(getString(GL_VENDOR))
+                           .append("\n").append(getString(GL_RENDERER))
+                           .append("\n").append(getString(GL_VERSION));
+}
+
+bool ProgramCache::load(const std::string& key, unsigned int program) {
+    if (!isEnabled())
+        return false;
+
+    bool loaded = false;
+    bool rejected = false;
+    ProfileUtils::milliseconds_t compileTime{0};
+    ProfileUtils::milliseconds_t loadTime = ProfileUtils::time([&]() {
+        MappedFile file(getEntryPath(key));
+        if (!file.isOpen() || file.size() < sizeof(entry::Header))
+            return;
+
+        entry::Header header{};
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, entry::cMAGIC, sizeof(header.magic)) != 0 || header.version != entry::cVERSION ||
+            header.keySize != key.size() || header.binarySize > file.size() - sizeof(header) - header.keySize ||
+            std::string_view(file.data() + sizeof(header), header.keySize) != key)
+            return;
+
+        glProgramBinary(program, header.binaryFormat, file.data() + sizeof(header) + header.keySize,
+                        (GLsizei)header.binarySize);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        loaded = success == GL_TRUE;
+        rejected = !loaded;
+        compileTime = ProfileUtils::milliseconds_t(header.compileTime);
+    });
+
+    if (loaded) {
+        sStats.hits++;
+        sStats.timeSaved += compileTime - loadTime;
+    } else {
+        sStats.misses++;
+        sStats.rejected += rejected ? 1 : 0;
+    }
+    reportStats();
+    return loaded;
+}
+
+void ProgramCache::store(const std::string& key, unsigned int program, ProfileUtils::milliseconds_t compileTime) {
+    if (!isEnabled())
+        return;
+
+    GLint binarySize = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0)
+        return;
+
+    std::vector<char> binary(binarySize);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, binarySize, &binarySize, &binaryFormat, binary.data());
+
+    entry::Header header{};
+    std::memcpy(header.magic, entry::cMAGIC, sizeof(header.magic));
+    header.version = entry::cVERSION;
+    header.binaryFormat = binaryFormat;
+    header.keySize = (uint32_t)key.size();
+    header.binarySize = (uint64_t)binarySize;
+    header.compileTime = compileTime.count();
+
+    std::error_code error;
+    std::filesystem::create_directories(sDirectory, error);
+    FileUtils::writeFileAtomic(getEntryPath(key), true, [&](std::ostream& stream) {
+        stream.write((const char*)&header, sizeof(header));
+        stream.write(key.data(), (std::streamsize)key.size());
+        stream.write(binary.data(), binarySize);
+    });
+}
+
+bool ProgramCache::isEnabled() {
+    if (sDirectory.empty())
+        return false;
+    static const bool cIS_SUPPORTED = []() {
+        GLint numFormats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        return numFormats > 0;
+    }();
+    return cIS_SUPPORTED;
+}
+
+std::filesystem::path ProgramCache::getEntryPath(const std::string& key) {
+    char filename[32];
+    std::snprintf(filename, sizeof(filename), "%016llx.program", (unsigned long long)std::hash<std::string>{}(key));
+    return sDirectory / filename;
+}
+
+void ProgramCache::reportStats() {
+    ProfileUtils::setResult("Program Cache", std::to_string(sStats.hits).append(" hits | ")
+                                .append(std::to_string(sStats.misses)).append(" misses (")
+                                .append(std::to_string(sStats.rejected)).append(" rejected) | saved ")
+                                .append(ProfileUtils::formatTime(sStats.timeSaved)));
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "../Utils/ProfileUtils.h"
+
+#include <filesystem>
+#include <string>
+
+/**
+ * @brief On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary), keyed by the program's stage
+ * types and sources along with the driver vendor, renderer and version.
+ */
+class ProgramCache {
+public:
+    struct Stats {
+        unsigned int hits = 0;
+        unsigned int misses = 0;
+        /**
+         * @brief Cache entries found but rejected by the driver (counted as misses too).
+         */
+        unsigned int rejected = 0;
+        /**
+         * @brief Time the original compiles of all hit programs took, less the time taken to load their binaries.
+         */
+        ProfileUtils::milliseconds_t timeSaved{0};
+    };
+
+    /**
+     * @brief Set the directory cache entries are read from and written to. Caching is disabled while empty.
+     */
+    static void setDirectory(const std::filesystem::path& directory);
+
+    /**
+     * @brief Append the current driver identification to key. Requires a current GL context.
+     */
+    [[nodiscard]] static std::string makeKey(const std::string& key);
+
+    /**
+     * @brief Attempt to load the cached binary matching key into program.
+     * @returns true if program was loaded and successfully linked, otherwise false (program must be linked from
+     * source instead).
+     */
+    static bool load(const std::string& key, unsigned int program);
+    /**
+     * @brief Store the binary of the (linked) program under key.
+     * @param compileTime Time taken to compile and link program from source.
+     */
+    static void store(const std::string& key, unsigned int program, ProfileUtils::milliseconds_t compileTime);
+
+    /**
+     * @returns true if a cache directory is set and the driver supports at least one program binary format.
+     */
+    [[nodiscard]] static bool isEnabled();
+
+    [[nodiscard]] static inline const Stats& getStats() {
+        return sStats;
+    }
+private:
+    [[nodiscard]] static std::filesystem::path getEntryPath(const std::string& key);
+
+    static void reportStats();
+
+    static std::filesystem::path sDirectory;
+    static Stats sStats;
+};
@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include <algorithm>
+
 int          RenderConfig::sVPortDefaultX = 0;
 int          RenderConfig::sVPortDefaultY = 0;
 unsigned int RenderConfig::sVPortDefaultW = 1024;
@@ -9,6 +11,9 @@ unsigned int RenderConfig::sVPortDefaultH = 1024;
 
 std::vector<IResizeCallable*> RenderConfig::sResizeEvents{};
 
+RenderConfig::ShadowState RenderConfig::sState{};
+RenderConfig::StateStats  RenderConfig::sStateStats{};
+
 GLenum parseBlendFuncSrc(RenderConfig::BlendFuncSrc srcFactor) {
     switch (srcFactor) {
         default:
@@ -89,11 +94,13 @@ void RenderConfig::setDefaultViewport(int x, int y, unsigned int width, unsigned
 }
 
 void RenderConfig::setViewport(int x, int y, unsigned int width, unsigned int height) {
-    glViewport(x, y, width, height);
+    if (updateState(sState.viewport, glm::ivec4(x, y, width, height)))
+        glViewport(x, y, (GLsizei)width, (GLsizei)height);
 }
 
 void RenderConfig::setClearColour(float r, float g, float b, float a) {
-    glClearColor(r, g, b, a);
+    if (updateState(sState.clearColour, glm::vec4(r, g, b, a)))
+        glClearColor(r, g, b, a);
 }
 
 void RenderConfig::clearBuffers(RenderConfig::ClearBit mask) {
@@ -109,45 +116,130 @@ void RenderConfig::clearBuffers(RenderConfig::ClearBit mask) {
 
 void RenderConfig::setBlend(bool enabled, RenderConfig::BlendFuncSrc srcFactor, RenderConfig::BlendFuncDst dstFactor) {
     if (!enabled) {
-        glDisable(GL_BLEND);
+        if (updateState(sState.blend, false))
+            glDisable(GL_BLEND);
         return;
     }
 
-    glEnable(GL_BLEND);
-    glBlendFunc(parseBlendFuncSrc(srcFactor), parseBlendFuncDst(dstFactor));
+    if (updateState(sState.blend, true))
+        glEnable(GL_BLEND);
+    const glm::uvec2 blendFunc(parseBlendFuncSrc(srcFactor), parseBlendFuncDst(dstFactor));
+    if (updateState(sState.blendFunc, blendFunc))
+        glBlendFunc(blendFunc.x, blendFunc.y);
 }
 
 void RenderConfig::setColourMask(bool red, bool green, bool blue, bool alpha) {
-    glColorMask(red, green, blue, alpha);
+    if (updateState(sState.colourMask, glm::bvec4(red, green, blue, alpha)))
+        glColorMask(red, green, blue, alpha);
 }
 
 void RenderConfig::setCullFace(bool enabled, RenderConfig::CullFaceMode mode) {
     if (!enabled) {
-        glDisable(GL_CULL_FACE);
+        if (updateState(sState.cullFace, false))
+            glDisable(GL_CULL_FACE);
         return;
     }
 
-    glEnable(GL_CULL_FACE);
-    glCullFace(parseCullFaceMode(mode));
+    if (updateState(sState.cullFace, true))
+        glEnable(GL_CULL_FACE);
+    if (updateState(sState.cullFaceMode, (unsigned int)parseCullFaceMode(mode)))
+        glCullFace(parseCullFaceMode(mode));
 }
 
 void RenderConfig::setDepthTest(bool enabled, RenderConfig::DepthTestFunc func, float nearVal, float farVal) {
     if (!enabled) {
-        glDisable(GL_DEPTH_TEST);
+        if (updateState(sState.depthTest, false))
+            glDisable(GL_DEPTH_TEST);
         return;
     }
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(parseDepthTestFunc(func));
-    glDepthRange(nearVal, farVal);
+    if (updateState(sState.depthTest, true))
+        glEnable(GL_DEPTH_TEST);
+    if (updateState(sState.depthFunc, (unsigned int)parseDepthTestFunc(func)))
+        glDepthFunc(parseDepthTestFunc(func));
+    if (updateState(sState.depthRange, glm::vec2(nearVal, farVal)))
+        glDepthRange(nearVal, farVal);
 }
 
 void RenderConfig::setDepthMask(bool enabled) {
-    glDepthMask(enabled);
+    if (updateState(sState.depthMask, enabled))
+        glDepthMask(enabled);
 }
 
 void RenderConfig::setPatchVertices(int numVertices) {
-    glPatchParameteri(GL_PATCH_VERTICES, numVertices);
+    if (updateState(sState.patchVertices, numVertices))
+        glPatchParameteri(GL_PATCH_VERTICES, numVertices);
+}
+
+void RenderConfig::bindProgram(unsigned int program) {
+    if (updateState(sState.program, program))
+        glUseProgram(program);
+}
+
+void RenderConfig::bindVertexArray(unsigned int vertexArray, unsigned int indexBuffer) {
+    // The element array buffer binding is part of the vertex array's state, so only needs binding with it
+    if (!updateState(sState.vertexArray, vertexArray))
+        return;
+    glBindVertexArray(vertexArray);
+    if (indexBuffer != 0)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+}
+
+void RenderConfig::bindFramebuffer(unsigned int framebuffer) {
+    if (updateState(sState.framebuffer, framebuffer))
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void RenderConfig::bindTexture(int unit, unsigned int texture) {
+    if (unit < 0 || unit >= (int)ShadowState::cMAX_TEXTURE_UNITS) {
+        sState.activeTexture = unit;
+        sStateStats.issued += 2;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        return;
+    }
+
+    if (sState.textures[unit] == texture) {
+        sStateStats.elided++;
+        return;
+    }
+    if (updateState(sState.activeTexture, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    updateState(sState.textures[unit], texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void RenderConfig::bindTexture(unsigned int texture) {
+    bindTexture(sState.activeTexture.value_or(0), texture);
+}
+
+void RenderConfig::releaseProgram(unsigned int program) {
+    if (sState.program == program)
+        sState.program.reset();
+}
+
+void RenderConfig::releaseVertexArray(unsigned int vertexArray) {
+    if (sState.vertexArray == vertexArray)
+        sState.vertexArray.reset();
+}
+
+void RenderConfig::releaseFramebuffer(unsigned int framebuffer) {
+    if (sState.framebuffer == framebuffer)
+        sState.framebuffer.reset();
+}
+
+void RenderConfig::releaseTexture(unsigned int texture) {
+    for (std::optional<unsigned int>& binding : sState.textures)
+        if (binding == texture)
+            binding.reset();
+}
+
+void RenderConfig::invalidateState() {
+    sState = ShadowState();
+}
+
+void RenderConfig::resetStateStats() {
+    sStateStats = StateStats();
 }
 
 bool operator&(RenderConfig::ClearBit a, RenderConfig::ClearBit b) {
@@ -1,7 +1,9 @@
 #pragma once
 #include <glm/glm.hpp>
 
+#include <array>
 #include <cstddef>
+#include <optional>
 #include <vector>
 
 class IResizeCallable {
@@ -76,6 +78,15 @@ public:
         Max,
     };
 
+    /**
+     * @brief Number of state changes requested through RenderConfig (and the bind functions of Shader, Mesh,
+     * Framebuffer and Texture), split by whether they reached GL or were skipped as redundant.
+     */
+    struct StateStats {
+        unsigned int issued = 0;
+        unsigned int elided = 0;
+    };
+
     static void addResizeCallable(IResizeCallable& callable);
     static void removeResizeCallable(IResizeCallable& callable);
 
@@ -97,7 +108,89 @@ public:
     static void setDepthTest(bool enabled = false, DepthTestFunc func = DepthTestFunc::Less, float nearVal = 0.0f, float farVal = 1.0f);
     static void setDepthMask(bool enabled = false);
     static void setPatchVertices(int numVertices = 3);
+
+    static void bindProgram(unsigned int program);
+    /**
+     * @brief Bind vertexArray, along with indexBuffer (if non-zero) as its element array buffer.
+     */
+    static void bindVertexArray(unsigned int vertexArray, unsigned int indexBuffer = 0);
+    static void bindFramebuffer(unsigned int framebuffer);
+    /**
+     * @brief Bind texture to the GL_TEXTURE_2D target of the given texture unit.
+     */
+    static void bindTexture(int unit, unsigned int texture);
+    /**
+     * @brief Bind texture to the GL_TEXTURE_2D target of the active texture unit.
+     */
+    static void bindTexture(unsigned int texture);
+
+    /**
+     * @brief Forget any cached bindings of an object about to be deleted, as its name may be reused.
+     */
+    static void releaseProgram(unsigned int program);
+    static void releaseVertexArray(unsigned int vertexArray);
+    static void releaseFramebuffer(unsigned int framebuffer);
+    static void releaseTexture(unsigned int texture);
+
+    /**
+     * @brief Forget all cached state, so the next change to each is issued regardless. Must be called after GL state
+     * is changed other than through RenderConfig (e.g. by ImGui, or after a context change).
+     */
+    static void invalidateState();
+
+    static void resetStateStats();
+    [[nodiscard]] static inline const StateStats& getStateStats() {
+        return sStateStats;
+    }
 private:
+    /**
+     * @brief Last value set for each piece of GL state, or std::nullopt if unknown.
+     */
+    struct ShadowState {
+        static constexpr std::size_t cMAX_TEXTURE_UNITS = 32;
+
+        std::optional<glm::ivec4> viewport;
+        std::optional<glm::vec4> clearColour;
+
+        std::optional<bool> blend;
+        std::optional<glm::uvec2> blendFunc;
+        std::optional<glm::bvec4> colourMask;
+
+        std::optional<bool> cullFace;
+        std::optional<unsigned int> cullFaceMode;
+
+        std::optional<bool> depthTest;
+        std::optional<unsigned int> depthFunc;
+        std::optional<glm::vec2> depthRange;
+        std::optional<bool> depthMask;
+
+        std::optional<int> patchVertices;
+
+        std::optional<unsigned int> program;
+        std::optional<unsigned int> vertexArray;
+        std::optional<unsigned int> framebuffer;
+        std::optional<int> activeTexture;
+        std::array<std::optional<unsigned int>, cMAX_TEXTURE_UNITS> textures;
+    };
+
+    /**
+     * @brief Record value as the current state if it differs from cached.
+     * @returns true if value differs (and so must be issued to GL), otherwise false.
+     */
+    template<typename T>
+    static inline bool updateState(std::optional<T>& cached, const T& value) {
+        if (cached == value) {
+            sStateStats.elided++;
+            return false;
+        }
+        cached = value;
+        sStateStats.issued++;
+        return true;
+    }
+
+    static ShadowState sState;
+    static StateStats sStateStats;
+
     static int sVPortDefaultX, sVPortDefaultY;
     static unsigned int sVPortDefaultW, sVPortDefaultH;
 
@@ -1,8 +1,112 @@
 #include "Renderer.h"
 
+#include "Framebuffer.h"
+#include "Mesh.h"
+#include "PassProfiler.h"
+#include "Texture.h"
+#include "TransientTexturePool.h"
+
+#include "../Utils/VariantUtils.h"
+
 void Renderer::drawScene() {
-    for (const auto& pass : mRenderPipeline)
-        pass();
+    RenderConfig::resetStateStats();
+    PassProfiler::beginFrame();
+    // Transient textures resized since the pipeline was built have dropped their aliases
+    TransientTexturePool::update(mRenderPipeline);
+    executeCommands(mRenderPipeline);
+    PassProfiler::endFrame();
+    mFrameStateStats = RenderConfig::getStateStats();
+}
+
+void Renderer::executeCommands(const CommandBuffer& commands) {
+    const std::vector<CommandBuffer::Command>& commandList = commands.getCommands();
+
+    // Current iteration of each loop being executed, from outermost to innermost
+    std::vector<std::uint32_t> loopIterations;
+    loopIterations.reserve(commands.getMaxLoopDepth());
+
+    for (std::size_t i = 0; i < commandList.size(); i++) {
+        const CommandBuffer::Command& command = commandList[i];
+        switch (command.type) {
+            case CommandBuffer::CommandType::BindFramebuffer:
+                command.framebuffer->bind();
+                break;
+            case CommandBuffer::CommandType::UseProgram:
+                command.shader->bind();
+                break;
+            case CommandBuffer::CommandType::SetUniforms:
+                for (const auto& [location, value] : *command.uniforms.values) {
+                    std::visit(VisitOverload{
+                        [](Texture*) {},
+                        [&command, location](auto arg) { command.uniforms.shader->setUniform(location, arg); },
+                    }, value);
+                }
+                break;
+            case CommandBuffer::CommandType::SetState: {
+                const CommandBuffer::RenderState& state = commands.getState(command.state);
+                if (state.viewport == glm::vec4(0.0f))
+                    RenderConfig::setViewport();
+                else
+                    RenderConfig::setViewport((int)state.viewport.x, (int)state.viewport.y,
+                                              (unsigned int)state.viewport.z, (unsigned int)state.viewport.w);
+
+                RenderConfig::setBlend(state.enableBlend, state.blendFuncSrc, state.blendFuncDst);
+                RenderConfig::setColourMask(state.colourMask.r, state.colourMask.g, state.colourMask.b,
+                                            state.colourMask.a);
+                RenderConfig::setCullFace(state.enableFaceCulling, state.cullFaceMode);
+                RenderConfig::setDepthTest(state.enableDepthTest, state.depthTestFunc, state.depthTestLimits.x,
+                                           state.depthTestLimits.y);
+                RenderConfig::setDepthMask(state.enableDepthMask);
+
+                RenderConfig::setClearColour(state.clearColour.r, state.clearColour.g, state.clearColour.b,
+                                             state.clearColour.a);
+                if (state.doClear)
+                    RenderConfig::clearBuffers(RenderConfig::ClearBit::Colour | RenderConfig::ClearBit::Depth |
+                                               RenderConfig::ClearBit::Stencil);
+                break;
+            }
+            case CommandBuffer::CommandType::BindTextures: {
+                Texture* const* textures = commands.getTextures(command.textures.first);
+                for (std::uint32_t i = 0; i < command.textures.count; i++)
+                    textures[i]->bind((int)i);
+                break;
+            }
+            case CommandBuffer::CommandType::BindVAO:
+                command.mesh->bind();
+                break;
+            case CommandBuffer::CommandType::Draw:
+                command.mesh->draw();
+                break;
+            case CommandBuffer::CommandType::Unbind:
+                Framebuffer::unbind();
+                break;
+            case CommandBuffer::CommandType::Callback:
+                commands.getCallback(command.callback)();
+                break;
+            case CommandBuffer::CommandType::LoopBegin:
+                if (command.loop.count == 0)
+                    i = command.loop.jump;
+                else
+                    loopIterations.push_back(0);
+                break;
+            case CommandBuffer::CommandType::LoopEnd:
+                if (++loopIterations.back() < command.loop.count)
+                    i = command.loop.jump;
+                else
+                    loopIterations.pop_back();
+                break;
+            case CommandBuffer::CommandType::LoopIndex:
+                command.loopIndex.shader->setUniform(command.loopIndex.location,
+                                                     (int)loopIterations[command.loopIndex.depth]);
+                break;
+            case CommandBuffer::CommandType::BeginTimer:
+                PassProfiler::beginPass(command.timer);
+                break;
+            case CommandBuffer::CommandType::EndTimer:
+                PassProfiler::endPass(command.timer);
+                break;
+        }
+    }
 }
 
 void Renderer::clearPipeline(bool resetEntryPoint) {
@@ -11,10 +115,11 @@ void Renderer::clearPipeline(bool resetEntryPoint) {
         mEntryPoint = nullptr;
     }
     mRenderPipeline.clear();
+    PassProfiler::clearPasses();
 }
 
 void Renderer::appendPipeline(IPipelineHandler::pipeline_callback callback) {
-    mRenderPipeline.push_back(callback);
+    mRenderPipeline.callback(std::move(callback));
 }
 
 void Renderer::setEntryPoint(IPipelineEntry& entry) {
@@ -23,3 +128,8 @@ void Renderer::setEntryPoint(IPipelineEntry& entry) {
     mEntryPoint = &entry;
     mEntryPoint->setEntry();
 }
+
+void Renderer::updateEntryPoint() {
+    if (mEntryPoint && mEntryPoint->isPending())
+        mEntryPoint->setEntry();
+}
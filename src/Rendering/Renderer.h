@@ -11,15 +11,36 @@ public:
     virtual void drawDebug() = 0;
 
     void drawScene();
+    /**
+     * @brief Execute each command in order.
+     */
+    static void executeCommands(const CommandBuffer& commands);
+
+    /**
+     * @returns State changes issued and elided by the last drawScene().
+     */
+    [[nodiscard]] inline const RenderConfig::StateStats& getFrameStateStats() const {
+        return mFrameStateStats;
+    }
 
     void clearPipeline(bool resetEntryPoint) final;
     void appendPipeline(pipeline_callback callback) final;
+    [[nodiscard]] CommandBuffer& getCommandBuffer() final {
+        return mRenderPipeline;
+    }
 
     void setEntryPoint(IPipelineEntry& entry) final;
 protected:
     Renderer() = default;
+
+    /**
+     * @brief Set the current entry point again if it is pending, e.g. once the resources it was waiting on are ready.
+     */
+    void updateEntryPoint();
 private:
     IPipelineEntry* mEntryPoint = nullptr;
 
-    std::vector<pipeline_callback> mRenderPipeline{};
+    CommandBuffer mRenderPipeline{};
+
+    RenderConfig::StateStats mFrameStateStats{};
 };
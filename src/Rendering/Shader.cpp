@@ -1,12 +1,19 @@
 #include "Shader.h"
 
+#include "ProgramCache.h"
+#include "RenderConfig.h"
 #include "Texture.h"
 
 #include <glad/glad.h>
 
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #include <regex>
 #include <sstream>
+#include <unordered_set>
+
+std::vector<Shader*> Shader::sPendingShaders{};
 
 Shader::Shader(const std::string& vertCode, const std::string& fragCode,
                const std::string& tescCode, const std::string& teseCode, const std::string& geomCode) :
@@ -20,11 +27,14 @@ mProgramID(glCreateProgram()) {
     if (!geomCode.empty())
         mShaderPasses.emplace_back(geomCode, GL_GEOMETRY_SHADER);
 
-    if (loadShaders())
-        mState = ErrorState::VALID;
+    loadShaders();
 }
 
 Shader::~Shader() {
+    sPendingShaders.erase(std::remove(sPendingShaders.begin(), sPendingShaders.end(), this), sPendingShaders.end());
+    for (unsigned int shader : mPendingShaders)
+        glDeleteShader(shader);
+    RenderConfig::releaseProgram(mProgramID);
     glDeleteProgram(mProgramID);
 }
 
@@ -58,66 +68,130 @@ void Shader::setUniformAny(const std::string& name, const std::any& value) {
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "readability-make-member-function-const"
 void Shader::setUniform(const std::string& name, float value) {
-    glUniform1f(getUniformLocation(name), value);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, glm::vec2 value) {
-    glUniform2fv(getUniformLocation(name), 1, &value[0]);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, glm::vec3 value) {
-    glUniform3fv(getUniformLocation(name), 1, &value[0]);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, glm::vec4 value) {
-    glUniform4fv(getUniformLocation(name), 1, &value[0]);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, int value) {
-    glUniform1i(getUniformLocation(name), value);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, glm::ivec2 value) {
-    glUniform2iv(getUniformLocation(name), 1, &value[0]);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, glm::ivec3 value) {
-    glUniform3iv(getUniformLocation(name), 1, &value[0]);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, glm::ivec4 value) {
-    glUniform4iv(getUniformLocation(name), 1, &value[0]);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, glm::mat2 value) {
-    glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &value[0][0]);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, glm::mat3 value) {
-    glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &value[0][0]);
+    setUniform(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, glm::mat4 value) {
-    glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &value[0][0]);
+    setUniform(getUniformLocation(name), value);
+}
+
+void Shader::setUniform(int location, float value) {
+    glUniform1f(location, value);
+}
+
+void Shader::setUniform(int location, glm::vec2 value) {
+    glUniform2fv(location, 1, &value[0]);
+}
+
+void Shader::setUniform(int location, glm::vec3 value) {
+    glUniform3fv(location, 1, &value[0]);
+}
+
+void Shader::setUniform(int location, glm::vec4 value) {
+    glUniform4fv(location, 1, &value[0]);
+}
+
+void Shader::setUniform(int location, int value) {
+    glUniform1i(location, value);
+}
+
+void Shader::setUniform(int location, glm::ivec2 value) {
+    glUniform2iv(location, 1, &value[0]);
+}
+
+void Shader::setUniform(int location, glm::ivec3 value) {
+    glUniform3iv(location, 1, &value[0]);
+}
+
+void Shader::setUniform(int location, glm::ivec4 value) {
+    glUniform4iv(location, 1, &value[0]);
+}
+
+void Shader::setUniform(int location, glm::mat2 value) {
+    glUniformMatrix2fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+void Shader::setUniform(int location, glm::mat3 value) {
+    glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+void Shader::setUniform(int location, glm::mat4 value) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
 }
 #pragma clang diagnostic pop
 
 int Shader::getUniformLocation(const std::string& name) const {
-    return glGetUniformLocation(mProgramID, name.c_str());
+    if (const UniformInfo* uniform = findUniform(name))
+        return uniform->location;
+    // Individual array elements (e.g. "lights[2]") are not in the table
+    if (name.find('[') != std::string::npos)
+        return glGetUniformLocation(mProgramID, name.c_str());
+    return -1;
+}
+
+const Shader::UniformInfo* Shader::findUniform(const std::string& name) const {
+    auto uniform = mUniformIndices.find(name);
+    return uniform == mUniformIndices.end() ? nullptr : &mUniformTable[uniform->second];
 }
 
 void Shader::bind() const {
-    glUseProgram(mProgramID);
+    RenderConfig::bindProgram(mProgramID);
 }
 
 void Shader::unbind() {
-    glUseProgram(0);
+    RenderConfig::bindProgram(0);
+}
+
+const std::string* Shader::getCode(unsigned int type) const {
+    auto pass = std::find_if(mShaderPasses.begin(), mShaderPasses.end(), [type](const ShaderPass& pass) {
+        return pass.type == type;
+    });
+    return pass == mShaderPasses.end() ? nullptr : &pass->code;
 }
 
 std::vector<Shader::UniformSet> Shader::getUniforms() {
+    waitForCompile();
+
     std::vector<UniformSet> uniforms;
 
-    for (const ShaderPass& pass : mShaderPasses) {
+    for (size_t i = 0; i < mShaderPasses.size(); i++) {
+        const ShaderPass& pass = mShaderPasses[i];
         std::string passName;
         switch (pass.type) {
             case GL_VERTEX_SHADER          : passName = "Vertex"   ; break;
@@ -127,12 +201,28 @@ std::vector<Shader::UniformSet> Shader::getUniforms() {
             case GL_GEOMETRY_SHADER        : passName = "Geometry" ; break;
             default                        : passName = "<error>"  ; break;
         }
-        std::vector<Uniform> passUniforms;
 
-        std::string code = pass.code;
-        code.erase(std::remove(code.begin(), code.end(), '\n'), code.end());
+        std::vector<const UniformInfo*> passInfos;
+        for (const UniformInfo& info : mUniformTable)
+            if (((info.passMask | info.declarationMask) & (1u << i)) && info.blockIndex == -1 && info.arraySize == 1)
+                passInfos.push_back(&info);
+        std::sort(passInfos.begin(), passInfos.end(), [i](const UniformInfo* a, const UniformInfo* b) {
+            return a->declarationOffsets[i] < b->declarationOffsets[i];
+        });
 
-        parseUniforms(code, passUniforms);
+        std::vector<Uniform> passUniforms;
+        for (const UniformInfo* info : passInfos) {
+            uniform_t value;
+            if (!generateUniform(info->type, value, info->defaultValue))
+                continue;
+            passUniforms.push_back({info->name, value});
+            if (info->location == -1)
+                continue;
+            std::visit(VisitOverload{
+                [](Texture*) {},
+                [this, info](auto& arg) { setUniform(info->location, arg); },
+            }, value);
+        }
 
         uniforms.push_back({passName, passUniforms});
     }
@@ -140,20 +230,103 @@ std::vector<Shader::UniformSet> Shader::getUniforms() {
     return uniforms;
 }
 
-bool Shader::loadShaders() {
-    for (ShaderPass& pass : mShaderPasses)
-        if (!compileShader(pass.code, pass.type))
-            return false;
-    return linkProgram();
+bool Shader::updateState() {
+    if (mState != ErrorState::COMPILING)
+        return false;
+
+    GLint isComplete = GL_FALSE;
+    glGetProgramiv(mProgramID, GL_COMPLETION_STATUS_KHR, &isComplete);
+    if (isComplete != GL_TRUE)
+        return false;
+
+    finishCompile();
+    return true;
+}
+
+void Shader::waitForCompile() {
+    if (mState == ErrorState::COMPILING)
+        finishCompile();
+}
+
+bool Shader::updatePending() {
+    bool anyFinished = false;
+    for (Shader* shader : std::vector<Shader*>(sPendingShaders))
+        anyFinished |= shader->updateState();
+    return anyFinished;
+}
+
+bool Shader::isParallelCompileSupported() {
+    static const bool cIS_SUPPORTED = []() {
+        if (GLAD_GL_KHR_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+            return true;
+        }
+        if (GLAD_GL_ARB_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+            return true;
+        }
+        return false;
+    }();
+    return cIS_SUPPORTED;
 }
 
-bool Shader::compileShader(const std::string& code, unsigned int type) {
+void Shader::loadShaders() {
+    mCacheKey.clear();
+    for (const ShaderPass& pass : mShaderPasses)
+        mCacheKey.append(std::to_string(pass.type)).append(" ").append(std::to_string(pass.code.size())).append("\n")
+                 .append(pass.code);
+    mCacheKey = ProgramCache::makeKey(mCacheKey);
+
+    if (ProgramCache::load(mCacheKey, mProgramID)) {
+        reflectUniforms();
+        mState = ErrorState::VALID;
+        return;
+    }
+
+    glProgramParameteri(mProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    mCompileStart = std::chrono::steady_clock::now();
+    for (const ShaderPass& pass : mShaderPasses)
+        mPendingShaders.push_back(compileShader(pass.code, pass.type));
+    glLinkProgram(mProgramID);
+
+    mState = ErrorState::COMPILING;
+    mMessage = "Compiling";
+    if (isParallelCompileSupported())
+        sPendingShaders.push_back(this);
+    else
+        finishCompile();
+}
+
+void Shader::finishCompile() {
+    sPendingShaders.erase(std::remove(sPendingShaders.begin(), sPendingShaders.end(), this), sPendingShaders.end());
+
+    bool success = true;
+    for (unsigned int shader : mPendingShaders) {
+        success = success && checkCompileStatus(shader);
+        glDeleteShader(shader);
+    }
+    mPendingShaders.clear();
+    if (!success || !checkLinkStatus())
+        return;
+
+    ProgramCache::store(mCacheKey, mProgramID, std::chrono::steady_clock::now() - mCompileStart);
+    reflectUniforms();
+    mState = ErrorState::VALID;
+}
+
+unsigned int Shader::compileShader(const std::string& code, unsigned int type) const {
     GLuint shader = glCreateShader(type);
 
     const GLchar* data = code.c_str();
     glShaderSource(shader, 1, &data, nullptr);
     glCompileShader(shader);
 
+    glAttachShader(mProgramID, shader);
+    return shader;
+}
+
+bool Shader::checkCompileStatus(unsigned int shader) {
     GLint success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (success != GL_TRUE) {
@@ -162,15 +335,10 @@ bool Shader::compileShader(const std::string& code, unsigned int type) {
         glGetShaderInfoLog(shader, 512, nullptr, mMessage.data());
         return false;
     }
-
-    glAttachShader(mProgramID, shader);
-    glDeleteShader(shader);
     return true;
 }
 
-bool Shader::linkProgram() {
-    glLinkProgram(mProgramID);
-
+bool Shader::checkLinkStatus() {
     GLint success;
     glGetProgramiv(mProgramID, GL_LINK_STATUS, &success);
     if (success != GL_TRUE) {
@@ -182,42 +350,152 @@ bool Shader::linkProgram() {
     return true;
 }
 
-void Shader::parseUniforms(const std::string& code, std::vector<Uniform>& uniforms) {
+void Shader::reflectUniforms() {
+    mUniformTable.clear();
+    mUniformIndices.clear();
     mSamplers.clear();
 
-    static const std::regex cUNIFORM_REGEX("uniform +([a-zA-Z0-9_]+) +([a-zA-Z0-9_]+)( *= *(.*) *)?;");
-    for (std::sregex_iterator i = std::sregex_iterator(code.begin(), code.end(), cUNIFORM_REGEX);
+    static const GLenum cPASS_PROPERTIES[] = {
+        GL_REFERENCED_BY_VERTEX_SHADER, GL_REFERENCED_BY_FRAGMENT_SHADER, GL_REFERENCED_BY_TESS_CONTROL_SHADER,
+        GL_REFERENCED_BY_TESS_EVALUATION_SHADER, GL_REFERENCED_BY_GEOMETRY_SHADER,
+    };
+    const auto getPassProperty = [](unsigned int type) {
+        switch (type) {
+            default:
+            case GL_VERTEX_SHADER          : return cPASS_PROPERTIES[0];
+            case GL_FRAGMENT_SHADER        : return cPASS_PROPERTIES[1];
+            case GL_TESS_CONTROL_SHADER    : return cPASS_PROPERTIES[2];
+            case GL_TESS_EVALUATION_SHADER : return cPASS_PROPERTIES[3];
+            case GL_GEOMETRY_SHADER        : return cPASS_PROPERTIES[4];
+        }
+    };
+
+    std::vector<GLenum> properties = {GL_NAME_LENGTH, GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX};
+    for (const ShaderPass& pass : mShaderPasses)
+        properties.push_back(getPassProperty(pass.type));
+
+    std::vector<std::vector<UniformDeclaration>> declarations(mShaderPasses.size());
+    for (size_t i = 0; i < mShaderPasses.size(); i++)
+        parseDeclarations(mShaderPasses[i].code, declarations[i]);
+    const auto applyDeclarations = [&declarations](UniformInfo& info) {
+        for (size_t i = 0; i < declarations.size(); i++) {
+            for (const UniformDeclaration& declaration : declarations[i]) {
+                if (declaration.name != info.name)
+                    continue;
+                info.declarationMask |= 1u << i;
+                info.declarationOffsets[i] = declaration.offset;
+                if (info.defaultValue.empty())
+                    info.defaultValue = declaration.defaultValue;
+                break;
+            }
+        }
+    };
+
+    GLint numUniforms = 0;
+    glGetProgramInterfaceiv(mProgramID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numUniforms);
+    mUniformTable.reserve(numUniforms);
+
+    std::vector<GLint> values(properties.size());
+    for (GLint i = 0; i < numUniforms; i++) {
+        glGetProgramResourceiv(mProgramID, GL_UNIFORM, i, (GLsizei)properties.size(), properties.data(),
+                               (GLsizei)values.size(), nullptr, values.data());
+
+        UniformInfo& info = mUniformTable.emplace_back();
+        info.name = std::string(std::max(values[0], 1), '\0');
+        glGetProgramResourceName(mProgramID, GL_UNIFORM, i, values[0], nullptr, info.name.data());
+        info.name.resize(std::strlen(info.name.c_str()));
+        if (info.name.size() > 3 && info.name.compare(info.name.size() - 3, 3, "[0]") == 0)
+            info.name.resize(info.name.size() - 3);
+
+        info.type = values[1];
+        info.arraySize = values[2];
+        info.location = values[3];
+        info.blockIndex = values[4];
+        info.declarationOffsets.resize(mShaderPasses.size(), std::string::npos);
+        for (size_t j = 0; j < mShaderPasses.size(); j++) {
+            if (values[5 + j] == GL_FALSE)
+                continue;
+            info.passMask |= 1u << j;
+            info.declarationOffsets[j] = findIdentifier(mShaderPasses[j].code, info.name);
+        }
+
+        applyDeclarations(info);
+
+        if (info.type == GL_SAMPLER_2D && info.blockIndex == -1)
+            mSamplers.push_back(info.name);
+
+        mUniformIndices.emplace(info.name, mUniformTable.size() - 1);
+    }
+
+    // Keep uniforms which were optimised out, so they still get ports, but leave them out of mUniformIndices
+    std::unordered_set<std::string> inactiveNames;
+    for (const std::vector<UniformDeclaration>& passDeclarations : declarations) {
+        for (const UniformDeclaration& declaration : passDeclarations) {
+            if (declaration.isArray || declaration.type == 0 || mUniformIndices.contains(declaration.name) ||
+                !inactiveNames.insert(declaration.name).second)
+                continue;
+            UniformInfo& info = mUniformTable.emplace_back();
+            info.name = declaration.name;
+            info.type = declaration.type;
+            info.declarationOffsets.resize(mShaderPasses.size(), std::string::npos);
+            applyDeclarations(info);
+        }
+    }
+}
+
+void Shader::parseDeclarations(const std::string& code, std::vector<UniformDeclaration>& declarations) {
+    static const std::unordered_map<std::string, unsigned int> cTYPE_NAMES = {
+        {"float", GL_FLOAT}, {"vec2", GL_FLOAT_VEC2}, {"vec3", GL_FLOAT_VEC3}, {"vec4", GL_FLOAT_VEC4},
+        {"int", GL_INT}, {"ivec2", GL_INT_VEC2}, {"ivec3", GL_INT_VEC3}, {"ivec4", GL_INT_VEC4},
+        {"mat2", GL_FLOAT_MAT2}, {"mat3", GL_FLOAT_MAT3}, {"mat4", GL_FLOAT_MAT4},
+        {"sampler2D", GL_SAMPLER_2D},
+    };
+    static const std::regex cDECLARATION_REGEX(
+        "uniform\\s+(?:[a-zA-Z0-9_]+\\s+)*?([a-zA-Z0-9_]+)\\s+([a-zA-Z0-9_]+)\\s*(\\[[^\\]]*\\])?"
+        "\\s*(?:=\\s*([^;]*?)\\s*)?;"
+    );
+    for (std::sregex_iterator i = std::sregex_iterator(code.begin(), code.end(), cDECLARATION_REGEX);
          i != std::sregex_iterator(); ++i) {
-        std::smatch match = *i;
-        std::string type = match[1];
-        std::string name = match[2];
-        std::string defaultValue = match[4];
-
-        uniform_t uniform = generateUniform(type, defaultValue);
-        uniforms.push_back({name, uniform});
-        std::visit(VisitOverload{
-            [this, name](Texture* arg) { mSamplers.emplace_back(name); },
-            [this, name](auto&    arg) { setUniform(name, arg);        },
-        }, uniform);
+        const std::smatch& match = *i;
+        UniformDeclaration& declaration = declarations.emplace_back();
+        auto type = cTYPE_NAMES.find(match[1]);
+        declaration.type = type == cTYPE_NAMES.end() ? 0 : type->second;
+        declaration.name = match[2];
+        declaration.offset = (size_t)match.position(2);
+        declaration.isArray = match[3].matched;
+        declaration.defaultValue = match[4];
     }
 }
 
-Shader::uniform_t Shader::generateUniform(const std::string& type, const std::string& defaultValue) {
-    static const std::unordered_map<std::string, uniform_t> cUNIFORM_TYPE_MAP = {
-        {"float", (float)0.0f},
-        {"vec2", glm::vec2(0.0f)},
-        {"vec3", glm::vec3(0.0f)},
-        {"vec4", glm::vec4(0.0f)},
-        {"int", (int)0},
-        {"ivec2", glm::ivec2(0)},
-        {"ivec3", glm::ivec3(0)},
-        {"ivec4", glm::ivec4(0)},
-        {"mat2", glm::mat2(1.0f)},
-        {"mat3", glm::mat3(1.0f)},
-        {"mat4", glm::mat4(1.0f)},
-        {"sampler2D", (Texture*)nullptr},
+size_t Shader::findIdentifier(const std::string& code, const std::string& name) {
+    const auto isIdentifierChar = [](char c) { return std::isalnum((unsigned char)c) || c == '_'; };
+    for (size_t i = code.find(name); i != std::string::npos; i = code.find(name, i + 1)) {
+        size_t end = i + name.size();
+        if ((i == 0 || !isIdentifierChar(code[i - 1])) && (end == code.size() || !isIdentifierChar(code[end])))
+            return i;
+    }
+    return std::string::npos;
+}
+
+bool Shader::generateUniform(unsigned int type, uniform_t& value, const std::string& defaultValue) {
+    static const std::unordered_map<unsigned int, uniform_t> cUNIFORM_TYPE_MAP = {
+        {GL_FLOAT, (float)0.0f},
+        {GL_FLOAT_VEC2, glm::vec2(0.0f)},
+        {GL_FLOAT_VEC3, glm::vec3(0.0f)},
+        {GL_FLOAT_VEC4, glm::vec4(0.0f)},
+        {GL_INT, (int)0},
+        {GL_INT_VEC2, glm::ivec2(0)},
+        {GL_INT_VEC3, glm::ivec3(0)},
+        {GL_INT_VEC4, glm::ivec4(0)},
+        {GL_FLOAT_MAT2, glm::mat2(1.0f)},
+        {GL_FLOAT_MAT3, glm::mat3(1.0f)},
+        {GL_FLOAT_MAT4, glm::mat4(1.0f)},
+        {GL_SAMPLER_2D, (Texture*)nullptr},
     };
-    uniform_t value = cUNIFORM_TYPE_MAP.find(type)->second;
+    auto uniformType = cUNIFORM_TYPE_MAP.find(type);
+    if (uniformType == cUNIFORM_TYPE_MAP.end())
+        return false;
+    value = uniformType->second;
     if (!defaultValue.empty())
         value = std::visit(VisitOverload{
             [](auto arg)->uniform_t { return arg; },
@@ -230,5 +508,5 @@ Shader::uniform_t Shader::generateUniform(const std::string& type, const std::st
             [defaultValue](glm::ivec3 arg)->uniform_t { return stringToIVec3(defaultValue); },
             [defaultValue](glm::ivec4 arg)->uniform_t { return stringToIVec4(defaultValue); },
         }, value);
-    return value;
+    return true;
 }
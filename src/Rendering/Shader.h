@@ -4,7 +4,9 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <any>
+#include <chrono>
 #include <string>
 #include <typeindex>
 #include <unordered_map>
@@ -26,6 +28,7 @@ public:
     enum class ErrorState {
         INVALID,
         VALID,
+        COMPILING,
         FILE_READ,
         OGL_COMPILE,
         OGL_LINK,
@@ -35,6 +38,47 @@ public:
         std::string name;
         uniform_t value;
     };
+    /**
+     * @brief Description of a uniform, built once when the program is linked (or loaded). Active uniforms are
+     * reflected from the program, while uniforms which are declared but optimised out are parsed from their
+     * declaration.
+     */
+    struct UniformInfo {
+        /**
+         * @brief Uniform name, without any trailing "[0]" for arrays.
+         */
+        std::string name;
+        /**
+         * @brief Location in the program, or -1 if the uniform is not active.
+         */
+        int location = -1;
+        /**
+         * @brief GL data type (e.g. GL_FLOAT_VEC3).
+         */
+        unsigned int type = 0;
+        int arraySize = 1;
+        /**
+         * @brief Index of the interface block containing the uniform, or -1 if it is in the default block.
+         */
+        int blockIndex = -1;
+        /**
+         * @brief Bit i is set if the uniform is active in the i-th shader pass.
+         */
+        unsigned int passMask = 0;
+        /**
+         * @brief Bit i is set if the uniform is declared in the i-th shader pass.
+         */
+        unsigned int declarationMask = 0;
+        /**
+         * @brief Position of the uniform's declaration in each pass it is declared or active in (used to keep
+         * declaration order).
+         */
+        std::vector<size_t> declarationOffsets;
+        /**
+         * @brief GLSL initializer from the uniform's declaration, or empty if it has none.
+         */
+        std::string defaultValue;
+    };
     struct UniformSet {
         std::string name;
         std::vector<Uniform> uniforms;
@@ -59,12 +103,37 @@ public:
     void setUniform(const std::string& name, glm::mat3 value);
     void setUniform(const std::string& name, glm::mat4 value);
 
+    void setUniform(int location, float value);
+    void setUniform(int location, glm::vec2 value);
+    void setUniform(int location, glm::vec3 value);
+    void setUniform(int location, glm::vec4 value);
+    void setUniform(int location, int value);
+    void setUniform(int location, glm::ivec2 value);
+    void setUniform(int location, glm::ivec3 value);
+    void setUniform(int location, glm::ivec4 value);
+    void setUniform(int location, glm::mat2 value);
+    void setUniform(int location, glm::mat3 value);
+    void setUniform(int location, glm::mat4 value);
+
     [[nodiscard]] int getSamplerLocation(const std::string& name) const {
         return std::find(mSamplers.begin(), mSamplers.end(), name) - mSamplers.begin();
     }
 
+    /**
+     * @returns Location of the named uniform from the reflected uniform table, or -1 if it is not active. Resolve
+     * locations once and pass them to setUniform() rather than setting uniforms by name on hot paths.
+     */
     [[nodiscard]] int getUniformLocation(const std::string& name) const;
 
+    [[nodiscard]] inline const std::vector<UniformInfo>& getUniformTable() const {
+        return mUniformTable;
+    }
+    /**
+     * @returns Reflected uniform with the given name, or nullptr if it is not active (inactive uniforms are only
+     * listed in getUniformTable()).
+     */
+    [[nodiscard]] const UniformInfo* findUniform(const std::string& name) const;
+
     void bind() const;
 
     static void unbind();
@@ -73,44 +142,114 @@ public:
         return mState;
     }
 
+    /**
+     * @brief Check whether a pending (parallel) compile has finished, without blocking.
+     * @returns true if the compile finished during this call, otherwise false.
+     */
+    bool updateState();
+    /**
+     * @brief Block until any pending compile has finished.
+     */
+    void waitForCompile();
+
+    /**
+     * @brief Call updateState() on every shader with a pending compile. Intended to be polled once per frame.
+     * @returns true if any compile finished, otherwise false.
+     */
+    static bool updatePending();
+    /**
+     * @returns true if the driver supports KHR/ARB_parallel_shader_compile, in which case programs are compiled in
+     * the background and remain in the COMPILING state until polled.
+     */
+    [[nodiscard]] static bool isParallelCompileSupported();
+
     [[nodiscard]] inline std::string getErrorMessage() const {
         return mMessage;
     }
 
     /**
-     * @brief Parse all uniforms from shader code into a list of valid uniforms.
-     * @brief All passes are assumed to be valid.
+     * @param type GL shader type (e.g. GL_FRAGMENT_SHADER).
+     * @returns Source code of the stage of the given type, or nullptr if the program has no such stage.
+     */
+    [[nodiscard]] const std::string* getCode(unsigned int type) const;
+    [[nodiscard]] inline std::size_t numStages() const {
+        return mShaderPasses.size();
+    }
+
+    /**
+     * @brief List the default block uniforms declared in each pass, in declaration order, and set each active
+     * uniform to its default value. Uniforms which are optimised out are still listed, so that links to them survive
+     * until they are used again.
+     * @brief Arrays, block members and types without a uniform_t equivalent are omitted.
      */
     std::vector<UniformSet> getUniforms();
+
+    /**
+     * @param type GL data type (e.g. GL_FLOAT_VEC3).
+     * @param value Output variant matching the primitive or glm equivalent of type.
+     * @param defaultValue glsl format variable instantiation (if present).
+     * @return true if type has a uniform_t equivalent, otherwise false.
+     */
+    static bool generateUniform(unsigned int type, uniform_t& value, const std::string& defaultValue = "");
 private:
     struct ShaderPass {
         ShaderPass(std::string code, unsigned int type) : code(std::move(code)), type(type) {}
         unsigned int type;
         std::string code;
     };
-    bool loadShaders();
-    bool compileShader(const std::string& code, unsigned int type);
-    bool linkProgram();
+    /**
+     * @brief Load the program from the program cache, or otherwise begin compiling and linking it.
+     */
+    void loadShaders();
+    /**
+     * @brief Check the results of compiling and linking, then reflect (and cache) the program if successful.
+     */
+    void finishCompile();
+    /**
+     * @brief Create, compile and attach a shader object, without waiting for the result.
+     */
+    [[nodiscard]] unsigned int compileShader(const std::string& code, unsigned int type) const;
+    bool checkCompileStatus(unsigned int shader);
+    bool checkLinkStatus();
 
     /**
-     * @brief Find all uniform variables in code and use them to populate uniforms.
-     * @param code glsl format shader code to parse.
-     * @param uniforms Vector of uniforms to populate with uniform data.
+     * @brief Build the uniform table from program interface queries. Must be called after linking.
      */
-    void parseUniforms(const std::string& code, std::vector<Uniform>& uniforms);
+    void reflectUniforms();
+    struct UniformDeclaration {
+        std::string name;
+        /**
+         * @brief GL data type (e.g. GL_FLOAT_VEC3), or 0 if the declared type has no uniform_t equivalent.
+         */
+        unsigned int type = 0;
+        size_t offset = 0;
+        std::string defaultValue;
+        bool isArray = false;
+    };
     /**
-     * @param type glsl format data type.
-     * @param defaultValue glsl format variable instantiation (if present).
-     * @return Variant matching the primitive or glm equivalent type specified in type.
+     * @brief Find all default block uniform declarations in code, along with their types and initializers.
      */
-    static uniform_t generateUniform(const std::string& type, const std::string& defaultValue = "");
+    static void parseDeclarations(const std::string& code, std::vector<UniformDeclaration>& declarations);
+    /**
+     * @returns Position of the first occurrence of name in code as a whole identifier, or std::string::npos.
+     */
+    [[nodiscard]] static size_t findIdentifier(const std::string& code, const std::string& name);
 
     std::vector<ShaderPass> mShaderPasses;
 
     unsigned int mProgramID = 0;
 
+    std::string mCacheKey;
+    std::vector<unsigned int> mPendingShaders{};
+    std::chrono::steady_clock::time_point mCompileStart{};
+
     std::vector<std::string> mSamplers{};
 
+    std::vector<UniformInfo> mUniformTable{};
+    std::unordered_map<std::string, size_t> mUniformIndices{};
+
     ErrorState mState = ErrorState::INVALID;
     std::string mMessage = "Not Initialized";
+
+    static std::vector<Shader*> sPendingShaders;
 };
@@ -0,0 +1,649 @@
+#include "ShaderFusion.h"
+
+#include "Shader.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <string_view>
+#include <unordered_set>
+
+std::unordered_map<std::string, std::unique_ptr<Shader>> ShaderFusion::sPrograms{};
+
+static bool isIdentifierChar(char c) {
+    return std::isalnum((unsigned char)c) || c == '_';
+}
+
+static std::string_view trim(std::string_view text) {
+    const std::size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos)
+        return {};
+    return text.substr(first, text.find_last_not_of(" \t\r\n") + 1 - first);
+}
+
+static std::string removeWhitespace(std::string_view text) {
+    std::string result{};
+    for (char c : text)
+        if (!std::isspace((unsigned char)c))
+            result.push_back(c);
+    return result;
+}
+
+/**
+ * @brief Call visit with the position and length of every identifier or keyword in code, skipping numeric literals.
+ */
+template<typename F>
+static void forEachIdentifier(std::string_view code, F visit) {
+    for (std::size_t i = 0; i < code.size();) {
+        if (!isIdentifierChar(code[i])) {
+            i++;
+            continue;
+        }
+        std::size_t end = i;
+        while (end < code.size() && isIdentifierChar(code[end]))
+            end++;
+        if (!std::isdigit((unsigned char)code[i]))
+            visit(i, end - i);
+        i = end;
+    }
+}
+
+static std::vector<std::string> getIdentifiers(std::string_view code) {
+    std::vector<std::string> identifiers{};
+    forEachIdentifier(code, [&](std::size_t pos, std::size_t length) {
+        identifiers.emplace_back(code.substr(pos, length));
+    });
+    return identifiers;
+}
+
+static std::size_t findIdentifier(std::string_view code, std::string_view name, std::size_t from) {
+    for (std::size_t i = code.find(name, from); i != std::string_view::npos; i = code.find(name, i + 1)) {
+        const std::size_t end = i + name.size();
+        if ((i == 0 || !isIdentifierChar(code[i - 1])) && (end == code.size() || !isIdentifierChar(code[end])))
+            return i;
+    }
+    return std::string_view::npos;
+}
+
+/**
+ * @returns true if the identifier at pos follows a '.' (i.e. is a member or swizzle rather than a global).
+ */
+static bool isMemberAccess(std::string_view code, std::size_t pos) {
+    while (pos > 0 && std::isspace((unsigned char)code[pos - 1]))
+        pos--;
+    return pos > 0 && code[pos - 1] == '.';
+}
+
+static std::string renameIdentifiers(std::string_view code, const std::unordered_map<std::string, std::string>& names) {
+    std::string result{};
+    std::size_t last = 0;
+    forEachIdentifier(code, [&](std::size_t pos, std::size_t length) {
+        auto name = names.find(std::string(code.substr(pos, length)));
+        if (name == names.end() || isMemberAccess(code, pos))
+            return;
+        result.append(code.substr(last, pos - last)).append(name->second);
+        last = pos + length;
+    });
+    result.append(code.substr(last));
+    return result;
+}
+
+/**
+ * @brief Replace every comment in code with whitespace.
+ */
+static std::string stripComments(const std::string& code) {
+    std::string result{};
+    result.reserve(code.size());
+    for (std::size_t i = 0; i < code.size(); i++) {
+        if (code.compare(i, 2, "//") == 0) {
+            i = code.find('\n', i);
+            if (i == std::string::npos)
+                break;
+            result.push_back('\n');
+        } else if (code.compare(i, 2, "/*") == 0) {
+            i = code.find("*/", i + 2);
+            if (i == std::string::npos)
+                break;
+            result.push_back(' ');
+            i++;
+        } else {
+            result.push_back(code[i]);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Split code into its top level preprocessor directives and statements (declarations and function
+ * definitions).
+ * @returns false if code is malformed.
+ */
+static bool splitStatements(const std::string& code, std::vector<std::string>& directives,
+                            std::vector<std::string>& statements) {
+    std::string current{};
+    int braceDepth = 0;
+    int parenDepth = 0;
+    std::size_t headerEnd = std::string::npos;
+
+    const auto endStatement = [&]() {
+        statements.push_back(std::move(current));
+        current.clear();
+        headerEnd = std::string::npos;
+    };
+
+    for (std::size_t i = 0; i < code.size(); i++) {
+        const char c = code[i];
+        if (c == '#' && braceDepth == 0 && trim(current).empty()) {
+            std::size_t end = code.find('\n', i);
+            end = end == std::string::npos ? code.size() : end;
+            directives.emplace_back(trim(std::string_view(code).substr(i, end - i)));
+            current.clear();
+            i = end;
+            continue;
+        }
+
+        current.push_back(c);
+        switch (c) {
+            case '(':
+                parenDepth++;
+                break;
+            case ')':
+                parenDepth--;
+                break;
+            case '{':
+                if (braceDepth++ == 0 && headerEnd == std::string::npos)
+                    headerEnd = current.size() - 1;
+                break;
+            case '}':
+                if (--braceDepth < 0)
+                    return false;
+                // Function definitions end at their closing brace, while blocks continue to the next semicolon
+                if (braceDepth == 0) {
+                    std::string_view header = trim(std::string_view(current).substr(0, headerEnd));
+                    if (!header.empty() && header.back() == ')')
+                        endStatement();
+                }
+                break;
+            case ';':
+                if (braceDepth == 0 && parenDepth == 0)
+                    endStatement();
+                break;
+            default:
+                break;
+        }
+    }
+    return braceDepth == 0 && trim(current).empty();
+}
+
+/**
+ * @returns declaration without any leading layout qualifier.
+ */
+static std::string_view removeLayout(std::string_view declaration) {
+    declaration = trim(declaration);
+    if (declaration.substr(0, 6) != "layout")
+        return declaration;
+    const std::size_t close = declaration.find(')');
+    return close == std::string_view::npos ? std::string_view() : declaration.substr(close + 1);
+}
+
+/**
+ * @returns Location given by the layout qualifier of declaration, or -1 if it has none.
+ */
+static int getLayoutLocation(std::string_view declaration) {
+    declaration = trim(declaration);
+    if (declaration.substr(0, 6) != "layout")
+        return -1;
+    const std::string layout = removeWhitespace(declaration.substr(0, declaration.find(')')));
+    const std::size_t location = layout.find("location=");
+    return location == std::string::npos ? -1 : std::atoi(layout.c_str() + location + 9);
+}
+
+/**
+ * @returns Identifiers of the declaration, excluding any layout and any qualifiers which do not affect fusion.
+ */
+static std::vector<std::string> getDeclarationWords(std::string_view header) {
+    static const std::unordered_set<std::string> cIGNORED_QUALIFIERS = {
+        "flat", "smooth", "noperspective", "centroid", "sample", "invariant", "precise", "highp", "mediump", "lowp",
+    };
+
+    std::vector<std::string> words = getIdentifiers(removeLayout(header));
+    words.erase(std::remove_if(words.begin(), words.end(), [](const std::string& word) {
+        return cIGNORED_QUALIFIERS.contains(word);
+    }), words.end());
+    return words;
+}
+
+/**
+ * @returns Name of the variable (or block instance) declared by statement, or an empty string if there is none.
+ */
+static std::string getDeclaredName(std::string_view statement) {
+    statement = removeLayout(statement);
+    const std::size_t brace = statement.rfind('}');
+    if (brace != std::string_view::npos)
+        statement = statement.substr(brace + 1);
+    statement = statement.substr(0, std::min({statement.find('='), statement.find('['), statement.find(';')}));
+
+    const std::vector<std::string> identifiers = getIdentifiers(statement);
+    return identifiers.empty() ? std::string() : identifiers.back();
+}
+
+/**
+ * @returns true if statement declares multiple variables (e.g. "float a, b;").
+ */
+static bool isDeclaratorList(std::string_view statement) {
+    int depth = 0;
+    for (char c : statement) {
+        if (c == '(' || c == '[' || c == '{')
+            depth++;
+        else if (c == ')' || c == ']' || c == '}')
+            depth--;
+        else if (c == ',' && depth == 0)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Split the arguments of a call at top level commas, removing all whitespace.
+ */
+static std::vector<std::string> splitArguments(std::string_view arguments) {
+    std::vector<std::string> result{};
+    int depth = 0;
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < arguments.size(); i++) {
+        if (arguments[i] == '(' || arguments[i] == '[')
+            depth++;
+        else if (arguments[i] == ')' || arguments[i] == ']')
+            depth--;
+        else if (arguments[i] == ',' && depth == 0) {
+            result.push_back(removeWhitespace(arguments.substr(start, i - start)));
+            start = i + 1;
+        }
+    }
+    result.push_back(removeWhitespace(arguments.substr(start)));
+    return result;
+}
+
+/**
+ * @returns Number of times name appears in code as a whole identifier (or member expression).
+ */
+static std::size_t countIdentifier(std::string_view code, std::string_view name) {
+    std::size_t count = 0;
+    for (std::size_t pos = findIdentifier(code, name, 0); pos != std::string_view::npos;
+         pos = findIdentifier(code, name, pos + 1))
+        count++;
+    return count;
+}
+
+/**
+ * @returns true if rhs (without whitespace) is a vec4 constructed from position (or its xy/xyz swizzle), of a type
+ * with numComponents components, and constants within clip space ending with a w of 1.
+ */
+static bool isPassthroughPosition(const std::string& rhs, const std::string& position, int numComponents) {
+    if (!rhs.starts_with("vec4(") || rhs.back() != ')')
+        return false;
+    const std::vector<std::string> arguments = splitArguments(std::string_view(rhs).substr(5, rhs.size() - 6));
+    if (arguments.size() < 2)
+        return false;
+
+    int numPositionComponents = numComponents;
+    if (arguments[0] == position + ".xy")
+        numPositionComponents = 2;
+    else if (arguments[0] == position + ".xyz")
+        numPositionComponents = 3;
+    else if (arguments[0] != position)
+        return false;
+    if (numPositionComponents + (int)arguments.size() - 1 != 4)
+        return false;
+
+    for (std::size_t i = 1; i < arguments.size(); i++) {
+        char* end = nullptr;
+        const float value = std::strtof(arguments[i].c_str(), &end);
+        if (arguments[i].empty() || (*end != '\0' && std::string_view(end) != "f") || std::abs(value) > 1.0f ||
+            (i + 1 == arguments.size() && value != 1.0f))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Find the output through which the vertex shader vertCode passes the attribute at uvBinding straight through
+ * to the fragment shader, provided it also passes the position at binding 0 straight through to gl_Position (so each
+ * fragment's interpolated texture coordinate is its position within a screen quad).
+ * @returns Name of the output (as "Block.member" for a member of an output block), or an empty string if there is
+ * none.
+ */
+static std::string findTexcoordOutput(const std::string& vertCode, int uvBinding) {
+    std::vector<std::string> directives{};
+    std::vector<std::string> statements{};
+    if (uvBinding < 0 || !splitStatements(stripComments(vertCode), directives, statements))
+        return {};
+
+    std::string position{}, uv{};
+    int numPositionComponents = 0;
+    // Output variables and block instances, mapped to their block name (or an empty string for variables)
+    std::unordered_map<std::string, std::string> outputs{};
+    std::string functions{};
+    for (const std::string& statement : statements) {
+        const std::size_t brace = statement.find('{');
+        const std::vector<std::string> words = getDeclarationWords(statement.substr(0, brace));
+        if (words.empty())
+            continue;
+        if (words[0] == "in" && words.size() == 3) {
+            const int location = getLayoutLocation(statement);
+            if (location == 0 && words[1].starts_with("vec")) {
+                position = words[2];
+                numPositionComponents = words[1].back() - '0';
+            } else if (location == uvBinding && words[1] == "vec2") {
+                uv = words[2];
+            }
+        } else if (words[0] == "out") {
+            outputs[getDeclaredName(statement)] = brace == std::string::npos ? std::string() : words[1];
+        } else if (brace != std::string::npos) {
+            functions.append(removeWhitespace(statement));
+        }
+    }
+    if (position.empty() || uv.empty())
+        return {};
+
+    const std::size_t positionWrite = functions.find("gl_Position=");
+    if (countIdentifier(functions, "gl_Position") != 1 || positionWrite == std::string::npos)
+        return {};
+    const std::size_t positionStart = positionWrite + 12;
+    const std::size_t positionEnd = functions.find(';', positionStart);
+    if (positionEnd == std::string::npos ||
+        !isPassthroughPosition(functions.substr(positionStart, positionEnd - positionStart), position,
+                               numPositionComponents))
+        return {};
+
+    // Written once, directly from the attribute (and never read or modified elsewhere)
+    const std::string uvWrite = std::string("=").append(uv).append(";");
+    const auto isWrittenFromUV = [&](const std::string& output) {
+        const std::size_t pos = findIdentifier(functions, output, 0);
+        const bool isStatementStart = pos == 0 || functions[pos - 1] == ';' || functions[pos - 1] == '{' ||
+                                      functions[pos - 1] == '}';
+        return pos != std::string::npos && isStatementStart && countIdentifier(functions, output) == 1 &&
+               functions.compare(pos + output.size(), uvWrite.size(), uvWrite) == 0;
+    };
+    for (const auto& [name, block] : outputs) {
+        if (block.empty()) {
+            if (isWrittenFromUV(name))
+                return name;
+            continue;
+        }
+        for (std::size_t pos = findIdentifier(functions, name, 0); pos != std::string::npos;
+             pos = findIdentifier(functions, name, pos + 1)) {
+            std::size_t memberEnd = pos + name.size();
+            if (memberEnd >= functions.size() || functions[memberEnd++] != '.')
+                continue;
+            while (memberEnd < functions.size() && isIdentifierChar(functions[memberEnd]))
+                memberEnd++;
+            const std::string member = functions.substr(pos, memberEnd - pos);
+            if (isWrittenFromUV(member))
+                return std::string(block).append(member.substr(name.size()));
+        }
+    }
+    return {};
+}
+
+/**
+ * @brief Replace every read of sampler in code with value.
+ * @param texcoords Fragment shader expressions holding the screen quad texture coordinate (see findTexcoordOutput()).
+ * @returns false if sampler is used for anything other than reading the texel of the current fragment.
+ */
+static bool replaceInputReads(std::string& code, const std::string& sampler, const std::string& value,
+                              const std::unordered_set<std::string>& texcoords) {
+    for (std::size_t pos = findIdentifier(code, sampler, 0); pos != std::string::npos;
+         pos = findIdentifier(code, sampler, pos)) {
+        std::size_t open = pos;
+        while (open > 0 && std::isspace((unsigned char)code[open - 1]))
+            open--;
+        if (open == 0 || code[--open] != '(')
+            return false;
+
+        std::size_t functionEnd = open;
+        while (functionEnd > 0 && std::isspace((unsigned char)code[functionEnd - 1]))
+            functionEnd--;
+        std::size_t functionStart = functionEnd;
+        while (functionStart > 0 && isIdentifierChar(code[functionStart - 1]))
+            functionStart--;
+        const std::string function = code.substr(functionStart, functionEnd - functionStart);
+
+        std::size_t close = open;
+        for (int depth = 0; close < code.size(); close++) {
+            if (code[close] == '(')
+                depth++;
+            else if (code[close] == ')' && --depth == 0)
+                break;
+        }
+        if (close == code.size())
+            return false;
+
+        const std::vector<std::string> arguments = splitArguments(
+            std::string_view(code).substr(open + 1, close - open - 1)
+        );
+        const bool isSampled = function == "texture" && arguments.size() == 2 && texcoords.contains(arguments[1]);
+        const bool isFetched = function == "texelFetch" && arguments.size() == 3 &&
+                               arguments[1] == "ivec2(gl_FragCoord.xy)" && arguments[2] == "0";
+        if (arguments[0] != sampler || !(isSampled || isFetched))
+            return false;
+
+        code.replace(functionStart, close + 1 - functionStart, value);
+        pos = functionStart + value.size();
+    }
+    return true;
+}
+
+Shader* ShaderFusion::fuse(const std::vector<Stage>& stages, int uvBinding) {
+    if (stages.size() < 2)
+        return nullptr;
+
+    const std::string* vertCode = stages.front().shader->getCode(GL_VERTEX_SHADER);
+    for (const Stage& stage : stages) {
+        const std::string* stageVertCode = stage.shader->getCode(GL_VERTEX_SHADER);
+        if (stage.shader->numStages() != 2 || !stageVertCode || !vertCode || *stageVertCode != *vertCode)
+            return nullptr;
+        // The shared vertex shader can only take one value for each uniform
+        for (const Shader::UniformInfo& uniform : stage.shader->getUniformTable())
+            if (uniform.passMask & 1u)
+                return nullptr;
+    }
+
+    std::string fragCode;
+    if (!generate(stages, findTexcoordOutput(*vertCode, uvBinding), fragCode))
+        return nullptr;
+
+    std::string key = std::string(*vertCode).append(1, '\0').append(fragCode);
+    auto program = sPrograms.find(key);
+    if (program == sPrograms.end()) {
+        program = sPrograms.emplace(std::move(key), std::make_unique<Shader>(*vertCode, fragCode)).first;
+        program->second->waitForCompile();
+    }
+    return program->second->getState() == Shader::ErrorState::VALID ? program->second.get() : nullptr;
+}
+
+void ShaderFusion::release() {
+    sPrograms.clear();
+}
+
+std::string ShaderFusion::getStageName(const std::string& name, std::size_t stage) {
+    return std::string(name).append("_stage").append(std::to_string(stage));
+}
+
+bool ShaderFusion::generate(const std::vector<Stage>& stages, const std::string& texcoord, std::string& fragCode) {
+    std::string version{};
+    std::vector<std::string> defines{};
+    // Directives and declarations shared by every stage, in order of first appearance
+    std::vector<std::string> header{};
+    std::vector<std::string> declarations{};
+    std::unordered_set<std::string> shared{};
+    std::string body{};
+    std::vector<std::string> mains{};
+    std::string previousOutput{};
+
+    const auto addShared = [&shared](std::vector<std::string>& list, std::string_view text) {
+        std::string normalized = removeWhitespace(text);
+        if (shared.insert(normalized).second)
+            list.emplace_back(trim(text));
+    };
+
+    for (std::size_t stage = 0; stage < stages.size(); stage++) {
+        const bool isFirst = stage == 0;
+        const bool isLast = stage + 1 == stages.size();
+
+        std::vector<std::string> directives{};
+        std::vector<std::string> statements{};
+        if (!splitStatements(stripComments(*stages[stage].shader->getCode(GL_FRAGMENT_SHADER)), directives, statements))
+            return false;
+
+        std::vector<std::string> stageDefines{};
+        for (const std::string& directive : directives) {
+            const std::vector<std::string> words = getIdentifiers(directive);
+            if (words.empty())
+                return false;
+            if (words[0] == "version") {
+                if (!version.empty() && version != directive)
+                    return false;
+                version = directive;
+            } else if (words[0] == "extension" || words[0] == "pragma") {
+                addShared(header, directive);
+            } else if (words[0] == "define") {
+                stageDefines.push_back(directive);
+            } else if (words[0] != "line") {
+                return false;
+            }
+        }
+        // Macros apply to all code following them, so every stage must use the same ones
+        if (isFirst) {
+            defines = stageDefines;
+            for (const std::string& define : defines)
+                addShared(header, define);
+        } else if (stageDefines != defines) {
+            return false;
+        }
+
+        // Globals of this stage, mapped to their name in the fused shader
+        std::unordered_map<std::string, std::string> names{};
+        std::unordered_set<std::string> texcoords{};
+        std::vector<bool> isShared(statements.size(), false);
+        std::string output{};
+        std::string outputType{};
+        std::size_t outputStatement = std::string::npos;
+        std::size_t inputStatement = std::string::npos;
+        bool hasMain = false;
+
+        for (std::size_t i = 0; i < statements.size(); i++) {
+            const std::string_view statement = statements[i];
+            const std::size_t brace = statement.find('{');
+            std::string_view declaration = trim(statement.substr(0, brace));
+            if (!declaration.empty() && declaration.back() == ';')
+                declaration = trim(declaration.substr(0, declaration.size() - 1));
+
+            const std::vector<std::string> words = getDeclarationWords(declaration);
+            if (words.empty())
+                return false;
+
+            // Function definitions and prototypes are the only declarations ending in parentheses without an '='
+            if (declaration.back() == ')' && declaration.find('=') == std::string_view::npos &&
+                words[0] != "uniform" && words[0] != "in" && words[0] != "out") {
+                const std::vector<std::string> identifiers = getIdentifiers(declaration.substr(0, declaration.find('(')));
+                if (identifiers.empty())
+                    return false;
+                names[identifiers.back()] = getStageName(identifiers.back(), stage);
+                hasMain |= identifiers.back() == "main";
+                continue;
+            }
+            if (words[0] == "precision") {
+                isShared[i] = true;
+                continue;
+            }
+            // Blocks other than inputs (and structs) would need their members renamed too
+            if ((brace != std::string_view::npos && words[0] != "in") || isDeclaratorList(statement))
+                return false;
+
+            const std::string name = getDeclaredName(statement);
+            if (name.empty())
+                return false;
+            if (words[0] == "in") {
+                // Interpolated per sample (or not at all) these would no longer match the texel at each fragment
+                const std::vector<std::string> qualifiers = getIdentifiers(removeLayout(statement));
+                const bool isInterpolated =
+                    std::find(qualifiers.begin(), qualifiers.end(), "flat") == qualifiers.end() &&
+                    std::find(qualifiers.begin(), qualifiers.end(), "sample") == qualifiers.end();
+                const std::size_t dot = texcoord.find('.');
+                if (isInterpolated && brace == std::string_view::npos && name == texcoord && words.size() == 3 &&
+                    words[1] == "vec2")
+                    texcoords.insert(name);
+                else if (isInterpolated && brace != std::string_view::npos && dot != std::string::npos &&
+                         words.size() == 2 && words[1] == texcoord.substr(0, dot) &&
+                         findIdentifier(statement, texcoord.substr(dot + 1), brace) != std::string::npos)
+                    texcoords.insert(name + texcoord.substr(dot));
+                isShared[i] = true;
+                continue;
+            } else if (words[0] == "out") {
+                if (!output.empty() || words.size() != 3)
+                    return false;
+                output = name;
+                outputType = words[1];
+                outputStatement = i;
+            } else if (words[0] == "uniform") {
+                if (!isFirst && name == stages[stage].input) {
+                    if (words.size() < 2 || words[1] != "sampler2D")
+                        return false;
+                    inputStatement = i;
+                }
+            } else if (words[0] == "buffer" || words[0] == "shared") {
+                return false;
+            }
+            names[name] = getStageName(name, stage);
+        }
+
+        if (output.empty() || !hasMain || (!isFirst && inputStatement == std::string::npos))
+            return false;
+        if (!isLast) {
+            if (outputType != "vec4")
+                return false;
+            // Discarding (or writing depth) in an earlier stage would apply to the final output once fused
+            for (const std::string& statement : statements)
+                if (findIdentifier(statement, "discard", 0) != std::string::npos ||
+                    findIdentifier(statement, "gl_FragDepth", 0) != std::string::npos)
+                    return false;
+        }
+
+        body.append("\n// Stage ").append(std::to_string(stage)).append("\n");
+        for (std::size_t i = 0; i < statements.size(); i++) {
+            if (isShared[i]) {
+                addShared(declarations, statements[i]);
+                continue;
+            } else if (i == inputStatement) {
+                continue;
+            }
+
+            std::string statement = i == outputStatement && !isLast ?
+                std::string("vec4 ").append(names[output]).append(";") : renameIdentifiers(statements[i], names);
+            if (!isFirst && !replaceInputReads(statement, names[stages[stage].input], previousOutput, texcoords))
+                return false;
+            body.append(trim(statement)).append("\n");
+        }
+
+        previousOutput = names[output];
+        mains.push_back(names["main"]);
+    }
+
+    fragCode.clear();
+    if (!version.empty())
+        fragCode.append(version).append("\n");
+    for (const std::string& line : header)
+        fragCode.append(line).append("\n");
+    for (const std::string& declaration : declarations)
+        fragCode.append(declaration).append("\n");
+    fragCode.append(body);
+    fragCode.append("\nvoid main() {\n");
+    for (const std::string& main : mains)
+        fragCode.append("    ").append(main).append("();\n");
+    fragCode.append("}\n");
+    return true;
+}
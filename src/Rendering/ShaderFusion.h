@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Shader;
+
+/**
+ * @brief Generates a single program running the fragment shaders of several consecutive passes in order, where each
+ * pass (after the first) reads the output of the previous pass only at its own fragment.
+ * @brief Every global of each stage's fragment shader (uniforms, functions, variables and its output) is renamed with
+ * getStageName(), and each stage's main() becomes a function called in order from the generated main(). Reads of the
+ * sampler holding the previous stage's output are replaced by the variable that output is now written to.
+ */
+class ShaderFusion {
+public:
+    struct Stage {
+        const Shader* shader;
+        /**
+         * @brief Name of the sampler2D uniform reading the previous stage's output (unused for the first stage). It
+         * may only be read as texelFetch(input, ivec2(gl_FragCoord.xy), 0), or as texture(input, uv) where uv is the
+         * fragment shader input (or input block member) which the vertex shader copies straight from the screen
+         * quad's texture coordinate attribute, while also passing its position straight through to gl_Position.
+         */
+        std::string input;
+    };
+
+    /**
+     * @brief Build (or find the previously built) program fusing stages. Every stage must have the same vertex shader
+     * (without uniforms of its own) and no other stages, and all but the last may only write a single vec4 output and
+     * may not discard or write gl_FragDepth.
+     * @brief New programs are compiled immediately, blocking until complete.
+     * @param uvBinding Binding of the texture coordinate attribute of the screen quad the stages are drawn with (see
+     * Mesh::setScreenQuad()), or -1 if there is none.
+     * @returns Fused program, or nullptr if the stages cannot be fused or the program failed to compile.
+     */
+    [[nodiscard]] static Shader* fuse(const std::vector<Stage>& stages, int uvBinding);
+    /**
+     * @brief Destroy every program built, which must not be used by any commands still to be executed. Must be called
+     * before the GL context is destroyed.
+     */
+    static void release();
+
+    /**
+     * @returns Name of a global (e.g. a uniform) of the stage at the given index within the fused program.
+     */
+    [[nodiscard]] static std::string getStageName(const std::string& name, std::size_t stage);
+private:
+    /**
+     * @brief Generate the fused fragment shader code.
+     * @param texcoord Vertex shader output holding the screen quad's texture coordinate, as "Block.member" for block
+     * members (or empty if there is none).
+     * @returns true if successful, otherwise false if any stage uses something which cannot be fused.
+     */
+    [[nodiscard]] static bool generate(const std::vector<Stage>& stages, const std::string& texcoord,
+                                       std::string& fragCode);
+
+    /**
+     * @brief Programs already built, keyed by their source (including those which failed to compile, so they are not
+     * retried).
+     */
+    static std::unordered_map<std::string, std::unique_ptr<Shader>> sPrograms;
+};
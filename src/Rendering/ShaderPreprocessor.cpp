@@ -0,0 +1,248 @@
+#include "ShaderPreprocessor.h"
+
+#include "Shader.h"
+
+#include "../Utils/SerializationUtils.h"
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <system_error>
+
+std::filesystem::path ShaderPreprocessor::sIncludeDirectory{};
+
+std::unordered_map<std::string, ShaderPreprocessor::IncludeFile> ShaderPreprocessor::sIncludes{};
+std::unordered_map<std::string, ShaderPreprocessor::CacheEntry> ShaderPreprocessor::sResults{};
+std::unordered_map<std::string, std::weak_ptr<Shader>> ShaderPreprocessor::sPrograms{};
+
+std::chrono::steady_clock::time_point ShaderPreprocessor::sLastCheck{};
+unsigned int ShaderPreprocessor::sRevision = 0;
+
+/**
+ * @returns line with any leading whitespace removed.
+ */
+static std::string_view trimLeading(std::string_view line) {
+    const size_t start = line.find_first_not_of(" \t");
+    return start == std::string_view::npos ? std::string_view() : line.substr(start);
+}
+
+/**
+ * @returns true if line is the preprocessor directive named directive (e.g. "include" for "#  include <...>"), in
+ * which case arguments is set to everything following the directive name.
+ */
+static bool parseDirective(std::string_view line, std::string_view directive, std::string_view& arguments) {
+    line = trimLeading(line);
+    if (line.empty() || line[0] != '#')
+        return false;
+    line = trimLeading(line.substr(1));
+    if (line.substr(0, directive.size()) != directive)
+        return false;
+    arguments = line.substr(directive.size());
+    if (!arguments.empty() && arguments[0] != ' ' && arguments[0] != '\t' && arguments[0] != '"' && arguments[0] != '<'
+        && arguments[0] != '\r')
+        return false;
+    arguments = trimLeading(arguments);
+    return true;
+}
+
+void ShaderPreprocessor::setIncludeDirectory(const std::filesystem::path& directory) {
+    sIncludeDirectory = directory;
+}
+
+const ShaderPreprocessor::Result& ShaderPreprocessor::preprocess(const std::string& code,
+                                                                 const std::filesystem::path& filepath,
+                                                                 const defines_t& defines) {
+    std::string key = filepath.lexically_normal().generic_string();
+    for (const auto& define : defines)
+        key.append("\n").append(define.first).append(" ").append(define.second);
+
+    const std::size_t sourceHash = std::hash<std::string>{}(code);
+    CacheEntry& entry = sResults[key];
+    if (entry.sourceHash == sourceHash && entry.result.hash != 0)
+        return entry.result;
+
+    entry.sourceHash = sourceHash;
+    entry.result = Result();
+    Result& result = entry.result;
+
+    // Defines go after #version (which must come first), followed by a #line to restore the original numbering
+    size_t bodyStart = 0;
+    int bodyLine = 1;
+    for (size_t lineStart = 0; lineStart < code.size(); bodyLine++) {
+        size_t lineEnd = code.find('\n', lineStart);
+        lineEnd = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
+        std::string_view arguments;
+        if (parseDirective(std::string_view(code).substr(lineStart, lineEnd - lineStart), "version", arguments)) {
+            bodyStart = lineEnd;
+            bodyLine++;
+            break;
+        }
+        lineStart = lineEnd;
+    }
+    if (bodyStart == 0)
+        bodyLine = 1;
+
+    result.code.reserve(code.size());
+    result.code.append(code, 0, bodyStart);
+    if (bodyStart > 0 && result.code.back() != '\n')
+        result.code.push_back('\n');
+    for (const auto& define : defines)
+        result.code.append("#define ").append(define.first).append(" ").append(define.second).append("\n");
+    result.code.append("#line ").append(std::to_string(bodyLine)).append(" 0\n");
+
+    ExpandState state{result, {filepath.lexically_normal()}};
+    expand(code.substr(bodyStart), filepath, 0, bodyLine, state);
+
+    if (!result.isValid()) {
+        result.code.clear();
+        // Retry failures on the next call, as they may be caused by a file which does not exist yet
+        entry.sourceHash = 0;
+    }
+    result.hash = std::max(std::hash<std::string>{}(result.code), (std::size_t)1);
+    return result;
+}
+
+std::shared_ptr<Shader> ShaderPreprocessor::getProgram(const std::string& vertCode, const std::string& fragCode,
+                                                       const std::string& tescCode, const std::string& teseCode,
+                                                       const std::string& geomCode) {
+    std::string key;
+    key.reserve(vertCode.size() + fragCode.size() + tescCode.size() + teseCode.size() + geomCode.size() + 5);
+    for (const std::string* code : {&vertCode, &fragCode, &tescCode, &teseCode, &geomCode})
+        key.append(*code).push_back('\0');
+
+    std::weak_ptr<Shader>& entry = sPrograms[key];
+    if (std::shared_ptr<Shader> program = entry.lock())
+        return program;
+
+    std::shared_ptr<Shader> program = std::make_shared<Shader>(vertCode, fragCode, tescCode, teseCode, geomCode);
+    entry = program;
+
+    std::erase_if(sPrograms, [](const auto& program) { return program.second.expired(); });
+    return program;
+}
+
+bool ShaderPreprocessor::checkForChanges() {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - sLastCheck < cCHECK_INTERVAL)
+        return false;
+    sLastCheck = now;
+
+    std::vector<std::string> changed;
+    for (const auto& include : sIncludes) {
+        std::error_code error;
+        const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(include.first, error);
+        if (error || writeTime != include.second.writeTime)
+            changed.push_back(include.first);
+    }
+    if (changed.empty())
+        return false;
+
+    for (const std::string& filepath : changed)
+        sIncludes.erase(filepath);
+    std::erase_if(sResults, [&changed](const auto& entry) {
+        const std::vector<std::filesystem::path>& includes = entry.second.result.includes;
+        return std::any_of(includes.begin(), includes.end(), [&changed](const std::filesystem::path& include) {
+            return std::find(changed.begin(), changed.end(), include.generic_string()) != changed.end();
+        });
+    });
+
+    sRevision++;
+    return true;
+}
+
+void ShaderPreprocessor::expand(const std::string& code, const std::filesystem::path& filepath, int sourceIndex,
+                                int firstLine, ExpandState& state) {
+    Result& result = state.result;
+
+    int lineNumber = firstLine;
+    for (size_t lineStart = 0; lineStart < code.size() && result.isValid(); lineNumber++) {
+        size_t lineEnd = code.find('\n', lineStart);
+        lineEnd = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
+        const std::string_view line = std::string_view(code).substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd;
+
+        std::string_view arguments;
+        if (parseDirective(line, "pragma", arguments) && arguments.substr(0, 4) == "once") {
+            result.code.push_back('\n');
+            continue;
+        }
+        if (!parseDirective(line, "include", arguments)) {
+            result.code.append(line);
+            if (line.back() != '\n')
+                result.code.push_back('\n');
+            continue;
+        }
+
+        const std::string location = filepath.empty() ? std::string("<source>") : filepath.generic_string();
+        const char close = arguments.empty() ? '\0' : arguments[0] == '"' ? '"' : arguments[0] == '<' ? '>' : '\0';
+        const size_t nameEnd = close == '\0' ? std::string_view::npos : arguments.find(close, 1);
+        if (nameEnd == std::string_view::npos) {
+            result.error = location + "(" + std::to_string(lineNumber) + "): Malformed #include";
+            return;
+        }
+
+        const std::string name(arguments.substr(1, nameEnd - 1));
+        const std::filesystem::path includePath = resolveInclude(name, filepath);
+        if (std::find(state.stack.begin(), state.stack.end(), includePath) != state.stack.end()) {
+            result.error = location + "(" + std::to_string(lineNumber) + "): Recursive #include \"" + name + "\"";
+            return;
+        }
+        const IncludeFile* include = loadInclude(includePath);
+        if (!include) {
+            result.error = location + "(" + std::to_string(lineNumber) + "): Cannot open #include \"" + name + "\"";
+            return;
+        }
+
+        auto existing = std::find(result.includes.begin(), result.includes.end(), includePath);
+        if (existing != result.includes.end() && include->isOnce) {
+            result.code.push_back('\n');
+            continue;
+        }
+        const int includeIndex = existing != result.includes.end() ? (int)(existing - result.includes.begin()) + 1 :
+                                                                     (int)result.includes.size() + 1;
+        if (existing == result.includes.end())
+            result.includes.push_back(includePath);
+
+        result.code.append("#line 1 ").append(std::to_string(includeIndex)).append("\n");
+        state.stack.push_back(includePath);
+        expand(include->code, includePath, includeIndex, 1, state);
+        state.stack.pop_back();
+        result.code.append("#line ").append(std::to_string(lineNumber + 1)).append(" ")
+                   .append(std::to_string(sourceIndex)).append("\n");
+    }
+}
+
+const ShaderPreprocessor::IncludeFile* ShaderPreprocessor::loadInclude(const std::filesystem::path& filepath) {
+    const std::string key = filepath.generic_string();
+    auto include = sIncludes.find(key);
+    if (include != sIncludes.end())
+        return &include->second;
+
+    IncludeFile file;
+    std::error_code error;
+    file.writeTime = std::filesystem::last_write_time(filepath, error);
+    if (error || !SerializationUtils::readFile(filepath, file.code))
+        return nullptr;
+
+    for (size_t lineStart = 0; lineStart < file.code.size() && !file.isOnce;) {
+        size_t lineEnd = file.code.find('\n', lineStart);
+        lineEnd = lineEnd == std::string::npos ? file.code.size() : lineEnd + 1;
+        std::string_view arguments;
+        file.isOnce = parseDirective(std::string_view(file.code).substr(lineStart, lineEnd - lineStart), "pragma",
+                                     arguments) && arguments.substr(0, 4) == "once";
+        lineStart = lineEnd;
+    }
+
+    return &sIncludes.emplace(key, std::move(file)).first->second;
+}
+
+std::filesystem::path ShaderPreprocessor::resolveInclude(const std::string& name,
+                                                         const std::filesystem::path& includer) {
+    if (!includer.empty()) {
+        const std::filesystem::path relative = (includer.parent_path() / name).lexically_normal();
+        std::error_code error;
+        if (std::filesystem::is_regular_file(relative, error))
+            return relative;
+    }
+    return (sIncludeDirectory / name).lexically_normal();
+}
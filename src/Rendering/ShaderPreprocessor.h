@@ -0,0 +1,124 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Shader;
+
+/**
+ * @brief Expands #include directives and injects #define sets into GLSL source ahead of compilation, caching the
+ * expanded text of each (source, define-set) variant and sharing the programs built from identical variants.
+ */
+class ShaderPreprocessor {
+public:
+    typedef std::vector<std::pair<std::string, std::string>> defines_t;
+
+    struct Result {
+        /**
+         * @brief Expanded source, or empty if preprocessing failed.
+         */
+        std::string code;
+        std::string error;
+        /**
+         * @brief Every file included (directly or indirectly), in order of first inclusion. The n-th file is
+         * referred to as source string n + 1 by the #line directives in code.
+         */
+        std::vector<std::filesystem::path> includes;
+        /**
+         * @brief Hash of the source, the define set and the contents of every included file.
+         */
+        std::size_t hash = 0;
+
+        [[nodiscard]] inline bool isValid() const {
+            return error.empty();
+        }
+    };
+
+    /**
+     * @brief Set the directory #include paths are resolved against (after the directory of the including file).
+     */
+    static void setIncludeDirectory(const std::filesystem::path& directory);
+
+    /**
+     * @brief Expand code, which was read from filepath (or empty if it has no file), with defines inserted after its
+     * #version directive. Results are cached until one of their includes changes on disk.
+     */
+    [[nodiscard]] static const Result& preprocess(const std::string& code, const std::filesystem::path& filepath,
+                                                  const defines_t& defines);
+
+    /**
+     * @brief Get a program built from the given (expanded) stage sources, sharing the existing program if another
+     * is still alive with identical sources.
+     */
+    [[nodiscard]] static std::shared_ptr<Shader> getProgram(const std::string& vertCode, const std::string& fragCode,
+                                                            const std::string& tescCode = "",
+                                                            const std::string& teseCode = "",
+                                                            const std::string& geomCode = "");
+
+    /**
+     * @brief Check whether any included file has been modified, dropping every cached result that includes it.
+     * Files are checked at most once every cCHECK_INTERVAL, so this may be polled every frame.
+     * @returns true if any file changed, otherwise false.
+     */
+    static bool checkForChanges();
+    /**
+     * @brief Incremented every time checkForChanges() finds a modified file.
+     */
+    [[nodiscard]] static inline unsigned int getRevision() {
+        return sRevision;
+    }
+private:
+    struct IncludeFile {
+        std::string code;
+        std::filesystem::file_time_type writeTime;
+        /**
+         * @brief Marked by #pragma once.
+         */
+        bool isOnce = false;
+    };
+
+    struct CacheEntry {
+        /**
+         * @brief Hash of the unexpanded source the result was built from.
+         */
+        std::size_t sourceHash = 0;
+        Result result;
+    };
+
+    struct ExpandState {
+        Result& result;
+        /**
+         * @brief Files currently being expanded, used to detect recursive includes.
+         */
+        std::vector<std::filesystem::path> stack;
+    };
+
+    /**
+     * @brief Append code to the expanded result, replacing each #include with the contents of the included file.
+     * @param sourceIndex Source string number of the file code was read from.
+     * @param firstLine Line number of the first line of code within that file.
+     */
+    static void expand(const std::string& code, const std::filesystem::path& filepath, int sourceIndex,
+                       int firstLine, ExpandState& state);
+    /**
+     * @returns Cached contents of the file at filepath (read if not already cached), or nullptr if it cannot be read.
+     */
+    [[nodiscard]] static const IncludeFile* loadInclude(const std::filesystem::path& filepath);
+    [[nodiscard]] static std::filesystem::path resolveInclude(const std::string& name,
+                                                              const std::filesystem::path& includer);
+
+    static constexpr std::chrono::milliseconds cCHECK_INTERVAL{500};
+
+    static std::filesystem::path sIncludeDirectory;
+
+    static std::unordered_map<std::string, IncludeFile> sIncludes;
+    static std::unordered_map<std::string, CacheEntry> sResults;
+    static std::unordered_map<std::string, std::weak_ptr<Shader>> sPrograms;
+
+    static std::chrono::steady_clock::time_point sLastCheck;
+    static unsigned int sRevision;
+};
@@ -1,5 +1,8 @@
 #include "Texture.h"
 
+#include "RenderConfig.h"
+#include "TransientTexturePool.h"
+
 #include <glad/glad.h>
 
 GLint parseInternalFormat(Texture::InternalFormat format) {
@@ -331,32 +334,32 @@ Texture::Texture() {
 }
 
 Texture::~Texture() {
+    if (mAlias)
+        TransientTexturePool::forget(*this);
+    RenderConfig::releaseTexture(mTexID);
     glDeleteTextures(1, &mTexID);
 }
 
 void Texture::bind() const {
-    glBindTexture(GL_TEXTURE_2D, mTexID);
+    RenderConfig::bindTexture(getID());
 }
 
 void Texture::bind(int slot) const {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, mTexID);
+    RenderConfig::bindTexture(slot, getID());
 }
 
 void Texture::unbind() {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    RenderConfig::bindTexture(0);
 }
 
 void Texture::resize(int width, int height) {
     mWidth = width;
     mHeight = height;
 
-    Texture::DataFormat dummyFormat;
-    Texture::DataType dummyType;
-    generateDummyTypes(mInternalFormat, dummyFormat, dummyType);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, parseInternalFormat(mInternalFormat), mWidth, mHeight, 0,
-                 parseDataFormat(dummyFormat), parseDataType(dummyType), nullptr);
+    removeAlias();
+    allocateStorage(mWidth, mHeight);
+    if (mIsTransient)
+        TransientTexturePool::invalidate();
     mState = (glIsTexture(mTexID) == GL_TRUE) ? ErrorState::VALID : ErrorState::INVALID;
 }
 
@@ -366,17 +369,77 @@ void Texture::uploadData(void* data, DataFormat dataFormat, DataType dataType) {
 }
 
 void Texture::setFilters(Texture::MinFilter min, Texture::MagFilter mag) {
+    mMinFilter = min;
+    mMagFilter = mag;
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, parseMinFilter(min));
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, parseMagFilter(mag));
 }
 
 void Texture::setEdgeWrap(Texture::EdgeWrap mode) {
+    mEdgeWrap = mode;
     GLfloat edgeWrap = parseEdgeWrap(mode);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, edgeWrap);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, edgeWrap);
 }
 
 void Texture::setCompareMode(CompareMode mode) {
+    mCompareMode = mode;
     GLint compareMode = parseCompareMode(mode);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, compareMode);
 }
+
+void Texture::setTransient(bool isTransient) {
+    if (isTransient != mIsTransient)
+        TransientTexturePool::invalidate();
+    mIsTransient = isTransient;
+    if (!mIsTransient)
+        removeAlias();
+}
+
+void Texture::setAlias(const Texture* physical) {
+    if (physical == mAlias)
+        return;
+
+    // Release this texture's own storage while it is unused, or restore it once the alias is removed
+    RenderConfig::bindTexture(mTexID);
+    allocateStorage(physical ? 0 : mWidth, physical ? 0 : mHeight);
+    mAlias = physical;
+}
+
+void Texture::removeAlias() {
+    if (!mAlias)
+        return;
+    TransientTexturePool::forget(*this);
+    TransientTexturePool::invalidate();
+    setAlias(nullptr);
+}
+
+bool Texture::isCompatible(const Texture& other) const {
+    return mInternalFormat == other.mInternalFormat && mWidth == other.mWidth && mHeight == other.mHeight &&
+           mMinFilter == other.mMinFilter && mMagFilter == other.mMagFilter && mEdgeWrap == other.mEdgeWrap &&
+           mCompareMode == other.mCompareMode;
+}
+
+std::size_t Texture::getMemorySize() const {
+    const auto format = (tex_format_t)mInternalFormat;
+
+    std::size_t texelSize;
+    if (format & (gDCOMP_BIT | gDSTEN_BIT)) {
+        texelSize = 4;
+    } else {
+        const std::size_t numChannels = (format & gR_BIT) ? 1 : (format & gRG_BIT) ? 2 : (format & gRGB_BIT) ? 3 : 4;
+        const std::size_t channelSize = (format & gP32_BIT) ? 4 : (format & gP16_BIT) ? 2 : 1;
+        // Compressed formats are at most one byte per texel
+        texelSize = (format & gCOMPR_BIT) ? 1 : numChannels * channelSize;
+    }
+    return (std::size_t)mWidth * (std::size_t)mHeight * texelSize;
+}
+
+void Texture::allocateStorage(int width, int height) {
+    Texture::DataFormat dummyFormat;
+    Texture::DataType dummyType;
+    generateDummyTypes(mInternalFormat, dummyFormat, dummyType);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, parseInternalFormat(mInternalFormat), width, height, 0,
+                 parseDataFormat(dummyFormat), parseDataType(dummyType), nullptr);
+}
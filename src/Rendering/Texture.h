@@ -1,6 +1,8 @@
 #pragma once
 #include <glm/glm.hpp>
 
+#include <cstddef>
+
 typedef unsigned long long tex_format_t;
 
 static constexpr tex_format_t gR_BIT    = 1 << 0;
@@ -217,8 +219,11 @@ public:
         return mInternalFormat;
     }
 
+    /**
+     * @returns ID of the GL texture this texture's contents live in (which is another texture's if aliased).
+     */
     [[nodiscard]] inline unsigned int getID() const {
-        return mTexID;
+        return mAlias ? mAlias->mTexID : mTexID;
     }
 
     [[nodiscard]] inline int getWidth() const {
@@ -232,11 +237,68 @@ public:
         return mState;
     }
 
-    static void setFilters(MinFilter min, MagFilter mag);
-    static void setEdgeWrap(EdgeWrap mode);
-    static void setCompareMode(CompareMode mode);
+    /**
+     * @brief Set the sampling parameters of this texture, which must be bound.
+     */
+    void setFilters(MinFilter min, MagFilter mag);
+    void setEdgeWrap(EdgeWrap mode);
+    void setCompareMode(CompareMode mode);
+
+    [[nodiscard]] inline MinFilter getMinFilter() const {
+        return mMinFilter;
+    }
+    [[nodiscard]] inline MagFilter getMagFilter() const {
+        return mMagFilter;
+    }
+    [[nodiscard]] inline EdgeWrap getEdgeWrap() const {
+        return mEdgeWrap;
+    }
+    [[nodiscard]] inline CompareMode getCompareMode() const {
+        return mCompareMode;
+    }
+
+    /**
+     * @brief Mark the contents of this texture as only needed within a frame, allowing its storage to be shared with
+     * other transient textures whose lifetimes do not overlap (see TransientTexturePool).
+     */
+    void setTransient(bool isTransient);
+    [[nodiscard]] inline bool isTransient() const {
+        return mIsTransient;
+    }
+
+    /**
+     * @brief Use the storage of physical in place of this texture's own, which is released until the alias is removed
+     * (by passing nullptr). Contents are undefined after either change. Leaves this texture's own ID bound.
+     */
+    void setAlias(const Texture* physical);
+    /**
+     * @brief Stop aliasing any texture allocated by TransientTexturePool, restoring this texture's own storage (and
+     * leaving it bound) until the pool next updates. Resizing a texture does this implicitly.
+     */
+    void removeAlias();
+    [[nodiscard]] inline const Texture* getAlias() const {
+        return mAlias;
+    }
+
+    /**
+     * @returns true if other has the same format, size and sampling parameters, so can stand in for this texture.
+     */
+    [[nodiscard]] bool isCompatible(const Texture& other) const;
+    /**
+     * @returns Estimated size of the texture's storage in bytes (ignoring any alias).
+     */
+    [[nodiscard]] std::size_t getMemorySize() const;
 private:
+    void allocateStorage(int width, int height);
+
     unsigned int mTexID = 0;
+    const Texture* mAlias = nullptr;
+    bool mIsTransient = false;
+
+    MinFilter mMinFilter = MinFilter::Linear;
+    MagFilter mMagFilter = MagFilter::Linear;
+    EdgeWrap mEdgeWrap = EdgeWrap::ClampToEdge;
+    CompareMode mCompareMode = CompareMode::None;
 
     int mWidth  = 1;
     int mHeight = 1;
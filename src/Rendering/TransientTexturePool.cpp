@@ -0,0 +1,158 @@
+#include "TransientTexturePool.h"
+
+#include "CommandBuffer.h"
+#include "Framebuffer.h"
+#include "Texture.h"
+
+#include "../Utils/ProfileUtils.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+std::vector<TransientTexturePool::PhysicalTexture> TransientTexturePool::sPhysical{};
+std::vector<Texture*> TransientTexturePool::sAliased{};
+
+TransientTexturePool::Report TransientTexturePool::sReport{};
+bool TransientTexturePool::sIsStale = false;
+
+static constexpr std::size_t cNEVER = std::numeric_limits<std::size_t>::max();
+
+const TransientTexturePool::Report& TransientTexturePool::allocate(CommandBuffer& commands) {
+    release();
+    sReport = Report();
+
+    std::vector<Lifetime> lifetimes = findLifetimes(commands);
+    std::sort(lifetimes.begin(), lifetimes.end(), [](const Lifetime& a, const Lifetime& b) {
+        return a.firstUse < b.firstUse;
+    });
+
+    for (const Lifetime& lifetime : lifetimes) {
+        if (lifetime.firstWrite == cNEVER)
+            continue;
+
+        Texture& texture = *lifetime.texture;
+        sReport.numRenderTargets++;
+        sReport.memoryBefore += texture.getMemorySize();
+        if (!texture.isTransient() || lifetime.firstRead < lifetime.firstWrite) {
+            sReport.memoryAfter += texture.getMemorySize();
+            continue;
+        }
+
+        // Textures are visited in order of first use, so reusing any physical texture which is free by then is optimal
+        auto physical = std::find_if(sPhysical.begin(), sPhysical.end(), [&](const PhysicalTexture& physical) {
+            return physical.lastUse < lifetime.firstUse && physical.texture->isCompatible(texture);
+        });
+        if (physical == sPhysical.end()) {
+            std::unique_ptr<Texture> pooled = std::make_unique<Texture>();
+            pooled->bind();
+            pooled->setInternalFormat(texture.getInternalFormat());
+            pooled->setFilters(texture.getMinFilter(), texture.getMagFilter());
+            pooled->setEdgeWrap(texture.getEdgeWrap());
+            pooled->setCompareMode(texture.getCompareMode());
+            pooled->resize(texture.getWidth(), texture.getHeight());
+            Texture::unbind();
+
+            sReport.memoryAfter += pooled->getMemorySize();
+            physical = sPhysical.insert(sPhysical.end(), {std::move(pooled), 0});
+        }
+
+        physical->lastUse = lifetime.lastUse;
+        texture.setAlias(physical->texture.get());
+        sAliased.push_back(&texture);
+    }
+    Texture::unbind();
+
+    sReport.numAliased = sAliased.size();
+    sReport.numPhysical = sPhysical.size();
+
+    // Framebuffers hold the IDs of their attachments, so must be updated to use the new storage
+    std::unordered_set<Framebuffer*> framebuffers{};
+    for (const CommandBuffer::Command& command : commands.getCommands())
+        if (command.type == CommandBuffer::CommandType::BindFramebuffer && framebuffers.insert(command.framebuffer).second)
+            command.framebuffer->updateAttachments();
+
+    if (sReport.numRenderTargets > 0) {
+        const auto toMegabytes = [](std::size_t bytes) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.1f MB", (float)bytes / (1024.0f * 1024.0f));
+            return std::string(buffer);
+        };
+        ProfileUtils::setResult("Render Targets",
+                                toMegabytes(sReport.memoryBefore).append(" -> ")
+                                    .append(toMegabytes(sReport.memoryAfter))
+                                    .append(" (").append(std::to_string(sReport.numAliased)).append(" transient on ")
+                                    .append(std::to_string(sReport.numPhysical)).append(" shared)"));
+    }
+    return sReport;
+}
+
+void TransientTexturePool::update(CommandBuffer& commands) {
+    if (sIsStale)
+        allocate(commands);
+}
+
+void TransientTexturePool::forget(const Texture& texture) {
+    sAliased.erase(std::remove(sAliased.begin(), sAliased.end(), &texture), sAliased.end());
+}
+
+void TransientTexturePool::release() {
+    for (Texture* texture : sAliased)
+        texture->setAlias(nullptr);
+    Texture::unbind();
+    sAliased.clear();
+    sPhysical.clear();
+    sIsStale = false;
+}
+
+std::vector<TransientTexturePool::Lifetime> TransientTexturePool::findLifetimes(const CommandBuffer& commands) {
+    const std::vector<CommandBuffer::Command>& commandList = commands.getCommands();
+
+    std::vector<Lifetime> lifetimes{};
+    std::unordered_map<const Texture*, std::size_t> indices{};
+    // Indices of the LoopBegin commands of the loops enclosing the current command, outermost first
+    std::vector<std::size_t> loops{};
+
+    const auto use = [&](Texture* texture, std::size_t index, bool isWrite) {
+        auto [lifetimeIndex, isNew] = indices.try_emplace(texture, lifetimes.size());
+        if (isNew)
+            lifetimes.push_back({texture, cNEVER, 0, cNEVER, cNEVER});
+        Lifetime& lifetime = lifetimes[lifetimeIndex->second];
+
+        const std::size_t first = loops.empty() ? index : loops.front();
+        const std::size_t last = loops.empty() ? index : (std::size_t)commandList[loops.front()].loop.jump;
+        lifetime.firstUse = std::min(lifetime.firstUse, first);
+        lifetime.lastUse = std::max(lifetime.lastUse, last);
+        if (isWrite)
+            lifetime.firstWrite = std::min(lifetime.firstWrite, index);
+        else
+            lifetime.firstRead = std::min(lifetime.firstRead, index);
+    };
+
+    for (std::size_t i = 0; i < commandList.size(); i++) {
+        const CommandBuffer::Command& command = commandList[i];
+        switch (command.type) {
+            case CommandBuffer::CommandType::BindFramebuffer:
+                for (const auto& attachment : command.framebuffer->getAttachments())
+                    use(attachment.first, i, true);
+                break;
+            case CommandBuffer::CommandType::BindTextures: {
+                Texture* const* textures = commands.getTextures(command.textures.first);
+                for (std::uint32_t j = 0; j < command.textures.count; j++)
+                    use(textures[j], i, false);
+                break;
+            }
+            case CommandBuffer::CommandType::LoopBegin:
+                loops.push_back(i);
+                break;
+            case CommandBuffer::CommandType::LoopEnd:
+                loops.pop_back();
+                break;
+            default:
+                break;
+        }
+    }
+    return lifetimes;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class CommandBuffer;
+class Texture;
+
+/**
+ * @brief Shares storage between transient render targets (see Texture::setTransient()) whose lifetimes within a
+ * frame do not overlap.
+ * @brief Lifetimes are found from the commands of a compiled pipeline: a texture is live from the first pass which
+ * draws to it (through a framebuffer attachment) or samples it, to the last. Textures used inside a loop are live for
+ * the whole loop. Each transient texture is then aliased onto a physical texture of the same format, size and
+ * sampling parameters, which is reused by any later texture once the previous one is no longer live.
+ */
+class TransientTexturePool {
+public:
+    struct Report {
+        /**
+         * @brief Textures drawn to by the pipeline.
+         */
+        std::size_t numRenderTargets = 0;
+        std::size_t numAliased = 0;
+        std::size_t numPhysical = 0;
+        /**
+         * @brief Render target memory in bytes without aliasing.
+         */
+        std::size_t memoryBefore = 0;
+        std::size_t memoryAfter = 0;
+    };
+
+    /**
+     * @brief Alias every transient texture used by commands, replacing any aliases set up by a previous call.
+     * @brief Transient textures which are sampled before they are drawn to (and so carry their contents between
+     * frames), or which are never drawn to, keep their own storage.
+     */
+    static const Report& allocate(CommandBuffer& commands);
+    /**
+     * @brief Allocate again for commands if anything has invalidated the current aliases since the last allocate().
+     */
+    static void update(CommandBuffer& commands);
+    /**
+     * @brief Flag the current aliases as out of date, e.g. after a transient texture is resized (which restores its
+     * own storage), so they are rebuilt by the next update().
+     */
+    static inline void invalidate() {
+        sIsStale = true;
+    }
+    /**
+     * @brief Remove every alias and release the pooled textures. Must be called before the GL context is destroyed.
+     */
+    static void release();
+
+    /**
+     * @brief Stop tracking texture, which no longer aliases a pooled texture.
+     */
+    static void forget(const Texture& texture);
+
+    [[nodiscard]] static inline const Report& getReport() {
+        return sReport;
+    }
+private:
+    struct Lifetime {
+        Texture* texture;
+        std::size_t firstUse;
+        std::size_t lastUse;
+        std::size_t firstWrite;
+        std::size_t firstRead;
+    };
+
+    struct PhysicalTexture {
+        std::unique_ptr<Texture> texture;
+        /**
+         * @brief Last use of the latest texture aliased onto this one.
+         */
+        std::size_t lastUse;
+    };
+
+    /**
+     * @returns Start and end (inclusive) of every use of each texture in commands.
+     */
+    [[nodiscard]] static std::vector<Lifetime> findLifetimes(const CommandBuffer& commands);
+
+    static std::vector<PhysicalTexture> sPhysical;
+    static std::vector<Texture*> sAliased;
+
+    static Report sReport;
+    static bool sIsStale;
+};
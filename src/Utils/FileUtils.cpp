@@ -2,6 +2,17 @@
 
 #include <nfd.h>
 
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 std::string parseFilterList(const std::vector<std::string>& filters) {
     std::string filterList;
     for (const std::string& filter : filters) {
@@ -53,3 +64,92 @@ bool FileUtils::openSaveDialog(std::filesystem::path& filepath, const std::files
     free(outPath);
     return true;
 }
+
+bool FileUtils::writeFileAtomic(const std::filesystem::path& filepath, bool binary,
+                                const std::function<void(std::ostream&)>& writer) {
+    std::filesystem::path tempPath = filepath;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream stream(tempPath, binary ? std::ios::out | std::ios::binary : std::ios::out);
+        if (!stream)
+            return false;
+        writer(stream);
+        stream.flush();
+        if (!stream) {
+            stream.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, filepath, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path& filepath) {
+    HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+    mFileHandle = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+        return;
+    mSize = (std::size_t)size.QuadPart;
+    if (mSize == 0) {
+        mIsOpen = true;
+        return;
+    }
+
+    mMappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mMappingHandle)
+        return;
+    mData = (const char*)MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+    mIsOpen = mData != nullptr;
+}
+
+MappedFile::~MappedFile() {
+    if (mData)
+        UnmapViewOfFile(mData);
+    if (mMappingHandle)
+        CloseHandle(mMappingHandle);
+    if (mFileHandle)
+        CloseHandle(mFileHandle);
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path& filepath) {
+    int file = open(filepath.c_str(), O_RDONLY);
+    if (file < 0)
+        return;
+
+    struct stat fileStat{};
+    if (fstat(file, &fileStat) == 0) {
+        mSize = (std::size_t)fileStat.st_size;
+        if (mSize == 0) {
+            mIsOpen = true;
+        } else {
+            void* mapping = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+            if (mapping != MAP_FAILED) {
+                madvise(mapping, mSize, MADV_SEQUENTIAL);
+                mData = (const char*)mapping;
+                mIsOpen = true;
+            }
+        }
+    }
+    close(file);
+}
+
+MappedFile::~MappedFile() {
+    if (mData)
+        munmap((void*)mData, mSize);
+}
+#endif
@@ -1,6 +1,9 @@
 #pragma once
 #include <filesystem>
+#include <functional>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class FileUtils {
@@ -23,4 +26,48 @@ public:
      */
     static bool openSaveDialog(std::filesystem::path& filepath, const std::filesystem::path& defaultLocation,
                                const std::vector<std::string>& filters);
-};
\ No newline at end of file
+
+    /**
+     * @brief Write a file through a temporary file next to it, which is renamed over filepath once complete, so
+     * readers never observe a partially written file.
+     * @param writer Writes the file contents to the given stream.
+     * @return true if the file was written and replaced, otherwise false (leaving any existing file untouched).
+     */
+    static bool writeFileAtomic(const std::filesystem::path& filepath, bool binary,
+                                const std::function<void(std::ostream&)>& writer);
+};
+
+/**
+ * @brief Read-only memory mapping of an entire file, unmapped on destruction.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& filepath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] inline bool isOpen() const {
+        return mIsOpen;
+    }
+
+    [[nodiscard]] inline const char* data() const {
+        return mData;
+    }
+    [[nodiscard]] inline std::size_t size() const {
+        return mSize;
+    }
+    [[nodiscard]] inline std::string_view view() const {
+        return {mData, mSize};
+    }
+private:
+    const char* mData = nullptr;
+    std::size_t mSize = 0;
+    bool mIsOpen = false;
+
+#ifdef _WIN32
+    void* mFileHandle = nullptr;
+    void* mMappingHandle = nullptr;
+#endif
+};
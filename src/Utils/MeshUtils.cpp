@@ -0,0 +1,478 @@
+#include "MeshUtils.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <thread>
+
+static constexpr size_t gMIN_OBJ_CHUNK_SIZE = 1 << 20;
+
+/**
+ * @brief Face corner as read from a single chunk, before its indices are made absolute.
+ * @brief Positive OBJ indices are stored as absolute (0-based) indices. Negative OBJ indices are relative to the end of
+ * the elements read so far, so they are stored relative to the start of the chunk and marked in relativeMask, to be
+ * offset once the number of elements in all earlier chunks is known.
+ */
+struct OBJChunkCorner {
+    int index[3];
+    uint8_t presentMask;
+    uint8_t relativeMask;
+};
+
+struct OBJChunk {
+    std::string_view contents;
+
+    std::vector<glm::vec3> positions{};
+    std::vector<glm::vec2> uvs{};
+    std::vector<glm::vec3> normals{};
+    std::vector<OBJChunkCorner> corners{};
+};
+
+static inline bool isInlineSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipInlineSpace(const char* begin, const char* end) {
+    while (begin < end && isInlineSpace(*begin))
+        begin++;
+    return begin;
+}
+
+template<glm::length_t L>
+static void parseVector(const char* begin, const char* end, glm::vec<L, float>& value) {
+    for (glm::length_t i = 0; i < L; i++) {
+        begin = skipInlineSpace(begin, end);
+        if (begin < end && *begin == '+')
+            begin++;
+        begin = std::from_chars(begin, end, value[i]).ptr;
+    }
+}
+
+/**
+ * @brief Parse a single "v[/vt[/vn]]" face corner, returning the position after it.
+ */
+static const char* parseCorner(const char* begin, const char* end, const size_t (&counts)[3], OBJChunkCorner& corner) {
+    corner = {{0, 0, 0}, 0, 0};
+    for (int i = 0; i < 3 && begin < end; i++) {
+        if (i > 0) {
+            if (*begin != '/')
+                break;
+            begin++;
+        }
+
+        int index;
+        auto [ptr, ec] = std::from_chars(begin, end, index);
+        if (ec != std::errc()) {
+            begin = ptr;
+            continue;
+        }
+        begin = ptr;
+
+        corner.presentMask |= 1 << i;
+        if (index < 0) {
+            corner.index[i] = (int)counts[i] + index;
+            corner.relativeMask |= 1 << i;
+        } else {
+            corner.index[i] = index - 1;
+        }
+    }
+    while (begin < end && !isInlineSpace(*begin))
+        begin++;
+    return begin;
+}
+
+static void parseOBJChunk(OBJChunk& chunk) {
+    std::vector<OBJChunkCorner> face;
+
+    const char* cursor = chunk.contents.data();
+    const char* contentsEnd = cursor + chunk.contents.size();
+    while (cursor < contentsEnd) {
+        const char* lineEnd = std::find(cursor, contentsEnd, '\n');
+        const char* begin = skipInlineSpace(cursor, lineEnd);
+        cursor = lineEnd + (lineEnd < contentsEnd ? 1 : 0);
+
+        if (lineEnd - begin < 2)
+            continue;
+
+        if (begin[0] == 'v' && isInlineSpace(begin[1])) {
+            parseVector(begin + 1, lineEnd, chunk.positions.emplace_back(0.0f));
+        } else if (begin[0] == 'v' && begin[1] == 't') {
+            parseVector(begin + 2, lineEnd, chunk.uvs.emplace_back(0.0f));
+        } else if (begin[0] == 'v' && begin[1] == 'n') {
+            parseVector(begin + 2, lineEnd, chunk.normals.emplace_back(0.0f));
+        } else if (begin[0] == 'f' && isInlineSpace(begin[1])) {
+            const size_t counts[3] = {chunk.positions.size(), chunk.uvs.size(), chunk.normals.size()};
+            face.clear();
+            for (begin = skipInlineSpace(begin + 1, lineEnd); begin < lineEnd;
+                 begin = skipInlineSpace(begin, lineEnd))
+                begin = parseCorner(begin, lineEnd, counts, face.emplace_back());
+
+            for (size_t i = 2; i < face.size(); i++) {
+                chunk.corners.push_back(face[0]);
+                chunk.corners.push_back(face[i - 1]);
+                chunk.corners.push_back(face[i]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Run callback(i) for every i in [0, count), each on its own thread (with i = 0 on the calling thread).
+ */
+static void runParallel(size_t count, const std::function<void(size_t)>& callback) {
+    std::vector<std::thread> workers;
+    workers.reserve(count);
+    for (size_t i = 1; i < count; i++)
+        workers.emplace_back(callback, i);
+    if (count > 0)
+        callback(0);
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void MeshUtils::loadOBJ(std::string_view contents, OBJData& data, unsigned int numThreads) {
+    if (numThreads == 0)
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t numChunks = std::clamp<size_t>(contents.size() / gMIN_OBJ_CHUNK_SIZE, 1, numThreads);
+
+    std::vector<OBJChunk> chunks(numChunks);
+    size_t chunkBegin = 0;
+    for (size_t i = 0; i < numChunks; i++) {
+        size_t chunkEnd = contents.size();
+        if (i + 1 < numChunks) {
+            chunkEnd = contents.find('\n', std::max(chunkBegin, contents.size() * (i + 1) / numChunks));
+            chunkEnd = chunkEnd == std::string_view::npos ? contents.size() : chunkEnd + 1;
+        }
+        chunks[i].contents = contents.substr(chunkBegin, chunkEnd - chunkBegin);
+        chunkBegin = chunkEnd;
+    }
+
+    runParallel(numChunks, [&chunks](size_t i) { parseOBJChunk(chunks[i]); });
+
+    std::vector<size_t> positionOffsets(numChunks), uvOffsets(numChunks), normalOffsets(numChunks);
+    std::vector<size_t> cornerOffsets(numChunks);
+    size_t numPositions = 0, numUVs = 0, numNormals = 0, numCorners = 0;
+    for (size_t i = 0; i < numChunks; i++) {
+        positionOffsets[i] = numPositions;
+        uvOffsets[i]       = numUVs;
+        normalOffsets[i]   = numNormals;
+        cornerOffsets[i]   = numCorners;
+        numPositions += chunks[i].positions.size();
+        numUVs       += chunks[i].uvs.size();
+        numNormals   += chunks[i].normals.size();
+        numCorners   += chunks[i].corners.size();
+    }
+
+    data.positions.resize(numPositions);
+    data.uvs.resize(numUVs);
+    data.normals.resize(numNormals);
+    data.corners.resize(numCorners);
+
+    const size_t counts[3] = {numPositions, numUVs, numNormals};
+    runParallel(numChunks, [&](size_t i) {
+        const OBJChunk& chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), data.positions.begin() + (long)positionOffsets[i]);
+        std::copy(chunk.uvs.begin(), chunk.uvs.end(), data.uvs.begin() + (long)uvOffsets[i]);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), data.normals.begin() + (long)normalOffsets[i]);
+
+        const size_t offsets[3] = {positionOffsets[i], uvOffsets[i], normalOffsets[i]};
+        OBJCorner* out = data.corners.data() + cornerOffsets[i];
+        for (const OBJChunkCorner& corner : chunk.corners) {
+            int indices[3];
+            for (int j = 0; j < 3; j++) {
+                long long index = corner.index[j];
+                if (corner.relativeMask & (1 << j))
+                    index += (long long)offsets[j];
+                indices[j] = (corner.presentMask & (1 << j)) && index >= 0 && index < (long long)counts[j] ?
+                    (int)index : -1;
+            }
+            *out++ = {indices[0], indices[1], indices[2]};
+        }
+    });
+}
+
+static inline uint32_t hashCorner(const MeshUtils::OBJCorner& corner) {
+    uint64_t hash = (uint32_t)corner.position * 0x9E3779B97F4A7C15ull;
+    hash ^= ((uint32_t)corner.uv + 0x632BE59BD9B4E019ull + (hash << 6) + (hash >> 2)) * 0xC2B2AE3D27D4EB4Full;
+    hash ^= ((uint32_t)corner.normal + 0x165667B19E3779F9ull + (hash << 6) + (hash >> 2)) * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+void MeshUtils::weldCorners(const std::vector<OBJCorner>& corners, std::vector<OBJCorner>& vertices,
+                            std::vector<unsigned int>& indices) {
+    static constexpr unsigned int cEMPTY = std::numeric_limits<unsigned int>::max();
+
+    // Open addressing with linear probing, kept at most half full. Slots hold indices into vertices.
+    std::vector<unsigned int> table(std::bit_ceil(std::max<size_t>(corners.size() * 2, 16)), cEMPTY);
+    const size_t mask = table.size() - 1;
+
+    vertices.clear();
+    indices.resize(corners.size());
+    for (size_t i = 0; i < corners.size(); i++) {
+        const OBJCorner& corner = corners[i];
+        size_t slot = hashCorner(corner) & mask;
+        while (true) {
+            unsigned int& entry = table[slot];
+            if (entry == cEMPTY) {
+                entry = (unsigned int)vertices.size();
+                vertices.push_back(corner);
+                break;
+            }
+            const OBJCorner& other = vertices[entry];
+            if (other.position == corner.position && other.uv == corner.uv && other.normal == corner.normal)
+                break;
+            slot = (slot + 1) & mask;
+        }
+        indices[i] = table[slot];
+    }
+}
+
+MeshUtils::VertexCacheStats MeshUtils::analyzeVertexCache(const std::vector<unsigned int>& indices,
+                                                          std::size_t numVertices, unsigned int cacheSize) {
+    VertexCacheStats stats{};
+    if (indices.size() < 3 || numVertices == 0)
+        return stats;
+
+    // Timestamp of the miss which last loaded each vertex; a vertex is cached if it was loaded within the last
+    // cacheSize misses
+    std::vector<size_t> loadedAt(numVertices, 0);
+    std::vector<bool> isReferenced(numVertices, false);
+    size_t numMisses = 0, numReferenced = 0;
+    for (unsigned int index : indices) {
+        if (index >= numVertices)
+            continue;
+        if (!isReferenced[index]) {
+            isReferenced[index] = true;
+            numReferenced++;
+        }
+        if (loadedAt[index] == 0 || numMisses + 1 - loadedAt[index] > cacheSize)
+            loadedAt[index] = ++numMisses;
+    }
+
+    stats.acmr = (float)numMisses / (float)(indices.size() / 3);
+    stats.atvr = (float)numMisses / (float)std::max<size_t>(numReferenced, 1);
+    return stats;
+}
+
+static constexpr unsigned int gFORSYTH_CACHE_SIZE = 32;
+static constexpr unsigned int gFORSYTH_MAX_VALENCE = 64;
+
+/**
+ * @brief Forsyth vertex score, from the vertex's position in the simulated LRU cache (-1 if not cached) and its number
+ * of remaining triangles.
+ */
+static float forsythScore(int cachePosition, unsigned int numRemaining) {
+    static const auto cScoreTable = []() {
+        constexpr float cCACHE_DECAY_POWER = 1.5f;
+        constexpr float cLAST_TRI_SCORE = 0.75f;
+        constexpr float cVALENCE_BOOST_SCALE = 2.0f;
+        constexpr float cVALENCE_BOOST_POWER = 0.5f;
+
+        struct {
+            float cache[gFORSYTH_CACHE_SIZE + 1];
+            float valence[gFORSYTH_MAX_VALENCE + 1];
+        } table{};
+        for (unsigned int i = 0; i < gFORSYTH_CACHE_SIZE; i++)
+            table.cache[i + 1] = i < 3 ? cLAST_TRI_SCORE :
+                std::pow(1.0f - (float)(i - 3) / (float)(gFORSYTH_CACHE_SIZE - 3), cCACHE_DECAY_POWER);
+        for (unsigned int i = 1; i <= gFORSYTH_MAX_VALENCE; i++)
+            table.valence[i] = cVALENCE_BOOST_SCALE * std::pow((float)i, -cVALENCE_BOOST_POWER);
+        return table;
+    }();
+
+    if (numRemaining == 0)
+        return -1.0f;
+    return cScoreTable.cache[cachePosition + 1] + cScoreTable.valence[std::min(numRemaining, gFORSYTH_MAX_VALENCE)];
+}
+
+void MeshUtils::optimizeVertexCache(std::vector<unsigned int>& indices, std::size_t numVertices) {
+    const size_t numTriangles = indices.size() / 3;
+    if (numTriangles == 0)
+        return;
+
+    // Vertex -> triangle adjacency, as offsets into a single flat list
+    std::vector<unsigned int> adjacencyOffsets(numVertices + 1, 0);
+    for (size_t i = 0; i < numTriangles * 3; i++)
+        adjacencyOffsets[indices[i] + 1]++;
+    std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+    std::vector<unsigned int> adjacency(numTriangles * 3);
+    std::vector<unsigned int> numRemaining(numVertices, 0);
+    for (size_t i = 0; i < numTriangles * 3; i++) {
+        unsigned int vertex = indices[i];
+        adjacency[adjacencyOffsets[vertex] + numRemaining[vertex]++] = (unsigned int)(i / 3);
+    }
+
+    std::vector<int> cachePositions(numVertices, -1);
+    std::vector<float> vertexScores(numVertices);
+    for (size_t i = 0; i < numVertices; i++)
+        vertexScores[i] = forsythScore(-1, numRemaining[i]);
+
+    std::vector<float> triangleScores(numTriangles);
+    for (size_t i = 0; i < numTriangles; i++)
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] +
+                            vertexScores[indices[i * 3 + 2]];
+
+    std::vector<bool> isEmitted(numTriangles, false);
+    std::vector<unsigned int> output;
+    output.reserve(numTriangles * 3);
+
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(gFORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(gFORSYTH_CACHE_SIZE + 3);
+
+    size_t nextUnemitted = 0;
+    long bestTriangle = 0;
+    for (size_t numEmitted = 0; numEmitted < numTriangles; numEmitted++) {
+        if (bestTriangle < 0) {
+            while (isEmitted[nextUnemitted])
+                nextUnemitted++;
+            bestTriangle = (long)nextUnemitted;
+        }
+
+        const unsigned int* triangle = &indices[bestTriangle * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        isEmitted[bestTriangle] = true;
+
+        // Move the triangle's vertices to the front of the LRU cache, and remove the triangle from their adjacency
+        nextCache.assign(triangle, triangle + 3);
+        for (int i = 0; i < 3; i++) {
+            unsigned int vertex = triangle[i];
+            unsigned int* begin = &adjacency[adjacencyOffsets[vertex]];
+            unsigned int* end = begin + numRemaining[vertex];
+            *std::find(begin, end, (unsigned int)bestTriangle) = *(end - 1);
+            numRemaining[vertex]--;
+        }
+        for (unsigned int vertex : cache)
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                nextCache.push_back(vertex);
+        std::swap(cache, nextCache);
+
+        // Rescore every vertex whose cache position changed (including any pushed out of the cache), and the
+        // triangles using them, picking the best candidate triangle from those in the process
+        float bestScore = -1.0f;
+        bestTriangle = -1;
+        for (size_t i = 0; i < cache.size(); i++) {
+            unsigned int vertex = cache[i];
+            int position = i < gFORSYTH_CACHE_SIZE ? (int)i : -1;
+            cachePositions[vertex] = position;
+
+            float score = forsythScore(position, numRemaining[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            const unsigned int* begin = &adjacency[adjacencyOffsets[vertex]];
+            for (const unsigned int* it = begin; it != begin + numRemaining[vertex]; it++) {
+                triangleScores[*it] += delta;
+                if (position >= 0 && triangleScores[*it] > bestScore) {
+                    bestScore = triangleScores[*it];
+                    bestTriangle = (long)*it;
+                }
+            }
+        }
+        if (cache.size() > gFORSYTH_CACHE_SIZE)
+            cache.resize(gFORSYTH_CACHE_SIZE);
+    }
+
+    indices = std::move(output);
+}
+
+void MeshUtils::optimizeOverdraw(std::vector<unsigned int>& indices, const glm::vec3* positions,
+                                 std::size_t numVertices, float threshold) {
+    static constexpr unsigned int cCACHE_SIZE = 16;
+
+    const size_t numTriangles = indices.size() / 3;
+    if (numTriangles == 0)
+        return;
+
+    // Cluster boundaries are placed wherever a triangle misses on all of its vertices (so the cache is effectively
+    // reset there anyway), or where the cluster so far has a low enough ACMR that breaking the sequence is cheap
+    const float targetACMR = analyzeVertexCache(indices, numVertices, cCACHE_SIZE).acmr * threshold;
+    std::vector<size_t> clusterOffsets{0};
+    {
+        std::vector<size_t> loadedAt(numVertices, 0);
+        size_t numMisses = 0, clusterMisses = 0, clusterBegin = 0;
+        for (size_t i = 0; i < numTriangles; i++) {
+            unsigned int triangleMisses = 0;
+            for (int j = 0; j < 3; j++) {
+                unsigned int vertex = indices[i * 3 + j];
+                if (loadedAt[vertex] == 0 || numMisses + 1 - loadedAt[vertex] > cCACHE_SIZE) {
+                    loadedAt[vertex] = ++numMisses;
+                    triangleMisses++;
+                }
+            }
+            bool isHardBoundary = triangleMisses == 3 && i > clusterBegin;
+            bool isSoftBoundary = i > clusterBegin &&
+                (float)clusterMisses / (float)(i - clusterBegin) <= targetACMR && triangleMisses >= 2;
+            if (isHardBoundary || isSoftBoundary) {
+                clusterOffsets.push_back(i);
+                clusterBegin = i;
+                clusterMisses = 0;
+            }
+            clusterMisses += triangleMisses;
+        }
+        clusterOffsets.push_back(numTriangles);
+    }
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCentroids(clusterOffsets.size() - 1);
+    std::vector<glm::vec3> clusterNormals(clusterOffsets.size() - 1);
+    for (size_t c = 0; c + 1 < clusterOffsets.size(); c++) {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t i = clusterOffsets[c]; i < clusterOffsets[c + 1]; i++) {
+            const glm::vec3& a = positions[indices[i * 3]];
+            const glm::vec3& b = positions[indices[i * 3 + 1]];
+            const glm::vec3& d = positions[indices[i * 3 + 2]];
+            glm::vec3 cross = glm::cross(b - a, d - a);
+            float triangleArea = glm::length(cross);
+            centroid += (a + b + d) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        clusterCentroids[c] = area > 0.0f ? centroid / area : centroid;
+        clusterNormals[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    std::vector<float> clusterSortKeys(clusterCentroids.size());
+    for (size_t c = 0; c < clusterCentroids.size(); c++)
+        clusterSortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+
+    std::vector<size_t> clusterOrder(clusterCentroids.size());
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+                     [&clusterSortKeys](size_t a, size_t b) { return clusterSortKeys[a] > clusterSortKeys[b]; });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (size_t c : clusterOrder)
+        output.insert(output.end(), indices.begin() + (long)clusterOffsets[c] * 3,
+                      indices.begin() + (long)clusterOffsets[c + 1] * 3);
+    output.insert(output.end(), indices.begin() + (long)numTriangles * 3, indices.end());
+    indices = std::move(output);
+}
+
+std::vector<unsigned int> MeshUtils::optimizeVertexFetch(std::vector<unsigned int>& indices, std::size_t numVertices) {
+    static constexpr unsigned int cUNASSIGNED = std::numeric_limits<unsigned int>::max();
+
+    std::vector<unsigned int> remap(numVertices, cUNASSIGNED);
+    unsigned int nextIndex = 0;
+    for (unsigned int& index : indices) {
+        if (remap[index] == cUNASSIGNED)
+            remap[index] = nextIndex++;
+        index = remap[index];
+    }
+    for (unsigned int& index : remap)
+        if (index == cUNASSIGNED)
+            index = nextIndex++;
+    return remap;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <string_view>
+#include <vector>
+
+class MeshUtils {
+public:
+    /**
+     * @brief Indices (into OBJData::positions/uvs/normals) of a single face corner, or -1 where the corner does not
+     * reference that component.
+     */
+    struct OBJCorner {
+        int position;
+        int uv;
+        int normal;
+    };
+
+    /**
+     * @brief Raw (un-welded) contents of an OBJ file. Faces are triangulated, so every three corners form a triangle.
+     */
+    struct OBJData {
+        std::vector<glm::vec3> positions{};
+        std::vector<glm::vec2> uvs{};
+        std::vector<glm::vec3> normals{};
+        std::vector<OBJCorner> corners{};
+    };
+
+    /**
+     * @brief Parse OBJ contents, split into line-aligned chunks which are parsed in parallel and then merged.
+     * @brief Only v, vt, vn and f statements are read. Polygonal faces are fan triangulated.
+     *
+     * @param numThreads Maximum number of worker threads, or 0 to use the number of hardware threads. Small inputs are
+     * always parsed on the calling thread.
+     */
+    static void loadOBJ(std::string_view contents, OBJData& data, unsigned int numThreads = 0);
+    /**
+     * @brief Merge corners referencing the same position/uv/normal triplet into a single vertex.
+     *
+     * @param corners  Triangulated face corners, as read by loadOBJ().
+     * @param vertices Output list of unique corners, in order of first use.
+     * @param indices  Output index buffer (one index into vertices per corner).
+     */
+    static void weldCorners(const std::vector<OBJCorner>& corners, std::vector<OBJCorner>& vertices,
+                            std::vector<unsigned int>& indices);
+
+    /**
+     * @brief Post-transform vertex cache statistics of a triangle list, simulated with a FIFO cache.
+     */
+    struct VertexCacheStats {
+        /**
+         * @brief Average cache miss ratio: transformed vertices per triangle (0.5 is optimal, 3.0 is worst case).
+         */
+        float acmr = 0.0f;
+        /**
+         * @brief Average transform to vertex ratio: transformed vertices per referenced vertex (1.0 is optimal).
+         */
+        float atvr = 0.0f;
+    };
+
+    [[nodiscard]] static VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices,
+                                                             std::size_t numVertices, unsigned int cacheSize = 16);
+
+    /**
+     * @brief Reorder triangles for post-transform vertex cache reuse (Forsyth's linear-speed vertex cache
+     * optimisation).
+     */
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, std::size_t numVertices);
+    /**
+     * @brief Split a cache-optimized triangle list into clusters (without raising ACMR above threshold times its
+     * current value), and sort the clusters outermost-facing first so that nearer surfaces tend to be drawn first.
+     */
+    static void optimizeOverdraw(std::vector<unsigned int>& indices, const glm::vec3* positions,
+                                 std::size_t numVertices, float threshold = 1.05f);
+    /**
+     * @brief Renumber vertices in order of first use, so vertex fetches walk memory linearly. Unreferenced vertices are
+     * moved to the end.
+     * @returns Remap table, such that the vertex at index i moves to remap[i]. Indices are remapped in place.
+     */
+    static std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, std::size_t numVertices);
+};
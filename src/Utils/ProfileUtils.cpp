@@ -0,0 +1,26 @@
+#include "ProfileUtils.h"
+
+#include <algorithm>
+#include <cstdio>
+
+std::vector<std::pair<std::string, std::string>> ProfileUtils::sResults{};
+
+void ProfileUtils::setResult(const std::string& label, const std::string& result) {
+    auto match = std::find_if(sResults.begin(), sResults.end(), [&label](const auto& other) {
+        return other.first == label;
+    });
+    if (match == sResults.end())
+        sResults.emplace_back(label, result);
+    else
+        match->second = result;
+}
+
+void ProfileUtils::clearResults() {
+    sResults.clear();
+}
+
+std::string ProfileUtils::formatTime(milliseconds_t time) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f ms", time.count());
+    return buffer;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+class ProfileUtils {
+public:
+    typedef std::chrono::duration<float, std::milli> milliseconds_t;
+
+    /**
+     * @brief Set a named profiling result to be displayed in the debug window.
+     * @brief Replaces any existing result with the same label.
+     */
+    static void setResult(const std::string& label, const std::string& result);
+    static void clearResults();
+
+    [[nodiscard]] static inline const std::vector<std::pair<std::string, std::string>>& getResults() {
+        return sResults;
+    }
+
+    /**
+     * @returns Wall-clock time taken to run callback.
+     */
+    template<typename F>
+    [[nodiscard]] static milliseconds_t time(F&& callback) {
+        auto begin = std::chrono::steady_clock::now();
+        callback();
+        return std::chrono::steady_clock::now() - begin;
+    }
+
+    [[nodiscard]] static std::string formatTime(milliseconds_t time);
+private:
+    static std::vector<std::pair<std::string, std::string>> sResults;
+};
@@ -1,5 +1,6 @@
 #include "SerializationUtils.h"
 
+#include <algorithm>
 #include <fstream>
 
 static constexpr char gMARK_PREFIX = '$';
@@ -23,69 +24,40 @@ void SerializationUtils::writeEndMark(std::ostream& stream, const std::string& i
     writeRawMark(stream, id + gMARK_END_SUFFIX);
 }
 
-bool SerializationUtils::seekNextDataPoint(std::istream& stream, std::streampos end, char dataPrefix, std::string& dataID) {
-    while (stream.tellg() < end && !stream.eof()) {
-        char prefix;
-        stream >> prefix;
-        if (prefix == dataPrefix) {
-            stream >> dataID;
-            return true;
-        }
-
-        skipToNextLine(stream);
-    }
-
-    return false;
-}
+void SerializationUtils::tokenize(std::string_view contents, std::vector<Token>& tokens) {
+    static constexpr std::string_view cWHITESPACE = " \t\r\n\v\f";
+    static constexpr std::string_view cINLINE_WHITESPACE = " \t";
 
-bool SerializationUtils::findNextRawMark(std::istream& stream, std::streampos end,
-                                         const std::string& markID, std::streampos& markPos) {
-    std::streampos start = stream.tellg();
-
-    std::streampos current;
-    while ((current = stream.tellg()) < end && !stream.eof()) {
-        char prefix;
-        stream >> std::ws >> prefix;
-        if (prefix != gMARK_PREFIX) {
-            skipToNextLine(stream);
-            continue;
-        }
+    size_t lineBegin = 0;
+    while (lineBegin < contents.size()) {
+        size_t lineEnd = contents.find('\n', lineBegin);
+        if (lineEnd == std::string_view::npos)
+            lineEnd = contents.size();
+        std::string_view line = contents.substr(lineBegin, lineEnd - lineBegin);
+        lineBegin = lineEnd + 1;
 
-        std::string searchMarkID;
-        stream >> searchMarkID;
-        if (searchMarkID != markID) {
-            skipToNextLine(stream);
+        size_t prefixPos = line.find_first_not_of(cWHITESPACE);
+        if (prefixPos == std::string_view::npos)
             continue;
-        }
 
-        markPos = current;
+        size_t idEnd = std::min(line.find_first_of(cWHITESPACE, prefixPos + 1), line.size());
+        size_t dataBegin = std::min(line.find_first_not_of(cINLINE_WHITESPACE, idEnd), line.size());
+        std::string_view data = line.substr(dataBegin);
+        if (!data.empty() && data.back() == '\r')
+            data.remove_suffix(1);
 
-        stream.seekg(start);
-        return true;
+        tokens.push_back({line[prefixPos], line.substr(prefixPos + 1, idEnd - prefixPos - 1), data});
     }
-
-    stream.seekg(start);
-    return false;
 }
 
-bool SerializationUtils::findNextMarkPair(std::istream& stream, std::streampos end,
-                                          const std::string& markID, std::streampos& beginPos, std::streampos& endPos) {
-    std::streampos start = stream.tellg();
-
-    std::streampos tempBeginPos;
-    if (!findNextRawMark(stream, end, markID + gMARK_BEGIN_SUFFIX, tempBeginPos))
-        return false;
-
-    stream.seekg(tempBeginPos);
-    std::streampos tempEndPos;
-    if (!findNextRawMark(stream, end, markID + gMARK_END_SUFFIX, tempEndPos))
-        return false;
-
-    beginPos = tempBeginPos;
-    endPos = tempEndPos;
+bool SerializationUtils::isBeginMark(const Token& token, std::string_view id) {
+    return token.prefix == gMARK_PREFIX && token.id.starts_with(id) &&
+           token.id.substr(id.size()) == gMARK_BEGIN_SUFFIX;
+}
 
-    stream.seekg(start);
-    return true;
+bool SerializationUtils::isEndMark(const Token& token, std::string_view id) {
+    return token.prefix == gMARK_PREFIX && token.id.starts_with(id) &&
+           token.id.substr(id.size()) == gMARK_END_SUFFIX;
 }
 
 std::streampos SerializationUtils::findEnd(std::istream& stream) {
@@ -125,6 +97,53 @@ bool SerializationUtils::readFile(const std::filesystem::path& filepath, std::st
     return true;
 }
 
+bool SerializationUtils::readStream(std::istream& stream, std::string& contents) {
+    std::streampos begin = stream.tellg();
+    std::streampos end = findEnd(stream);
+    if (!stream || end < begin)
+        return false;
+
+    contents.resize(end - begin);
+    return (bool)stream.read(contents.data(), (std::streamsize)contents.size());
+}
+
+std::string SerializationUtils::serializeData(const std::string& value) {
+    std::string result = "\"";
+    for (char c : value) {
+        switch (c) {
+            case '"'  : result.append("\\\""); break;
+            case '\\' : result.append("\\\\"); break;
+            case '\n' : result.append("\\n"); break;
+            case '\r' : result.append("\\r"); break;
+            default   : result.push_back(c); break;
+        }
+    }
+    result.push_back('"');
+    return result;
+}
+
+void SerializationUtils::deserializeData(std::istream& stream, std::string& value) {
+    value.clear();
+    stream >> std::ws;
+    if (stream.peek() != '"') {
+        stream >> value;
+        return;
+    }
+    stream.get();
+
+    char c;
+    while (stream.get(c) && c != '"') {
+        if (c == '\\' && stream.get(c)) {
+            switch (c) {
+                case 'n' : c = '\n'; break;
+                case 'r' : c = '\r'; break;
+                default  : break;
+            }
+        }
+        value.push_back(c);
+    }
+}
+
 std::filesystem::path SerializationUtils::generateFilename(const std::filesystem::path& directory,
                                                            const std::string& name, const std::string& extension) {
     const std::filesystem::path basePath = directory / name;
@@ -6,9 +6,42 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 class SerializationUtils {
 public:
+    /**
+     * @brief Single serialized line split into its prefix character, ID and (unparsed) data.
+     * @brief Views reference the contents passed to tokenize(), which must outlive the token.
+     */
+    struct Token {
+        char prefix;
+        std::string_view id;
+        std::string_view data;
+    };
+
+    /**
+     * @brief Read-only input stream over an existing block of characters, for parsing token data without first
+     * copying it into a stringstream.
+     */
+    class ViewStream : public std::istream {
+    public:
+        explicit ViewStream(std::string_view view) : std::istream(nullptr), mBuffer(view) {
+            rdbuf(&mBuffer);
+        }
+    private:
+        class ViewBuffer : public std::streambuf {
+        public:
+            explicit ViewBuffer(std::string_view view) {
+                char* begin = const_cast<char*>(view.data());
+                setg(begin, begin, begin + view.size());
+            }
+        };
+
+        ViewBuffer mBuffer;
+    };
+
     /**
      * @brief Write a serialized data point to the stream.
      *
@@ -36,44 +69,21 @@ public:
     static void writeEndMark(std::ostream& stream, const std::string& id);
 
     /**
-     * @brief Move stream to the position of the next data point with dataPrefix, or end if none is found.
-     *
-     * @param stream     Stream to search in.
-     * @param end        End position to stop searching at.
-     * @param dataPrefix Prefix of the data type being searched for.
-     * @param dataID     Set to the name of the data point on success. Ignored on failure.
+     * @brief Split contents into a flat list of tokens (one per non-empty line) in a single forward pass.
+     * @brief Mark lines produce a token with the mark prefix and the full mark (including Begin/End suffix) as ID.
      *
-     * @return false if no data point is found before end, otherwise true.
+     * @param contents Serialized text to tokenize.
+     * @param tokens   Tokens are appended to this list in the order they appear in contents.
      */
-    static bool seekNextDataPoint(std::istream& stream, std::streampos end, char dataPrefix, std::string& dataID);
+    static void tokenize(std::string_view contents, std::vector<Token>& tokens);
     /**
-     * @brief Find the next mark matching markID.
-     * @brief Stream position will be kept at it's original position by return;
-     *
-     * @param stream     Stream to search in.
-     * @param end        End position to stop searching at.
-     * @param markID     Mark ID to search for.
-     * @param markPos    Set to the position of the mark on success. Ignored on failure.
-     *
-     * @return false if no matching mark is found before end, otherwise true.
+     * @returns true if token is a begin mark with the given ID, otherwise false.
      */
-    static bool findNextRawMark(std::istream& stream, std::streampos end,
-                             const std::string& markID, std::streampos& markPos);
+    [[nodiscard]] static bool isBeginMark(const Token& token, std::string_view id);
     /**
-     * @brief Find the next mark open-close pair matching markID.
-     * @brief Stream position will be kept at it's original position by return;
-     *
-     * @param stream     Stream to search in.
-     * @param end        End positiont o stop searching at.
-     * @param markID     Mark ID to search for.
-     * @param beginPos   Set to the position of the begin mark on success. Ignored on failure.
-     * @param endPos     Set to the position of the end mark on success. Ignored on failure.
-     *
-     * @return false if unable to find both a matching entry and exit mark, otherwise true.
+     * @returns true if token is an end mark with the given ID, otherwise false.
      */
-    static bool findNextMarkPair(std::istream& stream, std::streampos end,
-                                 const std::string& markID,
-                                 std::streampos& beginPos, std::streampos& endPos);
+    [[nodiscard]] static bool isEndMark(const Token& token, std::string_view id);
 
     /**
      * @brief Find the eof position of the stream.
@@ -96,6 +106,12 @@ public:
      * @returns true if read is successful, otherwise false.
      */
     static bool readFile(const std::filesystem::path& filepath, std::string& contents);
+    /**
+     * @brief Read everything from the current stream position to the end of the stream into contents, as a single
+     * block read.
+     * @returns true if read is successful, otherwise false.
+     */
+    static bool readStream(std::istream& stream, std::string& contents);
 
     [[nodiscard]] static std::filesystem::path generateFilename(const std::filesystem::path& directory,
                                                                 const std::string& name, const std::string& extension);
@@ -104,6 +120,10 @@ public:
     [[nodiscard]] static std::string serializeData(T value) {
         return std::to_string(value);
     }
+    /**
+     * @brief Quote value, escaping any quotes, backslashes and line breaks so it stays on a single line.
+     */
+    [[nodiscard]] static std::string serializeData(const std::string& value);
     [[nodiscard]] static std::string serializeData(const std::filesystem::path& value) {
         std::stringstream stream;
         stream << std::filesystem::relative(value);
@@ -130,6 +150,10 @@ public:
     static void deserializeData(std::istream& stream, T& value) {
         stream >> value;
     }
+    /**
+     * @brief Read a string written by serializeData(), or a single whitespace delimited word if it is not quoted.
+     */
+    static void deserializeData(std::istream& stream, std::string& value);
     static void deserializeData(std::istream& stream, std::filesystem::path& value) {
         stream >> value;
     }
@@ -1,6 +1,7 @@
 #pragma once
-#include <any>
+#include <cstddef>
 #include <iostream>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -72,39 +73,38 @@ struct VariantVectorWrapper<std::variant<Ts...>> {
 template<typename T>
 using VectorVariant = typename VariantVectorWrapper<T>::type;
 
-template <typename variant_t, typename... Types>
-struct AnyToVariantWrapper;
-
-template <typename variant_t, typename T, typename... Types>
-struct AnyToVariantWrapper<variant_t, T, Types...> {
-    static variant_t convert(const std::any& any) {
-        if (auto ptr = std::any_cast<T>(&any)) {
-            return variant_t{ *ptr };
-        } else {
-            return AnyToVariantWrapper<variant_t, Types...>::convert(any);
-        }
-    }
-};
-
-template <typename variant_t>
-struct AnyToVariantWrapper<variant_t> {
-    static variant_t convert(const std::any&) {
-        throw std::runtime_error("Unsupported type");
-    }
-};
+/**
+ * @brief Utility for checking whether a type is one of the alternatives of a std::variant.
+ * @code
+ * // Example
+ * typedef std::variant&lt;int, float&gt; my_variant_t;
+ * static_assert(VariantContains&lt;float, my_variant_t&gt;::value);
+ * @endcode
+ */
+template<typename T, typename variant_t>
+struct VariantContains;
+template<typename T, typename... Types>
+struct VariantContains<T, std::variant<Types...>> : std::bool_constant<(std::is_same_v<T, Types> || ...)> {};
 
 /**
- * @brief Cast the given std::any to a std::variant<Types...>.
- * @brief If the real value of any is not one of Types, a <code>std::runtime_error</code> will be thrown.
- * @tparam Types
- * @param any
- * @return
+ * @brief Utility for finding the index of a type within the alternatives of a std::variant (failing to compile if it
+ * is not one of them).
+ * @code
+ * // Example
+ * typedef std::variant&lt;int, float&gt; my_variant_t;
+ * static_assert(VariantIndex&lt;float, my_variant_t&gt;::value == 1);
+ * @endcode
  */
-template <typename... Types>
-std::variant<Types...> anyToVariant(const std::any& any) {
-    return AnyToVariantWrapper<std::variant<Types...>, Types...>::convert(any);
-}
-template <typename... Types>
-std::variant<Types...> anyToVariant(const std::any& any, const std::variant<Types...>&) {
-    return AnyToVariantWrapper<std::variant<Types...>, Types...>::convert(any);
-}
+template<typename T, typename variant_t>
+struct VariantIndex;
+template<typename T, typename... Types>
+struct VariantIndex<T, std::variant<Types...>> {
+    static constexpr std::size_t value = []() {
+        constexpr bool cMATCHES[] = { std::is_same_v<T, Types>... };
+        for (std::size_t i = 0; i < sizeof...(Types); i++)
+            if (cMATCHES[i])
+                return i;
+        return sizeof...(Types);
+    }();
+    static_assert(value < sizeof...(Types), "Type is not an alternative of the variant");
+};
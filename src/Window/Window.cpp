@@ -1,10 +1,15 @@
 #include "Window.h"
 
+#include "../GLSandbox/Analysis.h"
 #include "../GLSandbox/Assets.h"
 #include "../GLSandbox/GLSandboxRenderer.h"
 #include "../GLSandbox/PipelineGraph.h"
 
+#include "../NodeEditor/GraphFormat.h"
+
 #include "../Rendering/RenderConfig.h"
+#include "../Rendering/ShaderFusion.h"
+#include "../Rendering/TransientTexturePool.h"
 
 #include "../Utils/FileUtils.h"
 #include "../Utils/SerializationUtils.h"
@@ -93,6 +98,10 @@ mWidth(width), mHeight(height), mTitle(std::move(title)) {
 Window::~Window() {
     writeConfig();
 
+    // Static GL resources would otherwise outlive the context
+    TransientTexturePool::release();
+    ShaderFusion::release();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
@@ -134,6 +143,8 @@ void Window::mainloop() {
 
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        // ImGui changes GL state directly, so the cached state no longer reflects what is bound
+        RenderConfig::invalidateState();
 
         SDL_GL_SwapWindow(mWindow);
     }
@@ -151,8 +162,8 @@ void Window::handleEvent(SDL_Event &e) {
                 case SDL_WINDOWEVENT_SIZE_CHANGED:
                     mWidth  = e.window.data1;
                     mHeight = e.window.data2;
-                    glViewport(0, 0, mWidth, mHeight);
                     RenderConfig::setDefaultViewport(0, 0, mWidth, mHeight);
+                    RenderConfig::setViewport();
                     break;
             }
             break;
@@ -217,7 +228,8 @@ void Window::drawFileMenu() {
         saveGraph();
     if (ImGui::MenuItem("Save As##MainMenu_File")) {
         if (FileUtils::openSaveDialog(mGraphFilepath, getGraphAssetDirectory(), getValidGraphFileExtensions())) {
-            if (mGraphFilepath.extension() != std::string(".").append(getGraphDefaultExtension())) {
+            if (mGraphFilepath.extension() != std::string(".").append(getGraphDefaultExtension()) &&
+                mGraphFilepath.extension() != std::string(".").append(getGraphBinaryExtension())) {
                 mGraphFilepath += ".";
                 mGraphFilepath += getGraphDefaultExtension();
             }
@@ -225,6 +237,15 @@ void Window::drawFileMenu() {
             saveGraph();
         }
     }
+    if (ImGui::MenuItem("Convert##MainMenu_File")) {
+        std::filesystem::path source;
+        if (FileUtils::openFileDialog(source, getGraphAssetDirectory(), getValidGraphFileExtensions())) {
+            bool binary = !isBinaryGraphFile(source);
+            std::filesystem::path destination = source;
+            destination.replace_extension(binary ? getGraphBinaryExtension() : getGraphDefaultExtension());
+            GraphFormat::convert(source, destination, binary);
+        }
+    }
 
     ImGui::Separator();
 
@@ -256,6 +277,31 @@ void Window::drawAnalysisMenu() {
     if (ImGui::MenuItem("Analyse Iteration"))
         mRenderer->loadAnalysisPipeline(5, 200);
 
+    ImGui::Separator();
+
+    if (ImGui::MenuItem("Profile Link Restore")) {
+        for (std::size_t numNodes : {1250, 2500, 5000})
+            Analysis::profileLinkRestore(*mRenderer, numNodes);
+    }
+    if (ImGui::MenuItem("Profile Graph Interaction")) {
+        for (std::size_t numNodes : {1000, 10000, 100000})
+            Analysis::profileGraphInteraction(*mRenderer, numNodes);
+    }
+    if (ImGui::MenuItem("Profile Graph Memory"))
+        Analysis::profileGraphMemory(*mRenderer, 10000);
+    if (ImGui::MenuItem("Profile Port Values"))
+        Analysis::profilePortValues(1000000);
+    if (ImGui::MenuItem("Profile Graph Formats")) {
+        for (std::size_t numCopies : {1, 100, 1000})
+            Analysis::profileGraphFormats(getGraphAssetDirectory() / "deferred_teapot.graph", numCopies);
+    }
+    if (ImGui::MenuItem("Profile OBJ Import")) {
+        for (std::size_t numFaces : {250000, 1000000})
+            Analysis::profileOBJImport(numFaces);
+    }
+    if (ImGui::MenuItem("Profile Pipeline Submission"))
+        Analysis::profilePipelineSubmission(1000);
+
     ImGui::EndMenu();
 }
 
@@ -290,21 +336,23 @@ void Window::writeConfig() {
 void Window::loadGraph() {
     mRenderer->resetPipeline();
     mGraph->clearNodes();
-    std::ifstream stream(mGraphFilepath, std::ios::in | std::ios::binary);
-    if (stream)
-        mGraph->deserialize(stream);
-    else
+    MappedFile file(mGraphFilepath);
+    if (!file.isOpen() || !mGraph->deserialize(file.view()))
         mGraph->initializeDefault();
     mGraph->markClean();
 }
 
 void Window::saveGraph() const {
-    std::ofstream stream(mGraphFilepath);
+    std::ofstream stream(mGraphFilepath, std::ios::out | std::ios::binary);
     if (stream)
-        mGraph->serialize(stream);
+        mGraph->serialize(stream, isBinaryGraphFile(mGraphFilepath));
     mGraph->markClean();
 }
 
+bool Window::isBinaryGraphFile(const std::filesystem::path& filepath) {
+    return filepath.extension() == std::string(".").append(getGraphBinaryExtension());
+}
+
 std::filesystem::path Window::generateFilename() {
     return SerializationUtils::generateFilename(getGraphAssetDirectory(), "Graph", getGraphDefaultExtension());
 }
@@ -41,6 +41,7 @@ private:
     void loadGraph();
     void saveGraph() const;
 
+    [[nodiscard]] static bool isBinaryGraphFile(const std::filesystem::path& filepath);
     [[nodiscard]] static std::filesystem::path generateFilename();
 
     SDL_Window* mWindow = nullptr;